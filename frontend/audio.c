@@ -58,6 +58,7 @@ audio_file *open_audio_file(char *infile, int samplerate, int channels,
     switch (outputFormat)
     {
     case FAAD_FMT_16BIT:
+    case FAAD_FMT_16BIT_DITHER:
         aufile->bits_per_sample = 16;
         break;
     case FAAD_FMT_24BIT:
@@ -107,6 +108,7 @@ int write_audio_file(audio_file *aufile, void *sample_buffer, int samples, int o
     switch (aufile->outputFormat)
     {
     case FAAD_FMT_16BIT:
+    case FAAD_FMT_16BIT_DITHER:
         return write_audio_16bit(aufile, buf + offset*2, samples);
     case FAAD_FMT_24BIT:
         return write_audio_24bit(aufile, buf + offset*4, samples);
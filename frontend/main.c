@@ -415,6 +415,132 @@ static const char *file_ext[] =
     NULL
 };
 
+/* segment parallel decoding (-P): access units are collected in chunks
+   that the library splits over the threads */
+#define SEGMENT_FRAMES 512 /* frames per thread and chunk */
+
+typedef struct {
+    unsigned char num_segments;
+    unsigned long max_frames;
+    unsigned long num_frames;
+    unsigned long num_decoded;
+    unsigned long next;
+
+    unsigned char *data;
+    unsigned long data_size;
+    unsigned long data_used;
+    unsigned long *offsets;
+    unsigned char **frames;
+    unsigned long *sizes;
+
+    NeAACDecFrameInfo *info;
+    unsigned char *pcm;
+    unsigned long pcm_size;
+    unsigned char *pcm_next;
+    int sample_size;
+} segment_buffer;
+
+static int segment_open(segment_buffer *s, int num_segments, int outputFormat)
+{
+    static const int sample_sizes[] = { 2, 4, 4, 4, 8, 2 };
+
+    memset(s, 0, sizeof(segment_buffer));
+    if (num_segments < 2)
+        return 1;
+
+    s->num_segments = (unsigned char)num_segments;
+    s->max_frames = s->num_segments * SEGMENT_FRAMES;
+    s->sample_size = sample_sizes[outputFormat-1];
+    s->offsets = (unsigned long*)malloc(s->max_frames*sizeof(unsigned long));
+    s->frames = (unsigned char**)malloc(s->max_frames*sizeof(unsigned char*));
+    s->sizes = (unsigned long*)malloc(s->max_frames*sizeof(unsigned long));
+    s->info = (NeAACDecFrameInfo*)malloc(s->max_frames*sizeof(NeAACDecFrameInfo));
+
+    return (s->offsets && s->frames && s->sizes && s->info);
+}
+
+static void segment_close(segment_buffer *s)
+{
+    if (s->data) free(s->data);
+    if (s->offsets) free(s->offsets);
+    if (s->frames) free(s->frames);
+    if (s->sizes) free(s->sizes);
+    if (s->info) free(s->info);
+    if (s->pcm) free(s->pcm);
+}
+
+/* copies an access unit into the chunk */
+static int segment_add(segment_buffer *s, unsigned char *buffer, unsigned long size)
+{
+    if (s->data_used + size > s->data_size)
+    {
+        unsigned long data_size = 2*(s->data_used + size);
+        unsigned char *data = (unsigned char*)realloc(s->data, data_size);
+
+        if (data == NULL)
+            return 0;
+        s->data = data;
+        s->data_size = data_size;
+    }
+
+    memcpy(s->data + s->data_used, buffer, size);
+    s->offsets[s->num_frames] = s->data_used;
+    s->sizes[s->num_frames] = size;
+    s->data_used += size;
+    s->num_frames++;
+
+    return 1;
+}
+
+static int segment_decode(segment_buffer *s, NeAACDecHandle hDecoder, int channels)
+{
+    /* at most 2048 samples per channel and frame */
+    unsigned long pcm_size = s->max_frames*2048*channels*s->sample_size;
+    unsigned long i;
+
+    if (pcm_size > s->pcm_size)
+    {
+        if (s->pcm) free(s->pcm);
+        s->pcm = (unsigned char*)malloc(pcm_size);
+        s->pcm_size = (s->pcm != NULL) ? pcm_size : 0;
+    }
+    if (s->pcm == NULL)
+        return 0;
+
+    for (i = 0; i < s->num_frames; i++)
+        s->frames[i] = s->data + s->offsets[i];
+
+    s->num_decoded = NeAACDecDecodeSegments(hDecoder, s->info, s->frames, s->sizes,
+        s->num_frames, s->pcm, s->pcm_size, s->num_segments);
+    s->next = 0;
+    s->pcm_next = s->pcm;
+
+    /* start over with the next chunk */
+    s->num_frames = 0;
+    s->data_used = 0;
+
+    return 1;
+}
+
+/* decoded frames of the chunk not handed out yet */
+static int segment_left(segment_buffer *s)
+{
+    return (s->next < s->num_decoded);
+}
+
+static void *segment_next(segment_buffer *s, NeAACDecFrameInfo *frameInfo)
+{
+    void *sample_buffer = s->pcm_next;
+
+    *frameInfo = s->info[s->next++];
+    frameInfo->bytesconsumed = 0; /* taken from the input already */
+    if (frameInfo->error > 0)
+        return NULL;
+    s->pcm_next += frameInfo->samples*s->sample_size;
+
+    return sample_buffer;
+}
+
 static void usage(void)
 {
     faad_fprintf(stdout, "\nUsage:\n");
@@ -434,6 +560,7 @@ static void usage(void)
     faad_fprintf(stdout, "        3:  32 bit PCM data.\n");
     faad_fprintf(stdout, "        4:  32 bit floating point data.\n");
     faad_fprintf(stdout, "        5:  64 bit floating point data.\n");
+    faad_fprintf(stdout, "        6:  16 bit PCM data with TPDF dither.\n");
     faad_fprintf(stdout, " -s X  Force the samplerate to X (for RAW files).\n");
     faad_fprintf(stdout, " -l X  Set object type. Supported object types:\n");
     faad_fprintf(stdout, "        1:  Main object type.\n");
@@ -441,10 +568,16 @@ static void usage(void)
     faad_fprintf(stdout, "        4:  LTP (Long Term Prediction) object type.\n");
     faad_fprintf(stdout, "        23: LD (Low Delay) object type.\n");
     faad_fprintf(stdout, " -d    Down matrix 5.1 to 2 channels\n");
+    faad_fprintf(stdout, " -D    Down matrix 5.1 to 2 channels before the filterbank (faster).\n");
+    faad_fprintf(stdout, " -c X  Only decode the channel elements with a channel in bit mask X,\n");
+    faad_fprintf(stdout, "       the other elements are silent (e.g. 0x1 for the centre of 5.1).\n");
+    faad_fprintf(stdout, "       A channel pair is decoded when either of its channels is set.\n");
+    faad_fprintf(stdout, " -C    Only decode the AAC core of HE-AAC files, at its samplerate.\n");
     faad_fprintf(stdout, " -w    Write output to stdio instead of a file.\n");
     faad_fprintf(stdout, " -g    Disable gapless decoding.\n");
     faad_fprintf(stdout, " -q    Quiet - suppresses status messages.\n");
     faad_fprintf(stdout, " -j X  Jump - start output X seconds into track (MP4 files only).\n");
+    faad_fprintf(stdout, " -P X  Decode X segments of the file in parallel (ADTS and MP4 files).\n");
     faad_fprintf(stdout, "Example:\n");
     faad_fprintf(stdout, "       %s infile.aac\n", progName);
     faad_fprintf(stdout, "       %s infile.mp4\n", progName);
@@ -456,7 +589,8 @@ static void usage(void)
 
 static int decodeAACfile(char *aacfile, char *sndfile, char *adts_fn, int to_stdout,
                   int def_srate, int object_type, int outputFormat, int fileType,
-                  int downMatrix, int infoOnly, int adts_out, int old_format,
+                  int downMatrix, unsigned long channel_mask, int core_only,
+                  int infoOnly, int adts_out, int old_format, int num_segments,
                   float *song_length)
 {
     int tagsize;
@@ -486,8 +620,10 @@ static int decodeAACfile(char *aacfile, char *sndfile, char *adts_fn, int to_std
     int streaminput = 0;
 
     aac_buffer b;
+    segment_buffer seg;
 
     memset(&b, 0, sizeof(aac_buffer));
+    memset(&seg, 0, sizeof(segment_buffer));
 
     if (adts_out)
     {
@@ -571,6 +707,8 @@ static int decodeAACfile(char *aacfile, char *sndfile, char *adts_fn, int to_std
     config->defObjectType = object_type;
     config->outputFormat = outputFormat;
     config->downMatrix = downMatrix;
+    config->channelMask = channel_mask;
+    config->dontDecodeSBR = core_only;
     config->useOldADTSFormat = old_format;
     //config->dontUpSampleImplicitSBR = 1;
     NeAACDecSetConfiguration(hDecoder, config);
@@ -676,10 +814,47 @@ static int decodeAACfile(char *aacfile, char *sndfile, char *adts_fn, int to_std
         return 0;
     }
 
+    /* segments need the ADTS frame lengths */
+    if ((header_type == 1) && !adts_out &&
+        !segment_open(&seg, num_segments, outputFormat))
+    {
+        faad_fprintf(stderr, "Memory allocation error\n");
+        segment_close(&seg);
+        memset(&seg, 0, sizeof(segment_buffer));
+    }
+
     do
     {
-        sample_buffer = NeAACDecDecode(hDecoder, &frameInfo,
-            b.buffer, b.bytes_into_buffer);
+        if (seg.num_segments && !first_time && !segment_left(&seg))
+        {
+            /* collect the next chunk of ADTS frames */
+            while ((seg.num_frames < seg.max_frames) && (b.bytes_into_buffer >= 7) &&
+                (b.buffer[0] == 0xFF) && ((b.buffer[1] & 0xF6) == 0xF0))
+            {
+                int frame_length = ((((unsigned int)b.buffer[3] & 0x3)) << 11)
+                    | (((unsigned int)b.buffer[4]) << 3) | (b.buffer[5] >> 5);
+
+                if ((frame_length < 7) || (frame_length > b.bytes_into_buffer))
+                    break;
+                if (!segment_add(&seg, b.buffer, frame_length))
+                    break;
+                advance_buffer(&b, frame_length);
+                fill_buffer(&b);
+            }
+            if (seg.num_frames && !segment_decode(&seg, hDecoder, frameInfo.channels))
+            {
+                faad_fprintf(stderr, "Memory allocation error\n");
+                break;
+            }
+        }
+
+        if (segment_left(&seg))
+        {
+            sample_buffer = segment_next(&seg, &frameInfo);
+        } else {
+            sample_buffer = NeAACDecDecode(hDecoder, &frameInfo,
+                b.buffer, b.bytes_into_buffer);
+        }
 
         if (adts_out == 1)
         {
@@ -730,6 +905,7 @@ static int decodeAACfile(char *aacfile, char *sndfile, char *adts_fn, int to_std
                 {
                     if (b.buffer)
                         free(b.buffer);
+                    segment_close(&seg);
                     NeAACDecClose(hDecoder);
                     if (b.infile != stdin)
                         fclose(b.infile);
@@ -761,11 +937,12 @@ static int decodeAACfile(char *aacfile, char *sndfile, char *adts_fn, int to_std
         /* fill buffer */
         fill_buffer(&b);
 
-        if (b.bytes_into_buffer == 0)
+        if ((b.bytes_into_buffer == 0) && !segment_left(&seg))
             sample_buffer = NULL; /* to make sure it stops now */
 
     } while (sample_buffer != NULL);
 
+    segment_close(&seg);
     NeAACDecClose(hDecoder);
 
     if (adts_out == 1)
@@ -792,8 +969,10 @@ static const unsigned long srates[] =
 };
 
 static int decodeMP4file(char *mp4file, char *sndfile, char *adts_fn, int to_stdout,
-                  int outputFormat, int fileType, int downMatrix, int noGapless,
-                  int infoOnly, int adts_out, float *song_length, float seek_to)
+                  int outputFormat, int fileType, int downMatrix,
+                  unsigned long channel_mask, int core_only, int noGapless,
+                  int infoOnly, int adts_out, int num_segments, float *song_length,
+                  float seek_to)
 {
     /*int track;*/
     unsigned long samplerate;
@@ -812,6 +991,7 @@ static int decodeMP4file(char *mp4file, char *sndfile, char *adts_fn, int to_std
     NeAACDecConfigurationPtr config;
     NeAACDecFrameInfo frameInfo;
     mp4AudioSpecificConfig mp4ASC;
+    segment_buffer seg;
 
     char percents[MAX_PERCENTS];
     int percent, old_percent = -1;
@@ -846,6 +1026,8 @@ static int decodeMP4file(char *mp4file, char *sndfile, char *adts_fn, int to_std
     config = NeAACDecGetCurrentConfiguration(hDecoder);
     config->outputFormat = outputFormat;
     config->downMatrix = downMatrix;
+    config->channelMask = channel_mask;
+    config->dontDecodeSBR = core_only;
     //config->dontUpSampleImplicitSBR = 1;
     NeAACDecSetConfiguration(hDecoder, config);
 
@@ -908,6 +1090,14 @@ static int decodeMP4file(char *mp4file, char *sndfile, char *adts_fn, int to_std
     if (seek_to > 0.1)
         startSampleId = (int64_t)(seek_to * mp4config.samplerate / framesize);
 
+    memset(&seg, 0, sizeof(segment_buffer));
+    if (!adts_out && !segment_open(&seg, num_segments, outputFormat))
+    {
+        faad_fprintf(stderr, "Memory allocation error\n");
+        segment_close(&seg);
+        memset(&seg, 0, sizeof(segment_buffer));
+    }
+
     mp4read_seek(startSampleId);
     for (sampleId = startSampleId; sampleId < mp4config.frame.ents; sampleId++)
     {
@@ -916,10 +1106,33 @@ static int decodeMP4file(char *mp4file, char *sndfile, char *adts_fn, int to_std
         unsigned int sample_count;
         unsigned int delay = 0;
 
-        if (mp4read_frame())
-            break;
+        if (seg.num_segments && !first_time && !segment_left(&seg))
+        {
+            /* collect the next chunk of access units */
+            while ((seg.num_frames < seg.max_frames) &&
+                (sampleId + (long)seg.num_frames < mp4config.frame.ents))
+            {
+                if (mp4read_frame())
+                    break;
+                if (!segment_add(&seg, mp4config.bitbuf.data, mp4config.bitbuf.size))
+                    break;
+            }
+            if (seg.num_frames && !segment_decode(&seg, hDecoder, frameInfo.channels))
+            {
+                faad_fprintf(stderr, "Memory allocation error\n");
+                break;
+            }
+        }
 
-        sample_buffer = NeAACDecDecode(hDecoder, &frameInfo, mp4config.bitbuf.data, mp4config.bitbuf.size);
+        if (segment_left(&seg))
+        {
+            sample_buffer = segment_next(&seg, &frameInfo);
+        } else {
+            if (mp4read_frame())
+                break;
+
+            sample_buffer = NeAACDecDecode(hDecoder, &frameInfo, mp4config.bitbuf.data, mp4config.bitbuf.size);
+        }
 
         if (!sample_buffer) {
             /* unable to decode file, abort */
@@ -983,6 +1196,7 @@ static int decodeMP4file(char *mp4file, char *sndfile, char *adts_fn, int to_std
                 }
                 if (aufile == NULL)
                 {
+                    segment_close(&seg);
                     NeAACDecClose(hDecoder);
                     mp4read_close();
                     return 0;
@@ -1015,6 +1229,7 @@ static int decodeMP4file(char *mp4file, char *sndfile, char *adts_fn, int to_std
         }
     }
 
+    segment_close(&seg);
     NeAACDecClose(hDecoder);
 
     if (adts_out == 1)
@@ -1039,6 +1254,8 @@ static int faad_main(int argc, char *argv[])
     int object_type = LC;
     int def_srate = 0;
     int downMatrix = 0;
+    unsigned long channelMask = 0;
+    int coreOnly = 0;
     int format = 1;
     int outputFormat = FAAD_FMT_16BIT;
     int outfile_set = 0;
@@ -1047,6 +1264,7 @@ static int faad_main(int argc, char *argv[])
     int showHelp = 0;
     int mp4file = 0;
     int noGapless = 0;
+    int num_segments = 1;
     char *fnp;
     char *aacFileName = NULL;
     char *audioFileName = NULL;
@@ -1084,15 +1302,19 @@ static int faad_main(int argc, char *argv[])
             { "samplerate", 0, 0, 's' },
             { "objecttype", 0, 0, 'l' },
             { "downmix",    0, 0, 'd' },
+            { "specdownmix", 0, 0, 'D' },
+            { "channels",   1, 0, 'c' },
+            { "coreonly",   0, 0, 'C' },
             { "info",       0, 0, 'i' },
             { "stdio",      0, 0, 'w' },
             { "stdio",      0, 0, 'g' },
             { "seek",       1, 0, 'j' },
+            { "threads",    1, 0, 'P' },
             { "help",       0, 0, 'h' },
             { 0, 0, 0, 0 }
         };
 
-        c = getopt_long(argc, argv, "o:a:s:f:b:l:j:wgdhitq",
+        c = getopt_long(argc, argv, "o:a:s:f:b:l:j:P:c:CwgdDhitq",
             long_options, &option_index);
 
         if (c == -1)
@@ -1159,7 +1381,7 @@ static int faad_main(int argc, char *argv[])
                     outputFormat = FAAD_FMT_16BIT; /* just use default */
                 } else {
                     outputFormat = atoi(dr);
-                    if ((outputFormat < 1) || (outputFormat > 5))
+                    if ((outputFormat < 1) || (outputFormat > 6))
                         showHelp = 1;
                 }
             }
@@ -1189,12 +1411,32 @@ static int faad_main(int argc, char *argv[])
                 seekTo = atof(optarg);
             }
             break;
+        case 'P':
+            if (optarg)
+            {
+                num_segments = atoi(optarg);
+                if ((num_segments < 1) || (num_segments > 255))
+                    showHelp = 1;
+            }
+            break;
+        case 'c':
+            if (optarg)
+            {
+                channelMask = strtoul(optarg, NULL, 0);
+            }
+            break;
+        case 'C':
+            coreOnly = 1;
+            break;
         case 't':
             old_format = 1;
             break;
         case 'd':
             downMatrix = 1;
             break;
+        case 'D':
+            downMatrix = FAAD_DOWNMIX_SPECTRAL;
+            break;
         case 'w':
             writeToStdio = 1;
             break;
@@ -1327,7 +1569,8 @@ static int faad_main(int argc, char *argv[])
     if (mp4file)
     {
         result = decodeMP4file(aacFileName, audioFileName, adtsFileName, writeToStdio,
-            outputFormat, format, downMatrix, noGapless, infoOnly, adts_out, &length, seekTo);
+            outputFormat, format, downMatrix, channelMask, coreOnly, noGapless, infoOnly,
+            adts_out, num_segments, &length, seekTo);
     } else {
 
     if (readFromStdin == 1) {
@@ -1342,8 +1585,8 @@ static int faad_main(int argc, char *argv[])
     }
 
         result = decodeAACfile(aacFileName, audioFileName, adtsFileName, writeToStdio,
-            def_srate, object_type, outputFormat, format, downMatrix, infoOnly, adts_out,
-            old_format, &length);
+            def_srate, object_type, outputFormat, format, downMatrix, channelMask, coreOnly,
+            infoOnly, adts_out, old_format, num_segments, &length);
     }
 
     if (audioFileName != NULL)
@@ -99,6 +99,21 @@ extern "C" {
 #define FAAD_FMT_FLOAT  4
 #define FAAD_FMT_FIXED  FAAD_FMT_FLOAT
 #define FAAD_FMT_DOUBLE 5
+/* 16 bit output with triangular (TPDF) dither of +-1 LSB added before
+   rounding, to decorrelate the requantization error from the signal */
+#define FAAD_FMT_16BIT_DITHER 6
+
+/* planar output formats: all samples of the first channel, followed by
+   all samples of the second channel, etc. */
+#define FAAD_FMT_16BIT_PLANAR 10
+#define FAAD_FMT_32BIT_PLANAR 11
+#define FAAD_FMT_FLOAT_PLANAR 12
+#define FAAD_FMT_FIXED_PLANAR FAAD_FMT_FLOAT_PLANAR
+
+/* downMatrix value: 5.1 channels are mixed to stereo before the filterbank
+   when their windows match, so only 2 channels are inverse transformed;
+   1 mixes the output of all channels */
+#define FAAD_DOWNMIX_SPECTRAL 2
 
 /* Capabilities */
 #define LC_DEC_CAP           (1<<0) /* Can decode LC */
@@ -135,6 +150,21 @@ extern "C" {
 
 typedef void *NeAACDecHandle;
 
+/* memory allocation callbacks, user_data is passed through unchanged */
+typedef void *(*NeAACDecMallocFunc)(void *user_data, unsigned long size);
+typedef void (*NeAACDecFreeFunc)(void *user_data, void *ptr);
+
+/* allocation modes for NeAACDecOpenWithAllocator() */
+#define FAAD_ALLOC_DEFAULT 0 /* every buffer is allocated separately */
+#define FAAD_ALLOC_ARENA   1 /* one cache line aligned block, sized at init */
+
+/* job callbacks for NeAACDecSetElementThreads(): run_jobs has to call
+   job(job_data, i) once for every i below num_jobs, in any order and on any
+   thread, and return when all of them have finished */
+typedef void (*NeAACDecJobFunc)(void *job_data, unsigned long index);
+typedef void (*NeAACDecRunJobsFunc)(void *user_data, NeAACDecJobFunc job,
+                                    void *job_data, unsigned long num_jobs);
+
 typedef struct mp4AudioSpecificConfig
 {
     /* Audio Specific Info */
@@ -166,6 +196,10 @@ typedef struct NeAACDecConfiguration
     unsigned char downMatrix;
     unsigned char useOldADTSFormat;
     unsigned char dontUpSampleImplicitSBR;
+    /* only decode the AAC core of HE-AAC streams, read by the init calls */
+    unsigned char dontDecodeSBR;
+    /* bit n set: output channel n is decoded, 0: all channels are decoded */
+    unsigned long channelMask;
 } NeAACDecConfiguration, *NeAACDecConfigurationPtr;
 
 typedef struct NeAACDecFrameInfo
@@ -202,6 +236,15 @@ NEAACDECAPI unsigned long NeAACDecGetCapabilities(void);
 
 NEAACDECAPI NeAACDecHandle NeAACDecOpen(void);
 
+/* Open a decoder that allocates all memory through malloc_func/free_func.
+   Passing NULL for both uses the C library. With FAAD_ALLOC_ARENA the
+   per-instance state is carved from a single block that is allocated at
+   init based on the stream configuration. */
+NEAACDECAPI NeAACDecHandle NeAACDecOpenWithAllocator(NeAACDecMallocFunc malloc_func,
+                                                     NeAACDecFreeFunc free_func,
+                                                     void *user_data,
+                                                     unsigned char mode);
+
 NEAACDECAPI NeAACDecConfigurationPtr NeAACDecGetCurrentConfiguration(NeAACDecHandle hDecoder);
 
 NEAACDECAPI unsigned char NeAACDecSetConfiguration(NeAACDecHandle hDecoder,
@@ -241,6 +284,63 @@ NEAACDECAPI void* NeAACDecDecode2(NeAACDecHandle hDecoder,
                                   void **sample_buffer,
                                   unsigned long sample_buffer_size);
 
+/* Decode num_frames access units in one call. The samples of all frames
+   are written back to back into sample_buffer, hInfo points to an array of
+   num_frames frame infos. Only the last access unit is checked for an
+   ID3v1 tag. Decoding stops at the first frame that reports an error;
+   returns the number of frame infos filled in. */
+NEAACDECAPI unsigned long NeAACDecDecodeBatch(NeAACDecHandle hDecoder,
+                                              NeAACDecFrameInfo *hInfo,
+                                              unsigned char **buffers,
+                                              unsigned long *buffer_sizes,
+                                              unsigned long num_frames,
+                                              void *sample_buffer,
+                                              unsigned long sample_buffer_size);
+
+/* Like NeAACDecDecodeBatch(), but the frames are split into num_segments
+   ranges that are decoded in parallel, each by its own decoder that starts
+   a few frames early to warm up the filterbank, SBR and PS state. Ranges
+   with PNS are decoded a second time with the noise generator state of
+   serial decoding, so LC output matches it; SBR and PS output at the
+   segment starts may differ slightly. Main and LTP streams, and short
+   batches, are decoded serially. */
+NEAACDECAPI unsigned long NeAACDecDecodeSegments(NeAACDecHandle hDecoder,
+                                                 NeAACDecFrameInfo *hInfo,
+                                                 unsigned char **buffers,
+                                                 unsigned long *buffer_sizes,
+                                                 unsigned long num_frames,
+                                                 void *sample_buffer,
+                                                 unsigned long sample_buffer_size,
+                                                 unsigned char num_segments);
+
+/* Lend read-only pointers to the decoder's per-channel output of the last
+   decoded frame, in output channel order. The samples are in the internal
+   format: float scaled to the 16 bit range, or fixed point in FIXED_POINT
+   builds. The pointers stay valid until the next decode call. Returns the
+   number of pointers filled in, 0 when no frame is available or the output
+   is downmixed. */
+NEAACDECAPI unsigned char NeAACDecGetChannelBuffers(NeAACDecHandle hDecoder,
+                                                    const void **channel_buffers,
+                                                    unsigned char max_channels);
+
+/* Parse all syntax elements of a frame before reconstructing them, then
+   reconstruct the elements (IMDCT, SBR, ...) in parallel: through run_jobs
+   when it is not NULL, otherwise on an internal pool of num_threads
+   threads including the decoding thread. num_threads below 2 without
+   run_jobs switches back to serial decoding. Returns 1 on success. */
+NEAACDECAPI unsigned char NeAACDecSetElementThreads(NeAACDecHandle hDecoder,
+                                                    unsigned char num_threads,
+                                                    NeAACDecRunJobsFunc run_jobs,
+                                                    void *user_data);
+
+/* Let NeAACDecDecodeBatch() parse each frame while the previous one is
+   synthesized on a second thread. The output is identical to serial
+   decoding; on an error the decoder may have parsed one frame past the
+   failing one. Streams with SBR are not overlapped. Returns 1 on
+   success. */
+NEAACDECAPI unsigned char NeAACDecSetBatchPipeline(NeAACDecHandle hDecoder,
+                                                   unsigned char enable);
+
 NEAACDECAPI char NeAACDecAudioSpecificConfig(unsigned char *pBuffer,
                                              unsigned long buffer_size,
                                              mp4AudioSpecificConfig *mp4ASC);
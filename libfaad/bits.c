@@ -37,49 +37,28 @@
 /* initialize buffer, call once before first getbits or showbits */
 void faad_initbits(bitfile *ld, const void *_buffer, const uint32_t buffer_size)
 {
-    uint32_t tmp;
-
     if (ld == NULL)
         return;
 
     // useless
     //memset(ld, 0, sizeof(bitfile));
 
+    ld->cache = 0;
+    ld->bits_left = 0;
+    ld->tail = 0;
+
     if (buffer_size == 0 || _buffer == NULL)
     {
+        ld->buffer_size = 0;
+        ld->start = NULL;
         ld->error = 1;
         return;
     }
 
-    ld->buffer = _buffer;
-
+    ld->start = (const uint8_t*)_buffer;
     ld->buffer_size = buffer_size;
-    ld->bytes_left  = buffer_size;
-
-    if (ld->bytes_left >= 4)
-    {
-        tmp = getdword((uint32_t*)ld->buffer);
-        ld->bytes_left -= 4;
-    } else {
-        tmp = getdword_n((uint32_t*)ld->buffer, ld->bytes_left);
-        ld->bytes_left = 0;
-    }
-    ld->bufa = tmp;
-
-    if (ld->bytes_left >= 4)
-    {
-        tmp = getdword((uint32_t*)ld->buffer + 1);
-        ld->bytes_left -= 4;
-    } else {
-        tmp = getdword_n((uint32_t*)ld->buffer + 1, ld->bytes_left);
-        ld->bytes_left = 0;
-    }
-    ld->bufb = tmp;
-
-    ld->start = (uint32_t*)ld->buffer;
-    ld->tail = ((uint32_t*)ld->buffer + 2);
 
-    ld->bits_left = 32;
+    faad_fillbits(ld);
 
     ld->error = 0;
 }
@@ -91,12 +70,12 @@ void faad_endbits(bitfile *ld)
 
 uint32_t faad_get_processed_bits(bitfile *ld)
 {
-    return (uint32_t)(8 * (4*(ld->tail - ld->start) - 4) - (ld->bits_left));
+    return (uint32_t)(8 * ld->tail - ld->bits_left);
 }
 
 uint8_t faad_byte_align(bitfile *ld)
 {
-    int remainder = (32 - ld->bits_left) & 0x7;
+    int remainder = (64 - ld->bits_left) & 0x7;
 
     if (remainder)
     {
@@ -106,101 +85,44 @@ uint8_t faad_byte_align(bitfile *ld)
     return 0;
 }
 
-void faad_flushbits_ex(bitfile *ld, uint32_t bits)
+/* load the last bytes of the buffer, zeros after the end */
+void faad_fillbits_ex(bitfile *ld)
 {
-    uint32_t tmp;
-
-    ld->bufa = ld->bufb;
-    if (ld->bytes_left >= 4)
+    while (ld->bits_left <= 56)
     {
-        tmp = getdword(ld->tail);
-        ld->bytes_left -= 4;
-    } else {
-        tmp = getdword_n(ld->tail, ld->bytes_left);
-        ld->bytes_left = 0;
+        if (ld->tail < ld->buffer_size)
+            ld->cache |= (uint64_t)ld->start[ld->tail] << (56 - ld->bits_left);
+        ld->tail++;
+        ld->bits_left += 8;
     }
-    ld->bufb = tmp;
-    ld->tail++;
-    ld->bits_left += (32 - bits);
-    //ld->bytes_left -= 4;
-//    if (ld->bytes_left == 0)
-//        ld->no_more_reading = 1;
-//    if (ld->bytes_left < 0)
-//        ld->error = 1;
 }
 
 /* rewind to beginning */
 void faad_rewindbits(bitfile *ld)
 {
-    uint32_t tmp;
-
-    ld->bytes_left = ld->buffer_size;
+    ld->cache = 0;
+    ld->bits_left = 0;
+    ld->tail = 0;
 
-    if (ld->bytes_left >= 4)
-    {
-        tmp = getdword((uint32_t*)&ld->start[0]);
-        ld->bytes_left -= 4;
-    } else {
-        tmp = getdword_n((uint32_t*)&ld->start[0], ld->bytes_left);
-        ld->bytes_left = 0;
-    }
-    ld->bufa = tmp;
-
-    if (ld->bytes_left >= 4)
-    {
-        tmp = getdword((uint32_t*)&ld->start[1]);
-        ld->bytes_left -= 4;
-    } else {
-        tmp = getdword_n((uint32_t*)&ld->start[1], ld->bytes_left);
-        ld->bytes_left = 0;
-    }
-    ld->bufb = tmp;
-
-    ld->bits_left = 32;
-    ld->tail = &ld->start[2];
+    faad_fillbits(ld);
 }
 
 /* reset to a certain point */
 void faad_resetbits(bitfile *ld, int bits)
 {
-    uint32_t tmp;
-    int words = bits >> 5;
-    int remainder = bits & 0x1F;
-
-    if (ld->buffer_size < words * 4)
-        ld->bytes_left = 0;
-    else
-        ld->bytes_left = ld->buffer_size - words*4;
+    int remainder = bits & 0x7;
 
-    if (ld->bytes_left >= 4)
-    {
-        tmp = getdword(&ld->start[words]);
-        ld->bytes_left -= 4;
-    } else {
-        tmp = getdword_n(&ld->start[words], ld->bytes_left);
-        ld->bytes_left = 0;
-    }
-    ld->bufa = tmp;
+    ld->cache = 0;
+    ld->bits_left = 0;
+    ld->tail = bits >> 3;
 
-    if (ld->bytes_left >= 4)
-    {
-        tmp = getdword(&ld->start[words+1]);
-        ld->bytes_left -= 4;
-    } else {
-        tmp = getdword_n(&ld->start[words+1], ld->bytes_left);
-        ld->bytes_left = 0;
-    }
-    ld->bufb = tmp;
+    faad_fillbits(ld);
 
-    ld->bits_left = 32 - remainder;
-    ld->tail = &ld->start[words+2];
+    ld->cache <<= remainder;
+    ld->bits_left -= remainder;
 
     /* recheck for reading too many bytes */
     ld->error = 0;
-//    if (ld->bytes_left == 0)
-//        ld->no_more_reading = 1;
-//    if (ld->bytes_left < 0)
-//        ld->error = 1;
 }
 
 uint8_t *faad_getbitbuffer(bitfile *ld, uint32_t bits
@@ -246,28 +168,12 @@ uint32_t faad_origbitbuffer_size(bitfile *ld)
 void faad_initbits_rev(bitfile *ld, void *buffer,
                        uint32_t bits_in_buffer)
 {
-    uint32_t tmp;
-    int32_t index;
-
+    ld->cache = 0;
+    ld->tail = 0;
     ld->buffer_size = bit2byte(bits_in_buffer);
+    ld->start = (const uint8_t*)buffer;
 
-    index = (bits_in_buffer+31)/32 - 1;
-
-    ld->start = (uint32_t*)buffer + index - 2;
-
-    tmp = getdword((uint32_t*)buffer + index);
-    ld->bufa = tmp;
-
-    tmp = getdword((uint32_t*)buffer + index - 1);
-    ld->bufb = tmp;
-
-    ld->tail = (uint32_t*)buffer + index;
-
-    ld->bits_left = bits_in_buffer % 32;
-    if (ld->bits_left == 0)
-        ld->bits_left = 32;
-
-    ld->bytes_left = ld->buffer_size;
+    ld->bits_left = bits_in_buffer;
     ld->error = 0;
 }
 
@@ -48,15 +48,12 @@ extern "C" {
 typedef struct _bitfile
 {
     /* bit input */
-    uint32_t bufa;
-    uint32_t bufb;
-    uint32_t bits_left;
+    uint64_t cache;       /* next bits of the stream, msb first */
+    uint32_t bits_left;   /* valid bits in cache, at least 32 between reads */
+    uint32_t tail;        /* offset of the next byte to load */
     uint32_t buffer_size; /* size of the buffer in bytes */
-    uint32_t bytes_left;
     uint8_t error;
-    uint32_t *tail;
-    uint32_t *start;
-    const void *buffer;
+    const uint8_t *start;
 } bitfile;
 
 
@@ -78,7 +75,7 @@ void faad_initbits_rev(bitfile *ld, void *buffer,
                        uint32_t bits_in_buffer);
 uint8_t faad_byte_align(bitfile *ld);
 uint32_t faad_get_processed_bits(bitfile *ld);
-void faad_flushbits_ex(bitfile *ld, uint32_t bits);
+void faad_fillbits_ex(bitfile *ld);
 void faad_rewindbits(bitfile *ld);
 void faad_resetbits(bitfile *ld, int bits);
 uint8_t *faad_getbitbuffer(bitfile *ld, uint32_t bits
@@ -88,69 +85,48 @@ void *faad_origbitbuffer(bitfile *ld);
 uint32_t faad_origbitbuffer_size(bitfile *ld);
 #endif
 
-/* circumvent memory alignment errors on ARM */
-static INLINE uint32_t getdword(void *mem)
+/* load 8 bytes as a big endian word, memcpy() circumvents memory
+   alignment errors on ARM */
+static INLINE uint64_t getqword(const uint8_t *mem)
 {
-    uint32_t tmp;
+    uint64_t tmp;
+
+    memcpy(&tmp, mem, sizeof(tmp));
 #ifndef ARCH_IS_BIG_ENDIAN
-    ((uint8_t*)&tmp)[0] = ((uint8_t*)mem)[3];
-    ((uint8_t*)&tmp)[1] = ((uint8_t*)mem)[2];
-    ((uint8_t*)&tmp)[2] = ((uint8_t*)mem)[1];
-    ((uint8_t*)&tmp)[3] = ((uint8_t*)mem)[0];
+#if defined(__GNUC__)
+    tmp = __builtin_bswap64(tmp);
+#elif defined(_MSC_VER)
+    tmp = _byteswap_uint64(tmp);
 #else
-    ((uint8_t*)&tmp)[0] = ((uint8_t*)mem)[0];
-    ((uint8_t*)&tmp)[1] = ((uint8_t*)mem)[1];
-    ((uint8_t*)&tmp)[2] = ((uint8_t*)mem)[2];
-    ((uint8_t*)&tmp)[3] = ((uint8_t*)mem)[3];
+    tmp = ((tmp & 0x00000000000000FFULL) << 56) | ((tmp & 0x000000000000FF00ULL) << 40) |
+          ((tmp & 0x0000000000FF0000ULL) << 24) | ((tmp & 0x00000000FF000000ULL) << 8) |
+          ((tmp & 0x000000FF00000000ULL) >> 8) | ((tmp & 0x0000FF0000000000ULL) >> 24) |
+          ((tmp & 0x00FF000000000000ULL) >> 40) | ((tmp & 0xFF00000000000000ULL) >> 56);
+#endif
 #endif
 
     return tmp;
 }
 
-/* reads only n bytes from the stream instead of the standard 4 */
-static /*INLINE*/ uint32_t getdword_n(void *mem, int n)
+/* top up the cache to at least 56 bits. Bits below bits_left are either
+   zero or the stream bits that belong there, so loading whole words over
+   them is harmless. Only the last 7 bytes of the buffer are read one at
+   a time (faad_fillbits_ex()), reading past the end gives zero bits. */
+static INLINE void faad_fillbits(bitfile *ld)
 {
-    uint32_t tmp = 0;
-#ifndef ARCH_IS_BIG_ENDIAN
-    switch (n)
+    if (ld->tail + 8 <= ld->buffer_size)
     {
-    case 3:
-        ((uint8_t*)&tmp)[1] = ((uint8_t*)mem)[2];
-    case 2:
-        ((uint8_t*)&tmp)[2] = ((uint8_t*)mem)[1];
-    case 1:
-        ((uint8_t*)&tmp)[3] = ((uint8_t*)mem)[0];
-    default:
-        break;
-    }
-#else
-    switch (n)
-    {
-    case 3:
-        ((uint8_t*)&tmp)[2] = ((uint8_t*)mem)[2];
-    case 2:
-        ((uint8_t*)&tmp)[1] = ((uint8_t*)mem)[1];
-    case 1:
-        ((uint8_t*)&tmp)[0] = ((uint8_t*)mem)[0];
-    default:
-        break;
+        ld->cache |= getqword(ld->start + ld->tail) >> ld->bits_left;
+        ld->tail += (63 - ld->bits_left) >> 3;
+        ld->bits_left |= 56;
+    } else {
+        faad_fillbits_ex(ld);
     }
-#endif
-
-    return tmp;
 }
 
 static INLINE uint32_t faad_showbits(bitfile *ld, uint32_t bits)
 {
-    if (bits <= ld->bits_left)
-    {
-        //return (ld->bufa >> (ld->bits_left - bits)) & bitmask[bits];
-        return (ld->bufa << (32 - ld->bits_left)) >> (32 - bits);
-    }
-
-    bits -= ld->bits_left;
-    //return ((ld->bufa & bitmask[ld->bits_left]) << bits) | (ld->bufb >> (32 - bits));
-    return ((ld->bufa & ((1<<ld->bits_left)-1)) << bits) | (ld->bufb >> (32 - bits));
+    return (uint32_t)(ld->cache >> (64 - bits));
 }
 
 static INLINE void faad_flushbits(bitfile *ld, uint32_t bits)
@@ -159,16 +135,14 @@ static INLINE void faad_flushbits(bitfile *ld, uint32_t bits)
     if (ld->error != 0)
         return;
 
-    if (bits < ld->bits_left)
-    {
-        ld->bits_left -= bits;
-    } else {
-        faad_flushbits_ex(ld, bits);
-    }
+    ld->cache <<= bits;
+    ld->bits_left -= bits;
+    if (ld->bits_left < 32)
+        faad_fillbits(ld);
 }
 
 /* return next n bits (right adjusted) */
-static /*INLINE*/ uint32_t faad_getbits(bitfile *ld, uint32_t n DEBUGDEC)
+static INLINE uint32_t faad_getbits(bitfile *ld, uint32_t n DEBUGDEC)
 {
     uint32_t ret;
 
@@ -190,50 +164,26 @@ static INLINE uint8_t faad_get1bit(bitfile *ld DEBUGDEC)
 {
     uint8_t r;
 
-    if (ld->bits_left > 0)
-    {
-        ld->bits_left--;
-        r = (uint8_t)((ld->bufa >> ld->bits_left) & 1);
-        return r;
-    }
+    r = (uint8_t)(ld->cache >> 63);
+    faad_flushbits(ld, 1);
 
-    /* bits_left == 0 */
-#if 0
-    r = (uint8_t)(ld->bufb >> 31);
-    faad_flushbits_ex(ld, 1);
-#else
-    r = (uint8_t)faad_getbits(ld, 1);
-#endif
     return r;
 }
 
-/* reversed bitreading routines */
+/* reversed bitreading routines, bits_left is the number of bits in
+   front of the read position */
 static INLINE uint32_t faad_showbits_rev(bitfile *ld, uint32_t bits)
 {
-    uint8_t i;
+    uint32_t i, pos;
     uint32_t B = 0;
 
-    if (bits <= ld->bits_left)
+    for (i = 0; (i < bits) && (i < ld->bits_left); i++)
     {
-        for (i = 0; i < bits; i++)
-        {
-            if (ld->bufa & (1 << (i + (32 - ld->bits_left))))
-                B |= (1 << (bits - i - 1));
-        }
-        return B;
-    } else {
-        for (i = 0; i < ld->bits_left; i++)
-        {
-            if (ld->bufa & (1 << (i + (32 - ld->bits_left))))
-                B |= (1 << (bits - i - 1));
-        }
-        for (i = 0; i < bits - ld->bits_left; i++)
-        {
-            if (ld->bufb & (1 << (i + (32-ld->bits_left))))
-                B |= (1 << (bits - ld->bits_left - i - 1));
-        }
-        return B;
+        pos = ld->bits_left - i - 1;
+        if ((ld->start[pos >> 3] >> (7 - (pos & 7))) & 1)
+            B |= (1 << (bits - i - 1));
     }
+    return B;
 }
 
 static INLINE void faad_flushbits_rev(bitfile *ld, uint32_t bits)
@@ -242,27 +192,12 @@ static INLINE void faad_flushbits_rev(bitfile *ld, uint32_t bits)
     if (ld->error != 0)
         return;
 
-    if (bits < ld->bits_left)
+    if (bits <= ld->bits_left)
     {
         ld->bits_left -= bits;
     } else {
-        uint32_t tmp;
-
-        ld->bufa = ld->bufb;
-        tmp = getdword(ld->start);
-        ld->bufb = tmp;
-        ld->start--;
-        ld->bits_left += (32 - bits);
-
-        if (ld->bytes_left < 4)
-        {
-            ld->error = 1;
-            ld->bytes_left = 0;
-        } else {
-            ld->bytes_left -= 4;
-        }
-//        if (ld->bytes_left == 0)
-//            ld->no_more_reading = 1;
+        ld->error = 1;
+        ld->bits_left = 0;
     }
 }
 
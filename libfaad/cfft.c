@@ -685,16 +685,669 @@ static void passf5(const uint16_t ido, const uint16_t l1, const complex_t *cc,
     }
 }
 
+#ifdef SIMD_V4
+/*----------------------------------------------------------------------
+   SIMD butterflies: the C passes above on two (SSE2, NEON) or four
+   (AVX2) complex values at a time, with the operations in the same
+   order, so the output is identical. Passes that don't split evenly
+   are left to the C versions.
+  ----------------------------------------------------------------------*/
+
+static void passf2_v4(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                      complex_t *ch, const complex_t *wa, const v4sf sign)
+{
+    uint16_t i, k, ah, ac;
+
+    for (k = 0; k < l1; k++)
+    {
+        ah = k*ido;
+        ac = 2*k*ido;
+
+        for (i = 0; i < ido; i += 2)
+        {
+            v4sf a = v4_load(&RE(cc[ac+i]));
+            v4sf b = v4_load(&RE(cc[ac+i+ido]));
+
+            v4_store(&RE(ch[ah+i]), v4_add(a, b));
+            v4_store(&RE(ch[ah+i+l1*ido]),
+                v4_cmul(v4_sub(a, b), v4_load(&RE(wa[i])), sign));
+        }
+    }
+}
+
+static void passf2pos_v4(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                         complex_t *ch, const complex_t *wa)
+{
+    if ((ido == 1) || (ido & 1))
+        passf2pos(ido, l1, cc, ch, wa);
+    else
+        passf2_v4(ido, l1, cc, ch, wa, v4_set(-1, 1, -1, 1));
+}
+
+static void passf2neg_v4(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                         complex_t *ch, const complex_t *wa)
+{
+    if ((ido == 1) || (ido & 1))
+        passf2neg(ido, l1, cc, ch, wa);
+    else
+        passf2_v4(ido, l1, cc, ch, wa, v4_set(1, -1, 1, -1));
+}
+
+static void passf3_v4(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                      complex_t *ch, const complex_t *wa1, const complex_t *wa2,
+                      const int8_t isign)
+{
+    const v4sf taur = v4_set1(FRAC_CONST(-0.5));
+    const v4sf taui = v4_set1(FRAC_CONST(0.866025403784439));
+    v4sf sign, nsign;
+    uint16_t i, k, ac, ah;
+
+    if ((ido == 1) || (ido & 1))
+    {
+        passf3(ido, l1, cc, ch, wa1, wa2, isign);
+        return;
+    }
+
+    /* RE(d2) = RE(c2) -/+ IM(c3), IM(d2) = IM(c2) +/- RE(c3) for isign 1/-1,
+       the same sign pattern as the twiddle multiplication */
+    sign = (isign == 1) ? v4_set(-1, 1, -1, 1) : v4_set(1, -1, 1, -1);
+    nsign = v4_mul(sign, v4_set1(-1));
+
+    for (k = 0; k < l1; k++)
+    {
+        for (i = 0; i < ido; i += 2)
+        {
+            v4sf x0, x1, x2, t2, c2, c3;
+
+            ac = i + (3*k+1)*ido;
+            ah = i + k * ido;
+
+            x0 = v4_load(&RE(cc[ac-ido]));
+            x1 = v4_load(&RE(cc[ac]));
+            x2 = v4_load(&RE(cc[ac+ido]));
+
+            t2 = v4_add(x1, x2);
+            c2 = v4_add(x0, v4_mul(t2, taur));
+            v4_store(&RE(ch[ah]), v4_add(x0, t2));
+            c3 = v4_swap_ri(v4_mul(v4_sub(x1, x2), taui));
+
+            v4_store(&RE(ch[ah+l1*ido]),
+                v4_cmul(v4_add(c2, v4_mul(c3, sign)), v4_load(&RE(wa1[i])), sign));
+            v4_store(&RE(ch[ah+2*l1*ido]),
+                v4_cmul(v4_add(c2, v4_mul(c3, nsign)), v4_load(&RE(wa2[i])), sign));
+        }
+    }
+}
+
+/* pos: ch[l1] = t1 + t4, neg: ch[l1] = t1 - t4 */
+static INLINE void passf4_v4(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                             complex_t *ch, const complex_t *wa1, const complex_t *wa2,
+                             const complex_t *wa3, const uint8_t pos)
+{
+    const v4sf sign = pos ? v4_set(-1, 1, -1, 1) : v4_set(1, -1, 1, -1);
+    uint16_t i, k, ac, ah;
+
+    if (ido == 1)
+    {
+        for (k = 0; k < l1; k += 2)
+        {
+            v4sf v0, v1, v2, v3, a, b, c, d, t1, t2, t3, t4;
+
+            ac = 4*k;
+
+            v0 = v4_load(&RE(cc[ac]));
+            v1 = v4_load(&RE(cc[ac+2]));
+            v2 = v4_load(&RE(cc[ac+4]));
+            v3 = v4_load(&RE(cc[ac+6]));
+            a = v4_lo_lo(v0, v2);
+            b = v4_hi_hi(v0, v2);
+            c = v4_lo_lo(v1, v3);
+            d = v4_hi_hi(v1, v3);
+
+            t2 = v4_add(a, c);
+            t1 = v4_sub(a, c);
+            t3 = v4_add(b, d);
+            /* RE(t4) = IM(d) - IM(b), IM(t4) = RE(b) - RE(d) */
+            t4 = v4_re_im(v4_swap_ri(v4_sub(d, b)), v4_swap_ri(v4_sub(b, d)));
+
+            v4_store(&RE(ch[k]), v4_add(t2, t3));
+            v4_store(&RE(ch[k+2*l1]), v4_sub(t2, t3));
+            v4_store(&RE(ch[k+l1]), pos ? v4_add(t1, t4) : v4_sub(t1, t4));
+            v4_store(&RE(ch[k+3*l1]), pos ? v4_sub(t1, t4) : v4_add(t1, t4));
+        }
+    } else {
+        for (k = 0; k < l1; k++)
+        {
+            ac = 4*k*ido;
+            ah = k*ido;
+
+            for (i = 0; i < ido; i += 2)
+            {
+                v4sf a, b, c, d, t1, t2, t3, t4, c2, c4;
+
+                a = v4_load(&RE(cc[ac+i]));
+                b = v4_load(&RE(cc[ac+i+ido]));
+                c = v4_load(&RE(cc[ac+i+2*ido]));
+                d = v4_load(&RE(cc[ac+i+3*ido]));
+
+                t2 = v4_add(a, c);
+                t1 = v4_sub(a, c);
+                t3 = v4_add(b, d);
+                t4 = v4_re_im(v4_swap_ri(v4_sub(d, b)), v4_swap_ri(v4_sub(b, d)));
+
+                c2 = pos ? v4_add(t1, t4) : v4_sub(t1, t4);
+                c4 = pos ? v4_sub(t1, t4) : v4_add(t1, t4);
+
+                v4_store(&RE(ch[ah+i]), v4_add(t2, t3));
+                v4_store(&RE(ch[ah+i+l1*ido]),
+                    v4_cmul(c2, v4_load(&RE(wa1[i])), sign));
+                v4_store(&RE(ch[ah+i+2*l1*ido]),
+                    v4_cmul(v4_sub(t2, t3), v4_load(&RE(wa2[i])), sign));
+                v4_store(&RE(ch[ah+i+3*l1*ido]),
+                    v4_cmul(c4, v4_load(&RE(wa3[i])), sign));
+            }
+        }
+    }
+}
+
+static void passf4pos_v4(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                         complex_t *ch, const complex_t *wa1, const complex_t *wa2,
+                         const complex_t *wa3)
+{
+    if ((ido == 1) ? (l1 & 1) : (ido & 1))
+        passf4pos(ido, l1, cc, ch, wa1, wa2, wa3);
+    else
+        passf4_v4(ido, l1, cc, ch, wa1, wa2, wa3, 1);
+}
+
+static void passf4neg_v4(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                         complex_t *ch, const complex_t *wa1, const complex_t *wa2,
+                         const complex_t *wa3)
+{
+    if ((ido == 1) ? (l1 & 1) : (ido & 1))
+        passf4neg(ido, l1, cc, ch, wa1, wa2, wa3);
+    else
+        passf4_v4(ido, l1, cc, ch, wa1, wa2, wa3, 0);
+}
+
+static void passf5_v4(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                      complex_t *ch, const complex_t *wa1, const complex_t *wa2,
+                      const complex_t *wa3, const complex_t *wa4, const int8_t isign)
+{
+    const v4sf tr11 = v4_set1(FRAC_CONST(0.309016994374947));
+    const v4sf ti11 = v4_set1(FRAC_CONST(0.951056516295154));
+    const v4sf tr12 = v4_set1(FRAC_CONST(-0.809016994374947));
+    const v4sf ti12 = v4_set1(FRAC_CONST(0.587785252292473));
+    v4sf sign, nsign, k4, k5;
+    uint16_t i, k, ac, ah;
+
+    if ((ido == 1) ? (l1 & 1) : (ido & 1))
+    {
+        passf5(ido, l1, cc, ch, wa1, wa2, wa3, wa4, isign);
+        return;
+    }
+
+    /* isign 1:  c5 = t5*ti11 + t4*ti12, c4 = t5*ti12 - t4*ti11
+       isign -1: c5 = t5*ti11 - t4*ti12, c4 = t5*ti12 + t4*ti11 */
+    sign = (isign == 1) ? v4_set(-1, 1, -1, 1) : v4_set(1, -1, 1, -1);
+    nsign = v4_mul(sign, v4_set1(-1));
+    k5 = (isign == 1) ? ti12 : v4_mul(ti12, v4_set1(-1));
+    k4 = (isign == 1) ? v4_mul(ti11, v4_set1(-1)) : ti11;
+
+    for (k = 0; k < l1; k += (ido == 1) ? 2 : 1)
+    {
+        for (i = 0; i < ido; i += 2)
+        {
+            v4sf x0, x1, x2, x3, x4, t2, t3, t4, t5, c2, c3, c4, c5;
+
+            if (ido == 1)
+            {
+                v4sf v0, v1, v2, v3, v4;
+
+                ac = 5*k;
+
+                v0 = v4_load(&RE(cc[ac]));
+                v1 = v4_load(&RE(cc[ac+2]));
+                v2 = v4_load(&RE(cc[ac+4]));
+                v3 = v4_load(&RE(cc[ac+6]));
+                v4 = v4_load(&RE(cc[ac+8]));
+                x0 = v4_lo_hi(v0, v2);
+                x1 = v4_hi_lo(v0, v3);
+                x2 = v4_lo_hi(v1, v3);
+                x3 = v4_hi_lo(v1, v4);
+                x4 = v4_lo_hi(v2, v4);
+                ah = k;
+            } else {
+                ac = i + (k*5 + 1) * ido;
+                ah = i + k * ido;
+
+                x0 = v4_load(&RE(cc[ac-ido]));
+                x1 = v4_load(&RE(cc[ac]));
+                x2 = v4_load(&RE(cc[ac+ido]));
+                x3 = v4_load(&RE(cc[ac+2*ido]));
+                x4 = v4_load(&RE(cc[ac+3*ido]));
+            }
+
+            t2 = v4_add(x1, x4);
+            t3 = v4_add(x2, x3);
+            t4 = v4_sub(x2, x3);
+            t5 = v4_sub(x1, x4);
+
+            v4_store(&RE(ch[ah]), v4_add(v4_add(x0, t2), t3));
+
+            c2 = v4_add(v4_add(x0, v4_mul(t2, tr11)), v4_mul(t3, tr12));
+            c3 = v4_add(v4_add(x0, v4_mul(t2, tr12)), v4_mul(t3, tr11));
+            c5 = v4_swap_ri(v4_add(v4_mul(t5, ti11), v4_mul(t4, k5)));
+            c4 = v4_swap_ri(v4_add(v4_mul(t5, ti12), v4_mul(t4, k4)));
+
+            if (ido == 1)
+            {
+                v4_store(&RE(ch[ah+l1]), v4_add(c2, v4_mul(c5, sign)));
+                v4_store(&RE(ch[ah+2*l1]), v4_add(c3, v4_mul(c4, sign)));
+                v4_store(&RE(ch[ah+3*l1]), v4_add(c3, v4_mul(c4, nsign)));
+                v4_store(&RE(ch[ah+4*l1]), v4_add(c2, v4_mul(c5, nsign)));
+            } else {
+                v4_store(&RE(ch[ah+l1*ido]),
+                    v4_cmul(v4_add(c2, v4_mul(c5, sign)), v4_load(&RE(wa1[i])), sign));
+                v4_store(&RE(ch[ah+2*l1*ido]),
+                    v4_cmul(v4_add(c3, v4_mul(c4, sign)), v4_load(&RE(wa2[i])), sign));
+                v4_store(&RE(ch[ah+3*l1*ido]),
+                    v4_cmul(v4_add(c3, v4_mul(c4, nsign)), v4_load(&RE(wa3[i])), sign));
+                v4_store(&RE(ch[ah+4*l1*ido]),
+                    v4_cmul(v4_add(c2, v4_mul(c5, nsign)), v4_load(&RE(wa4[i])), sign));
+            }
+        }
+    }
+}
+
+static const cfft_passes passes_v4 = {
+    passf2pos_v4, passf2neg_v4, passf3_v4, passf4pos_v4, passf4neg_v4, passf5_v4
+};
+#endif
+
+#ifdef SIMD_AVX2
+/* radix 2 and 4 do nearly all the work, radix 3 and 5 (960 and 120
+   point frames) stay with the 4 float versions */
+static SIMD_AVX2_FUNC void passf2_avx2(const uint16_t ido, const uint16_t l1,
+                                       const complex_t *cc, complex_t *ch,
+                                       const complex_t *wa, const float s)
+{
+    const __m256 sign = v8_set(-s, s);
+    uint16_t i, k, ah, ac;
+
+    for (k = 0; k < l1; k++)
+    {
+        ah = k*ido;
+        ac = 2*k*ido;
+
+        for (i = 0; i < ido; i += 4)
+        {
+            __m256 a = v8_load(&RE(cc[ac+i]));
+            __m256 b = v8_load(&RE(cc[ac+i+ido]));
+
+            v8_store(&RE(ch[ah+i]), v8_add(a, b));
+            v8_store(&RE(ch[ah+i+l1*ido]),
+                v8_cmul(v8_sub(a, b), v8_load(&RE(wa[i])), sign));
+        }
+    }
+}
+
+static SIMD_AVX2_FUNC void passf4_avx2(const uint16_t ido, const uint16_t l1,
+                                       const complex_t *cc, complex_t *ch,
+                                       const complex_t *wa1, const complex_t *wa2,
+                                       const complex_t *wa3, const uint8_t pos)
+{
+    const __m256 sign = pos ? v8_set(-1, 1) : v8_set(1, -1);
+    uint16_t i, k, ac, ah;
+
+    for (k = 0; k < l1; k++)
+    {
+        ac = 4*k*ido;
+        ah = k*ido;
+
+        for (i = 0; i < ido; i += 4)
+        {
+            __m256 a, b, c, d, t1, t2, t3, t4, c2, c4;
+
+            a = v8_load(&RE(cc[ac+i]));
+            b = v8_load(&RE(cc[ac+i+ido]));
+            c = v8_load(&RE(cc[ac+i+2*ido]));
+            d = v8_load(&RE(cc[ac+i+3*ido]));
+
+            t2 = v8_add(a, c);
+            t1 = v8_sub(a, c);
+            t3 = v8_add(b, d);
+            t4 = v8_re_im(v8_swap_ri(v8_sub(d, b)), v8_swap_ri(v8_sub(b, d)));
+
+            c2 = pos ? v8_add(t1, t4) : v8_sub(t1, t4);
+            c4 = pos ? v8_sub(t1, t4) : v8_add(t1, t4);
+
+            v8_store(&RE(ch[ah+i]), v8_add(t2, t3));
+            v8_store(&RE(ch[ah+i+l1*ido]),
+                v8_cmul(c2, v8_load(&RE(wa1[i])), sign));
+            v8_store(&RE(ch[ah+i+2*l1*ido]),
+                v8_cmul(v8_sub(t2, t3), v8_load(&RE(wa2[i])), sign));
+            v8_store(&RE(ch[ah+i+3*l1*ido]),
+                v8_cmul(c4, v8_load(&RE(wa3[i])), sign));
+        }
+    }
+}
+
+static void passf2pos_avx2(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                           complex_t *ch, const complex_t *wa)
+{
+    if ((ido == 1) || (ido & 3))
+        passf2pos_v4(ido, l1, cc, ch, wa);
+    else
+        passf2_avx2(ido, l1, cc, ch, wa, 1);
+}
+
+static void passf2neg_avx2(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                           complex_t *ch, const complex_t *wa)
+{
+    if ((ido == 1) || (ido & 3))
+        passf2neg_v4(ido, l1, cc, ch, wa);
+    else
+        passf2_avx2(ido, l1, cc, ch, wa, -1);
+}
+
+static void passf4pos_avx2(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                           complex_t *ch, const complex_t *wa1, const complex_t *wa2,
+                           const complex_t *wa3)
+{
+    if ((ido == 1) || (ido & 3))
+        passf4pos_v4(ido, l1, cc, ch, wa1, wa2, wa3);
+    else
+        passf4_avx2(ido, l1, cc, ch, wa1, wa2, wa3, 1);
+}
+
+static void passf4neg_avx2(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                           complex_t *ch, const complex_t *wa1, const complex_t *wa2,
+                           const complex_t *wa3)
+{
+    if ((ido == 1) || (ido & 3))
+        passf4neg_v4(ido, l1, cc, ch, wa1, wa2, wa3);
+    else
+        passf4_avx2(ido, l1, cc, ch, wa1, wa2, wa3, 0);
+}
+
+static const cfft_passes passes_avx2 = {
+    passf2pos_avx2, passf2neg_avx2, passf3_v4, passf4pos_avx2, passf4neg_avx2, passf5_v4
+};
+#endif
+
+#ifndef SIMD_V4
+static const cfft_passes passes_c = {
+    passf2pos, passf2neg, passf3, passf4pos, passf4neg, passf5
+};
+#endif
+
+#ifdef SIMD_V4
+/*----------------------------------------------------------------------
+   cfftb_x4: four backward transforms at once, one per vector lane
+   (RE4/IM4 layout). Every lane does exactly the operations of the
+   C passes, so the results are identical.
+  ----------------------------------------------------------------------*/
+
+/* y = x*w as in passf*pos */
+static INLINE void cmult_x4(v4sf *y, const v4sf *x, const complex_t *w)
+{
+    const v4sf wr = v4_set1(RE(w[0]));
+    const v4sf wi = v4_set1(IM(w[0]));
+
+    IM4(y, 0) = v4_add(v4_mul(IM4(x, 0), wr), v4_mul(RE4(x, 0), wi));
+    RE4(y, 0) = v4_sub(v4_mul(RE4(x, 0), wr), v4_mul(IM4(x, 0), wi));
+}
+
+static void passf2pos_x4(const uint16_t ido, const uint16_t l1, const v4sf *cc,
+                         v4sf *ch, const complex_t *wa)
+{
+    uint16_t i, k, ah, ac;
+
+    for (k = 0; k < l1; k++)
+    {
+        for (i = 0; i < ido; i++)
+        {
+            v4sf t2[2];
+
+            ah = k*ido + i;
+            ac = 2*k*ido + i;
+
+            RE4(ch, ah) = v4_add(RE4(cc, ac), RE4(cc, ac+ido));
+            RE4(t2, 0)  = v4_sub(RE4(cc, ac), RE4(cc, ac+ido));
+            IM4(ch, ah) = v4_add(IM4(cc, ac), IM4(cc, ac+ido));
+            IM4(t2, 0)  = v4_sub(IM4(cc, ac), IM4(cc, ac+ido));
+
+            if (ido == 1)
+            {
+                RE4(ch, ah+l1) = RE4(t2, 0);
+                IM4(ch, ah+l1) = IM4(t2, 0);
+            } else {
+                cmult_x4(&RE4(ch, ah+l1*ido), t2, &wa[i]);
+            }
+        }
+    }
+}
+
+static void passf3pos_x4(const uint16_t ido, const uint16_t l1, const v4sf *cc,
+                         v4sf *ch, const complex_t *wa1, const complex_t *wa2)
+{
+    const v4sf taur = v4_set1(FRAC_CONST(-0.5));
+    const v4sf taui = v4_set1(FRAC_CONST(0.866025403784439));
+    uint16_t i, k, ac, ah;
+
+    for (k = 0; k < l1; k++)
+    {
+        for (i = 0; i < ido; i++)
+        {
+            v4sf c2[2], c3[2], d2[2], d3[2], t2[2];
+
+            ac = i + (3*k+1)*ido;
+            ah = i + k*ido;
+
+            RE4(t2, 0) = v4_add(RE4(cc, ac), RE4(cc, ac+ido));
+            IM4(t2, 0) = v4_add(IM4(cc, ac), IM4(cc, ac+ido));
+            RE4(c2, 0) = v4_add(RE4(cc, ac-ido), v4_mul(RE4(t2, 0), taur));
+            IM4(c2, 0) = v4_add(IM4(cc, ac-ido), v4_mul(IM4(t2, 0), taur));
+
+            RE4(ch, ah) = v4_add(RE4(cc, ac-ido), RE4(t2, 0));
+            IM4(ch, ah) = v4_add(IM4(cc, ac-ido), IM4(t2, 0));
+
+            RE4(c3, 0) = v4_mul(v4_sub(RE4(cc, ac), RE4(cc, ac+ido)), taui);
+            IM4(c3, 0) = v4_mul(v4_sub(IM4(cc, ac), IM4(cc, ac+ido)), taui);
+
+            RE4(d2, 0) = v4_sub(RE4(c2, 0), IM4(c3, 0));
+            IM4(d2, 0) = v4_add(IM4(c2, 0), RE4(c3, 0));
+            RE4(d3, 0) = v4_add(RE4(c2, 0), IM4(c3, 0));
+            IM4(d3, 0) = v4_sub(IM4(c2, 0), RE4(c3, 0));
+
+            if (ido == 1)
+            {
+                RE4(ch, ah+l1) = RE4(d2, 0);
+                IM4(ch, ah+l1) = IM4(d2, 0);
+                RE4(ch, ah+2*l1) = RE4(d3, 0);
+                IM4(ch, ah+2*l1) = IM4(d3, 0);
+            } else {
+                cmult_x4(&RE4(ch, ah+l1*ido), d2, &wa1[i]);
+                cmult_x4(&RE4(ch, ah+2*l1*ido), d3, &wa2[i]);
+            }
+        }
+    }
+}
+
+static void passf4pos_x4(const uint16_t ido, const uint16_t l1, const v4sf *cc,
+                         v4sf *ch, const complex_t *wa1, const complex_t *wa2,
+                         const complex_t *wa3)
+{
+    uint16_t i, k, ac, ah;
+
+    for (k = 0; k < l1; k++)
+    {
+        for (i = 0; i < ido; i++)
+        {
+            v4sf c2[2], c3[2], c4[2], t1[2], t2[2], t3[2], t4[2];
+
+            ac = 4*k*ido + i;
+            ah = k*ido + i;
+
+            RE4(t2, 0) = v4_add(RE4(cc, ac), RE4(cc, ac+2*ido));
+            RE4(t1, 0) = v4_sub(RE4(cc, ac), RE4(cc, ac+2*ido));
+            IM4(t2, 0) = v4_add(IM4(cc, ac), IM4(cc, ac+2*ido));
+            IM4(t1, 0) = v4_sub(IM4(cc, ac), IM4(cc, ac+2*ido));
+            RE4(t3, 0) = v4_add(RE4(cc, ac+ido), RE4(cc, ac+3*ido));
+            IM4(t4, 0) = v4_sub(RE4(cc, ac+ido), RE4(cc, ac+3*ido));
+            IM4(t3, 0) = v4_add(IM4(cc, ac+3*ido), IM4(cc, ac+ido));
+            RE4(t4, 0) = v4_sub(IM4(cc, ac+3*ido), IM4(cc, ac+ido));
+
+            RE4(c2, 0) = v4_add(RE4(t1, 0), RE4(t4, 0));
+            RE4(c4, 0) = v4_sub(RE4(t1, 0), RE4(t4, 0));
+            IM4(c2, 0) = v4_add(IM4(t1, 0), IM4(t4, 0));
+            IM4(c4, 0) = v4_sub(IM4(t1, 0), IM4(t4, 0));
+
+            RE4(ch, ah) = v4_add(RE4(t2, 0), RE4(t3, 0));
+            RE4(c3, 0)  = v4_sub(RE4(t2, 0), RE4(t3, 0));
+            IM4(ch, ah) = v4_add(IM4(t2, 0), IM4(t3, 0));
+            IM4(c3, 0)  = v4_sub(IM4(t2, 0), IM4(t3, 0));
+
+            if (ido == 1)
+            {
+                RE4(ch, ah+l1) = RE4(c2, 0);
+                IM4(ch, ah+l1) = IM4(c2, 0);
+                RE4(ch, ah+2*l1) = RE4(c3, 0);
+                IM4(ch, ah+2*l1) = IM4(c3, 0);
+                RE4(ch, ah+3*l1) = RE4(c4, 0);
+                IM4(ch, ah+3*l1) = IM4(c4, 0);
+            } else {
+                cmult_x4(&RE4(ch, ah+l1*ido), c2, &wa1[i]);
+                cmult_x4(&RE4(ch, ah+2*l1*ido), c3, &wa2[i]);
+                cmult_x4(&RE4(ch, ah+3*l1*ido), c4, &wa3[i]);
+            }
+        }
+    }
+}
+
+static void passf5pos_x4(const uint16_t ido, const uint16_t l1, const v4sf *cc,
+                         v4sf *ch, const complex_t *wa1, const complex_t *wa2,
+                         const complex_t *wa3, const complex_t *wa4)
+{
+    const v4sf tr11 = v4_set1(FRAC_CONST(0.309016994374947));
+    const v4sf ti11 = v4_set1(FRAC_CONST(0.951056516295154));
+    const v4sf tr12 = v4_set1(FRAC_CONST(-0.809016994374947));
+    const v4sf ti12 = v4_set1(FRAC_CONST(0.587785252292473));
+    uint16_t i, k, ac, ah;
+
+    for (k = 0; k < l1; k++)
+    {
+        for (i = 0; i < ido; i++)
+        {
+            v4sf c2[2], c3[2], c4[2], c5[2], d2[2], d3[2], d4[2], d5[2];
+            v4sf t2[2], t3[2], t4[2], t5[2];
+            uint8_t j;
+
+            ac = i + (k*5 + 1)*ido;
+            ah = i + k*ido;
+
+            for (j = 0; j < 2; j++)
+            {
+                t2[j] = v4_add(cc[2*ac+j], cc[2*(ac+3*ido)+j]);
+                t3[j] = v4_add(cc[2*(ac+ido)+j], cc[2*(ac+2*ido)+j]);
+                t4[j] = v4_sub(cc[2*(ac+ido)+j], cc[2*(ac+2*ido)+j]);
+                t5[j] = v4_sub(cc[2*ac+j], cc[2*(ac+3*ido)+j]);
+
+                ch[2*ah+j] = v4_add(v4_add(cc[2*(ac-ido)+j], t2[j]), t3[j]);
+
+                c2[j] = v4_add(v4_add(cc[2*(ac-ido)+j], v4_mul(t2[j], tr11)), v4_mul(t3[j], tr12));
+                c3[j] = v4_add(v4_add(cc[2*(ac-ido)+j], v4_mul(t2[j], tr12)), v4_mul(t3[j], tr11));
+
+                c5[j] = v4_add(v4_mul(ti11, t5[j]), v4_mul(ti12, t4[j]));
+                c4[j] = v4_sub(v4_mul(ti12, t5[j]), v4_mul(ti11, t4[j]));
+            }
+
+            RE4(d2, 0) = v4_sub(RE4(c2, 0), IM4(c5, 0));
+            IM4(d2, 0) = v4_add(IM4(c2, 0), RE4(c5, 0));
+            RE4(d3, 0) = v4_sub(RE4(c3, 0), IM4(c4, 0));
+            IM4(d3, 0) = v4_add(IM4(c3, 0), RE4(c4, 0));
+            RE4(d4, 0) = v4_add(RE4(c3, 0), IM4(c4, 0));
+            IM4(d4, 0) = v4_sub(IM4(c3, 0), RE4(c4, 0));
+            RE4(d5, 0) = v4_add(RE4(c2, 0), IM4(c5, 0));
+            IM4(d5, 0) = v4_sub(IM4(c2, 0), RE4(c5, 0));
+
+            if (ido == 1)
+            {
+                RE4(ch, ah+l1) = RE4(d2, 0);
+                IM4(ch, ah+l1) = IM4(d2, 0);
+                RE4(ch, ah+2*l1) = RE4(d3, 0);
+                IM4(ch, ah+2*l1) = IM4(d3, 0);
+                RE4(ch, ah+3*l1) = RE4(d4, 0);
+                IM4(ch, ah+3*l1) = IM4(d4, 0);
+                RE4(ch, ah+4*l1) = RE4(d5, 0);
+                IM4(ch, ah+4*l1) = IM4(d5, 0);
+            } else {
+                cmult_x4(&RE4(ch, ah+l1*ido), d2, &wa1[i]);
+                cmult_x4(&RE4(ch, ah+2*l1*ido), d3, &wa2[i]);
+                cmult_x4(&RE4(ch, ah+3*l1*ido), d4, &wa3[i]);
+                cmult_x4(&RE4(ch, ah+4*l1*ido), d5, &wa4[i]);
+            }
+        }
+    }
+}
+
+v4sf *cfftb_x4(cfft_info *cfft, v4sf *c, v4sf *work)
+{
+    const uint16_t *ifac = cfft->ifac;
+    const complex_t *wa = cfft->tab;
+    uint16_t n = cfft->n;
+    uint16_t k1, l1, l2;
+    uint16_t nf, ip, iw, ido;
+    v4sf *in = c, *out = work, *t;
+
+    nf = ifac[1];
+    l1 = 1;
+    iw = 0;
+
+    for (k1 = 2; k1 <= nf+1; k1++)
+    {
+        ip = ifac[k1];
+        l2 = ip*l1;
+        ido = n / l2;
+
+        switch (ip)
+        {
+        case 2:
+            passf2pos_x4(ido, l1, in, out, &wa[iw]);
+            break;
+        case 3:
+            passf3pos_x4(ido, l1, in, out, &wa[iw], &wa[iw+ido]);
+            break;
+        case 4:
+            passf4pos_x4(ido, l1, in, out, &wa[iw], &wa[iw+ido], &wa[iw+2*ido]);
+            break;
+        case 5:
+            passf5pos_x4(ido, l1, in, out, &wa[iw], &wa[iw+ido], &wa[iw+2*ido], &wa[iw+3*ido]);
+            break;
+        }
+
+        t = in;
+        in = out;
+        out = t;
+
+        l1 = l2;
+        iw += (ip-1) * ido;
+    }
+
+    return in;
+}
+#endif
+
 
 /*----------------------------------------------------------------------
    cfftf1, cfftf, cfftb, cffti1, cffti. Complex FFTs.
   ----------------------------------------------------------------------*/
 
-static INLINE void cfftf1pos(uint16_t n, complex_t *c, complex_t *ch,
-                             const uint16_t *ifac, const complex_t *wa,
-                             const int8_t isign)
+static INLINE complex_t *cfftf1pos(uint16_t n, complex_t *c, complex_t *ch,
+                                   const uint16_t *ifac, const complex_t *wa,
+                                   const cfft_passes *p, const int8_t isign)
 {
-    uint16_t i;
     uint16_t k1, l1, l2;
     uint16_t na, nf, ip, iw, ix2, ix3, ix4, ido, idl1;
 
@@ -717,17 +1370,17 @@ static INLINE void cfftf1pos(uint16_t n, complex_t *c, complex_t *ch,
             ix3 = ix2 + ido;
 
             if (na == 0)
-                passf4pos((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw], &wa[ix2], &wa[ix3]);
+                p->passf4pos((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw], &wa[ix2], &wa[ix3]);
             else
-                passf4pos((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw], &wa[ix2], &wa[ix3]);
+                p->passf4pos((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw], &wa[ix2], &wa[ix3]);
 
             na = 1 - na;
             break;
         case 2:
             if (na == 0)
-                passf2pos((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw]);
+                p->passf2pos((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw]);
             else
-                passf2pos((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw]);
+                p->passf2pos((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw]);
 
             na = 1 - na;
             break;
@@ -735,9 +1388,9 @@ static INLINE void cfftf1pos(uint16_t n, complex_t *c, complex_t *ch,
             ix2 = iw + ido;
 
             if (na == 0)
-                passf3((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw], &wa[ix2], isign);
+                p->passf3((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw], &wa[ix2], isign);
             else
-                passf3((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw], &wa[ix2], isign);
+                p->passf3((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw], &wa[ix2], isign);
 
             na = 1 - na;
             break;
@@ -747,9 +1400,9 @@ static INLINE void cfftf1pos(uint16_t n, complex_t *c, complex_t *ch,
             ix4 = ix3 + ido;
 
             if (na == 0)
-                passf5((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw], &wa[ix2], &wa[ix3], &wa[ix4], isign);
+                p->passf5((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw], &wa[ix2], &wa[ix3], &wa[ix4], isign);
             else
-                passf5((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw], &wa[ix2], &wa[ix3], &wa[ix4], isign);
+                p->passf5((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw], &wa[ix2], &wa[ix3], &wa[ix4], isign);
 
             na = 1 - na;
             break;
@@ -759,21 +1412,13 @@ static INLINE void cfftf1pos(uint16_t n, complex_t *c, complex_t *ch,
         iw += (ip-1) * ido;
     }
 
-    if (na == 0)
-        return;
-
-    for (i = 0; i < n; i++)
-    {
-        RE(c[i]) = RE(ch[i]);
-        IM(c[i]) = IM(ch[i]);
-    }
+    return (na == 0) ? c : ch;
 }
 
-static INLINE void cfftf1neg(uint16_t n, complex_t *c, complex_t *ch,
-                             const uint16_t *ifac, const complex_t *wa,
-                             const int8_t isign)
+static INLINE complex_t *cfftf1neg(uint16_t n, complex_t *c, complex_t *ch,
+                                   const uint16_t *ifac, const complex_t *wa,
+                                   const cfft_passes *p, const int8_t isign)
 {
-    uint16_t i;
     uint16_t k1, l1, l2;
     uint16_t na, nf, ip, iw, ix2, ix3, ix4, ido, idl1;
 
@@ -796,17 +1441,17 @@ static INLINE void cfftf1neg(uint16_t n, complex_t *c, complex_t *ch,
             ix3 = ix2 + ido;
 
             if (na == 0)
-                passf4neg((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw], &wa[ix2], &wa[ix3]);
+                p->passf4neg((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw], &wa[ix2], &wa[ix3]);
             else
-                passf4neg((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw], &wa[ix2], &wa[ix3]);
+                p->passf4neg((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw], &wa[ix2], &wa[ix3]);
 
             na = 1 - na;
             break;
         case 2:
             if (na == 0)
-                passf2neg((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw]);
+                p->passf2neg((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw]);
             else
-                passf2neg((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw]);
+                p->passf2neg((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw]);
 
             na = 1 - na;
             break;
@@ -814,9 +1459,9 @@ static INLINE void cfftf1neg(uint16_t n, complex_t *c, complex_t *ch,
             ix2 = iw + ido;
 
             if (na == 0)
-                passf3((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw], &wa[ix2], isign);
+                p->passf3((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw], &wa[ix2], isign);
             else
-                passf3((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw], &wa[ix2], isign);
+                p->passf3((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw], &wa[ix2], isign);
 
             na = 1 - na;
             break;
@@ -826,9 +1471,9 @@ static INLINE void cfftf1neg(uint16_t n, complex_t *c, complex_t *ch,
             ix4 = ix3 + ido;
 
             if (na == 0)
-                passf5((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw], &wa[ix2], &wa[ix3], &wa[ix4], isign);
+                p->passf5((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)c, ch, &wa[iw], &wa[ix2], &wa[ix3], &wa[ix4], isign);
             else
-                passf5((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw], &wa[ix2], &wa[ix3], &wa[ix4], isign);
+                p->passf5((const uint16_t)ido, (const uint16_t)l1, (const complex_t*)ch, c, &wa[iw], &wa[ix2], &wa[ix3], &wa[ix4], isign);
 
             na = 1 - na;
             break;
@@ -838,8 +1483,12 @@ static INLINE void cfftf1neg(uint16_t n, complex_t *c, complex_t *ch,
         iw += (ip-1) * ido;
     }
 
-    if (na == 0)
-        return;
+    return (na == 0) ? c : ch;
+}
+
+static void cfft_copy(uint16_t n, complex_t *c, const complex_t *ch)
+{
+    uint16_t i;
 
     for (i = 0; i < n; i++)
     {
@@ -850,12 +1499,32 @@ static INLINE void cfftf1neg(uint16_t n, complex_t *c, complex_t *ch,
 
 void cfftf(cfft_info *cfft, complex_t *c)
 {
-    cfftf1neg(cfft->n, c, cfft->work, (const uint16_t*)cfft->ifac, (const complex_t*)cfft->tab, -1);
+    ALIGN complex_t work[CFFT_MAX_N];
+    complex_t *res;
+
+    res = cfftf_buf(cfft, c, work);
+    if (res != c)
+        cfft_copy(cfft->n, c, (const complex_t*)res);
 }
 
 void cfftb(cfft_info *cfft, complex_t *c)
 {
-    cfftf1pos(cfft->n, c, cfft->work, (const uint16_t*)cfft->ifac, (const complex_t*)cfft->tab, +1);
+    ALIGN complex_t work[CFFT_MAX_N];
+    complex_t *res;
+
+    res = cfftb_buf(cfft, c, work);
+    if (res != c)
+        cfft_copy(cfft->n, c, (const complex_t*)res);
+}
+
+complex_t *cfftf_buf(cfft_info *cfft, complex_t *c, complex_t *work)
+{
+    return cfftf1neg(cfft->n, c, work, (const uint16_t*)cfft->ifac, (const complex_t*)cfft->tab, cfft->passes, -1);
+}
+
+complex_t *cfftb_buf(cfft_info *cfft, complex_t *c, complex_t *work)
+{
+    return cfftf1pos(cfft->n, c, work, (const uint16_t*)cfft->ifac, (const complex_t*)cfft->tab, cfft->passes, +1);
 }
 
 static void cffti1(uint16_t n, complex_t *wa, uint16_t *ifac)
@@ -960,7 +1629,14 @@ cfft_info *cffti(uint16_t n)
     cfft_info *cfft = (cfft_info*)faad_malloc(sizeof(cfft_info));
 
     cfft->n = n;
-    cfft->work = (complex_t*)faad_malloc(n*sizeof(complex_t));
+
+#if defined(SIMD_AVX2)
+    cfft->passes = cpu_has_avx2() ? &passes_avx2 : &passes_v4;
+#elif defined(SIMD_V4)
+    cfft->passes = &passes_v4;
+#else
+    cfft->passes = &passes_c;
+#endif
 
 #ifndef FIXED_POINT
     cfft->tab = (complex_t*)faad_malloc(n*sizeof(complex_t));
@@ -993,7 +1669,6 @@ cfft_info *cffti(uint16_t n)
 
 void cfftu(cfft_info *cfft)
 {
-    if (cfft->work) faad_free(cfft->work);
 #ifndef FIXED_POINT
     if (cfft->tab) faad_free(cfft->tab);
 #endif
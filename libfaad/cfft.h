@@ -31,21 +31,57 @@
 #ifndef __CFFT_H__
 #define __CFFT_H__
 
+#include "simd.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* largest supported transform size (2048 point MDCT) */
+#define CFFT_MAX_N 512
+
+/* butterflies, C or SIMD versions picked by cffti() */
+typedef struct
+{
+    void (*passf2pos)(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                      complex_t *ch, const complex_t *wa);
+    void (*passf2neg)(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                      complex_t *ch, const complex_t *wa);
+    void (*passf3)(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                   complex_t *ch, const complex_t *wa1, const complex_t *wa2,
+                   const int8_t isign);
+    void (*passf4pos)(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                      complex_t *ch, const complex_t *wa1, const complex_t *wa2,
+                      const complex_t *wa3);
+    void (*passf4neg)(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                      complex_t *ch, const complex_t *wa1, const complex_t *wa2,
+                      const complex_t *wa3);
+    void (*passf5)(const uint16_t ido, const uint16_t l1, const complex_t *cc,
+                   complex_t *ch, const complex_t *wa1, const complex_t *wa2,
+                   const complex_t *wa3, const complex_t *wa4, const int8_t isign);
+} cfft_passes;
+
+/* read only after cffti(), so it can be shared between decoders */
 typedef struct
 {
     uint16_t n;
     uint16_t ifac[15];
-    complex_t *work;
     complex_t *tab;
+    const cfft_passes *passes;
 } cfft_info;
 
 
 void cfftf(cfft_info *cfft, complex_t *c);
 void cfftb(cfft_info *cfft, complex_t *c);
+/* same, but with the caller's scratch buffer of n values; the result is
+   left in c or in work, whichever is returned, saving the copy back */
+complex_t *cfftf_buf(cfft_info *cfft, complex_t *c, complex_t *work);
+complex_t *cfftb_buf(cfft_info *cfft, complex_t *c, complex_t *work);
+#ifdef SIMD_V4
+/* four backward transforms in the lanes of c (RE4/IM4 layout), result
+   in c or work */
+v4sf *cfftb_x4(cfft_info *cfft, v4sf *c, v4sf *work);
+#endif
 cfft_info *cffti(uint16_t n);
 void cfftu(cfft_info *cfft);
 
@@ -36,6 +36,11 @@
 #include <stdlib.h>
 #include "syntax.h"
 
+#if defined(SIMD_AVX2) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
 
 /* Returns the sample rate index based on the samplerate */
 uint8_t get_sr_index(const uint32_t samplerate)
@@ -172,24 +177,141 @@ int8_t can_decode_ot(const uint8_t object_type)
     return -1;
 }
 
-void *faad_malloc(size_t size)
+#ifdef SIMD_AVX2
+/* AVX2 needs support by both the CPU and the OS (saving the YMM registers) */
+uint8_t cpu_has_avx2(void)
+{
+#if defined(_MSC_VER)
+    int regs[4];
+
+    __cpuid(regs, 0);
+    if (regs[0] < 7)
+        return 0;
+
+    __cpuid(regs, 1);
+    /* OSXSAVE and AVX */
+    if ((regs[2] & 0x18000000) != 0x18000000)
+        return 0;
+    if ((_xgetbv(0) & 6) != 6)
+        return 0;
+
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) ? 1 : 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+}
+#endif
+
+#if defined(_MSC_VER)
+#define FAAD_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define FAAD_THREAD_LOCAL __thread
+#else
+/* no thread local storage: custom allocators must not be used from
+   several threads at the same time */
+#define FAAD_THREAD_LOCAL
+#endif
+
+/* allocator of the decoder handle the current thread is working on,
+   NULL means plain malloc()/free() */
+static FAAD_THREAD_LOCAL faad_allocator *cur_allocator = NULL;
+
+/* makes allocator the current one and returns the previous one */
+faad_allocator *faad_set_allocator(faad_allocator *allocator)
+{
+    faad_allocator *prev = cur_allocator;
+    cur_allocator = allocator;
+    return prev;
+}
+
+static void *allocator_malloc(faad_allocator *a, size_t size)
 {
-#if 0 // defined(_WIN32) && !defined(_WIN32_WCE)
-    return _aligned_malloc(size, 16);
-#else   // #ifdef 0
+    if ((a != NULL) && (a->malloc_func != NULL))
+        return a->malloc_func(a->user_data, (unsigned long)size);
     return malloc(size);
-#endif  // #ifdef 0
+}
+
+static void allocator_free(faad_allocator *a, void *b)
+{
+    if ((a != NULL) && (a->free_func != NULL))
+        a->free_func(a->user_data, b);
+    else
+        free(b);
+}
+
+/* allocates the arena, blocks that don't fit fall back to the callbacks */
+void faad_arena_init(faad_allocator *a, uint32_t size)
+{
+    if (a->arena_block != NULL)
+        return;
+
+    size = (size + FAAD_ARENA_ALIGN-1) & ~(FAAD_ARENA_ALIGN-1);
+    a->arena_block = allocator_malloc(a, size + FAAD_ARENA_ALIGN-1);
+    if (a->arena_block == NULL)
+        return;
+
+    a->arena = (uint8_t*)(((size_t)a->arena_block + FAAD_ARENA_ALIGN-1) &
+        ~(size_t)(FAAD_ARENA_ALIGN-1));
+    a->arena_size = size;
+    a->arena_used = 0;
+    a->arena_last = NULL;
+}
+
+void faad_arena_end(faad_allocator *a)
+{
+    if (a->arena_block != NULL)
+        allocator_free(a, a->arena_block);
+    a->arena_block = NULL;
+    a->arena = NULL;
+    a->arena_size = 0;
+    a->arena_used = 0;
+    a->arena_last = NULL;
+}
+
+void *faad_malloc(size_t size)
+{
+    faad_allocator *a = cur_allocator;
+
+    if ((a != NULL) && (a->arena != NULL))
+    {
+        size_t aligned = (size + FAAD_ARENA_ALIGN-1) & ~(size_t)(FAAD_ARENA_ALIGN-1);
+
+        if (aligned <= (size_t)(a->arena_size - a->arena_used))
+        {
+            a->arena_last = a->arena + a->arena_used;
+            a->arena_used += (uint32_t)aligned;
+            return a->arena_last;
+        }
+    }
+
+    return allocator_malloc(a, size);
 }
 
 /* common free function */
 void faad_free(void *b)
 {
-#if 0 // defined(_WIN32) && !defined(_WIN32_WCE)
-    _aligned_free(b);
-#else
-    free(b);
+    faad_allocator *a = cur_allocator;
+
+    if (b == NULL)
+        return;
+
+    if ((a != NULL) && (a->arena != NULL) &&
+        ((uint8_t*)b >= a->arena) && ((uint8_t*)b < a->arena + a->arena_size))
+    {
+        /* arena blocks are released with the arena, except the most
+           recent one, so short lived buffers don't use it up */
+        if ((uint8_t*)b == a->arena_last)
+        {
+            a->arena_used = (uint32_t)(a->arena_last - a->arena);
+            a->arena_last = NULL;
+        }
+        return;
+    }
+
+    allocator_free(a, b);
 }
-#endif
 
 static const  uint8_t    Parity [256] = {  // parity
     0,1,1,0,1,0,0,1,1,0,0,1,0,1,1,0,1,0,0,1,0,1,1,0,0,1,1,0,1,0,0,1,
@@ -67,6 +67,9 @@ extern "C" {
 /* use fixed point reals */
 //#define FIXED_POINT
 //#define BIG_IQ_TABLE
+/* floating point: keep only the first 256 values of the inverse
+   quantisation table (1 KB instead of 32 KB), compute the others */
+//#define SMALL_IQ_TABLE
 
 /* Use if target platform has address generators with autoincrement */
 //#define PREFER_POINTERS
@@ -408,9 +411,59 @@ typedef real_t complex_t[2];
 #define RE(A) A[0]
 #define IM(A) A[1]
 
+/* SIMD versions of the floating point hot paths (see simd.h). SSE2 and
+   NEON are part of the x86-64 and aarch64 baselines, AVX2 is only used
+   when cpu_has_avx2() says so. Scalar math must not use the x87 FPU,
+   or the SIMD results would not match it. */
+#if !defined(FIXED_POINT) && !defined(USE_DOUBLE_PRECISION) && !defined(NO_SIMD)
+#if defined(__SSE2_MATH__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SIMD_SSE2
+#if defined(__GNUC__) || defined(_MSC_VER)
+#define SIMD_AVX2
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_NEON
+#endif
+#endif
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+#define SIMD_V4 /* 4 x float vectors */
+#endif
+
+/* Layout of the [time][64] QMF matrices (Xsbr, the synthesis input and
+   the PS input/output). With QMF_SOA a row holds the 64 real parts
+   followed by the 64 imaginary parts, so four subbands load into one
+   vector without deinterleaving. It is used when SIMD is on, NO_QMF_SOA
+   keeps the interleaved complex_t rows. Access the elements with
+   QMF_ROW_RE()/QMF_ROW_IM(). */
+#if defined(SIMD_V4) && !defined(SBR_LOW_POWER) && !defined(NO_QMF_SOA)
+#define QMF_SOA
+#endif
+
+#ifdef QMF_SOA
+typedef real_t qmf_row_t[2*64];
+#define QMF_ROW_RE(R, k) (R)[k]
+#define QMF_ROW_IM(R, k) (R)[64+(k)]
+#else
+typedef qmf_t qmf_row_t[64];
+#define QMF_ROW_RE(R, k) QMF_RE((R)[k])
+#define QMF_ROW_IM(R, k) QMF_IM((R)[k])
+#endif
+
+/* for the QMF matrices on the stack, 64 bytes keeps every row on its
+   own cache lines */
+#if defined(_MSC_VER)
+#define ALIGN64 __declspec(align(64))
+#elif defined(__GNUC__)
+#define ALIGN64 __attribute__((aligned(64)))
+#else
+#define ALIGN64
+#endif
+
 
 /* common functions */
-uint8_t cpu_has_sse(void);
+#ifdef SIMD_AVX2
+uint8_t cpu_has_avx2(void);
+#endif
 uint32_t ne_rng(uint32_t *__r1, uint32_t *__r2);
 uint32_t wl_min_lzc(uint32_t x);
 #ifdef FIXED_POINT
@@ -430,6 +483,27 @@ int8_t can_decode_ot(const uint8_t object_type);
 void *faad_malloc(size_t size);
 void faad_free(void *b);
 
+/* allocator used by faad_malloc()/faad_free() on the calling thread */
+#define FAAD_ARENA_ALIGN 64 /* cache line */
+typedef struct
+{
+    NeAACDecMallocFunc malloc_func;
+    NeAACDecFreeFunc free_func;
+    void *user_data;
+
+    /* arena mode: all blocks are carved from one aligned block */
+    uint8_t use_arena;
+    void *arena_block;
+    uint8_t *arena;
+    uint32_t arena_size;
+    uint32_t arena_used;
+    uint8_t *arena_last;
+} faad_allocator;
+
+faad_allocator *faad_set_allocator(faad_allocator *allocator);
+void faad_arena_init(faad_allocator *allocator, uint32_t size);
+void faad_arena_end(faad_allocator *allocator);
+
 //#define PROFILE
 #ifdef PROFILE
 static int64_t faad_get_ts()
@@ -37,10 +37,15 @@
 
 #include "mp4.h"
 #include "syntax.h"
+#include "huffman.h"
+#include "specrec.h"
 #include "error.h"
 #include "output.h"
 #include "filtbank.h"
 #include "drc.h"
+#ifdef LTP_DEC
+#include "lt_predict.h"
+#endif
 #ifdef SBR_DEC
 #include "sbr_dec.h"
 #include "sbr_syntax.h"
@@ -66,6 +71,17 @@ static void* aac_frame_decode(NeAACDecStruct *hDecoder,
                               unsigned long sample_buffer_size);
 static void create_channel_config(NeAACDecStruct *hDecoder,
                                   NeAACDecFrameInfo *hInfo);
+static uint8_t frame_layout_changed(NeAACDecStruct *hDecoder);
+static void frame_layout_update(NeAACDecStruct *hDecoder);
+static void init_arena(NeAACDecStruct *hDecoder, uint8_t channels);
+static void reset_frame_state(NeAACDecStruct *hDecoder);
+
+/* size of one output sample in bytes, indexed by outputFormat-1 */
+static const uint8_t sample_size[] = { sizeof(int16_t), sizeof(int32_t), sizeof(int32_t),
+    sizeof(float32_t), sizeof(double), sizeof(int16_t), sizeof(int16_t),
+    sizeof(int16_t), sizeof(int16_t), sizeof(int16_t), sizeof(int32_t),
+    sizeof(float32_t)
+};
 
 
 int NeAACDecGetVersion(char **faad_id_string,
@@ -121,15 +137,45 @@ unsigned long NeAACDecGetCapabilities(void)
 
 const unsigned char mes[] = { 0x67,0x20,0x61,0x20,0x20,0x20,0x6f,0x20,0x72,0x20,0x65,0x20,0x6e,0x20,0x20,0x20,0x74,0x20,0x68,0x20,0x67,0x20,0x69,0x20,0x72,0x20,0x79,0x20,0x70,0x20,0x6f,0x20,0x63 };
 NeAACDecHandle NeAACDecOpen(void)
+{
+    return NeAACDecOpenWithAllocator(NULL, NULL, NULL, FAAD_ALLOC_DEFAULT);
+}
+
+NeAACDecHandle NeAACDecOpenWithAllocator(NeAACDecMallocFunc malloc_func,
+                                         NeAACDecFreeFunc free_func,
+                                         void *user_data,
+                                         unsigned char mode)
 {
     uint8_t i;
     NeAACDecStruct *hDecoder = NULL;
+    faad_allocator allocator, *prev;
+
+    /* callbacks only come in pairs */
+    if ((malloc_func == NULL) != (free_func == NULL))
+        return NULL;
+    if (mode > FAAD_ALLOC_ARENA)
+        return NULL;
+
+    /* spectral huffman lookahead tables, shared by all decoders */
+    huffman_init();
 
-    if ((hDecoder = (NeAACDecStruct*)faad_malloc(sizeof(NeAACDecStruct))) == NULL)
+    memset(&allocator, 0, sizeof(faad_allocator));
+    allocator.malloc_func = malloc_func;
+    allocator.free_func = free_func;
+    allocator.user_data = user_data;
+    allocator.use_arena = (mode == FAAD_ALLOC_ARENA);
+
+    prev = faad_set_allocator(&allocator);
+    hDecoder = (NeAACDecStruct*)faad_malloc(sizeof(NeAACDecStruct));
+    faad_set_allocator(prev);
+    if (hDecoder == NULL)
         return NULL;
 
     memset(hDecoder, 0, sizeof(NeAACDecStruct));
 
+    hDecoder->allocator = allocator;
+    prev = faad_set_allocator(&hDecoder->allocator);
+
     hDecoder->cmes = mes;
     hDecoder->config.outputFormat  = FAAD_FMT_16BIT;
     hDecoder->config.defObjectType = MAIN;
@@ -150,6 +196,13 @@ NeAACDecHandle NeAACDecOpen(void)
 
     hDecoder->__r1 = 1;
     hDecoder->__r2 = 1;
+    hDecoder->dither_state[0] = 0x2545f491;
+    hDecoder->dither_state[1] = 0x9e3779b9;
+    hDecoder->dither_state[2] = 0x6a09e667;
+    hDecoder->dither_state[3] = 0xbb67ae85;
+#ifdef SIMD_AVX2
+    hDecoder->use_avx2 = cpu_has_avx2();
+#endif
 
     for (i = 0; i < MAX_CHANNELS; i++)
     {
@@ -157,6 +210,7 @@ NeAACDecHandle NeAACDecOpen(void)
         hDecoder->window_shape_prev[i] = 0;
         hDecoder->time_out[i] = NULL;
         hDecoder->fb_intermed[i] = NULL;
+        hDecoder->fb_intermed_zero[i] = 0;
 #ifdef SSR_DEC
         hDecoder->ssr_overlap[i] = NULL;
         hDecoder->prev_fmd[i] = NULL;
@@ -179,6 +233,10 @@ NeAACDecHandle NeAACDecOpen(void)
 
     hDecoder->drc = drc_init(REAL_CONST(1.0), REAL_CONST(1.0));
 
+    hDecoder->fr_job = &hDecoder->frame_jobs[0];
+
+    faad_set_allocator(prev);
+
     return hDecoder;
 }
 
@@ -213,17 +271,22 @@ unsigned char NeAACDecSetConfiguration(NeAACDecHandle hpDecoder,
 
         /* check output format */
 #ifdef FIXED_POINT
-        if ((config->outputFormat < 1) || (config->outputFormat > 4))
+        if (((config->outputFormat < 1) || (config->outputFormat > 4)) &&
+            (config->outputFormat != FAAD_FMT_16BIT_DITHER) &&
+            ((config->outputFormat < FAAD_FMT_16BIT_PLANAR) || (config->outputFormat > FAAD_FMT_FIXED_PLANAR)))
             return 0;
 #else
-        if ((config->outputFormat < 1) || (config->outputFormat > 5))
+        if (((config->outputFormat < 1) || (config->outputFormat > 6)) &&
+            ((config->outputFormat < FAAD_FMT_16BIT_PLANAR) || (config->outputFormat > FAAD_FMT_FLOAT_PLANAR)))
             return 0;
 #endif
         hDecoder->config.outputFormat = config->outputFormat;
 
-        if (config->downMatrix > 1)
+        if (config->downMatrix > FAAD_DOWNMIX_SPECTRAL)
             return 0;
         hDecoder->config.downMatrix = config->downMatrix;
+        hDecoder->config.channelMask = config->channelMask;
+        hDecoder->config.dontDecodeSBR = config->dontDecodeSBR;
 
         /* OK */
         return 1;
@@ -237,7 +300,7 @@ static int latmCheck(latm_header *latm, bitfile *ld)
 {
     uint32_t good=0, bad=0, bits, m;
 
-    while (ld->bytes_left)
+    while (faad_get_processed_bits(ld) < 8*ld->buffer_size)
     {
         bits = faad_latm_frame(latm, ld);
         if(bits==0xFFFFFFFF)
@@ -258,22 +321,19 @@ static int latmCheck(latm_header *latm, bitfile *ld)
 }
 
 
-long NeAACDecInit(NeAACDecHandle hpDecoder,
-                              unsigned char *buffer,
-                              unsigned long buffer_size,
-                              unsigned long *samplerate,
-                              unsigned char *channels)
+static long decoder_init(NeAACDecStruct *hDecoder,
+                         unsigned char *buffer,
+                         unsigned long buffer_size,
+                         unsigned long *samplerate,
+                         unsigned char *channels)
 {
     uint32_t bits = 0;
     bitfile ld;
     adif_header adif;
     adts_header adts;
-    NeAACDecStruct* hDecoder = (NeAACDecStruct*)hpDecoder;
 
 
-    if ((hDecoder == NULL) || (samplerate == NULL) || (channels == NULL))
-        return -1;
-
+    hDecoder->layout_valid = 0;
     hDecoder->sf_index = get_sr_index(hDecoder->config.defSampleRate);
     hDecoder->object_type = hDecoder->config.defObjectType;
     *samplerate = get_sample_rate(hDecoder->sf_index);
@@ -362,16 +422,19 @@ long NeAACDecInit(NeAACDecHandle hpDecoder,
     hDecoder->channelConfiguration = *channels;
 
 #ifdef SBR_DEC
-    /* implicit signalling */
-    if (*samplerate <= 24000 && (hDecoder->config.dontUpSampleImplicitSBR == 0))
+    /* implicit signalling, ignored when only the core is decoded */
+    hDecoder->core_only = hDecoder->config.dontDecodeSBR;
+    if (*samplerate <= 24000 && (hDecoder->config.dontUpSampleImplicitSBR == 0) && !hDecoder->core_only)
     {
         *samplerate *= 2;
         hDecoder->forceUpSampling = 1;
-    } else if (*samplerate > 24000 && (hDecoder->config.dontUpSampleImplicitSBR == 0)) {
+    } else if (*samplerate > 24000 && (hDecoder->config.dontUpSampleImplicitSBR == 0) && !hDecoder->core_only) {
         hDecoder->downSampledSBR = 1;
     }
 #endif
 
+    init_arena(hDecoder, *channels);
+
     /* must be done before frameLength is divided by 2 for LD */
 #ifdef SSR_DEC
     if (hDecoder->object_type == SSR)
@@ -391,26 +454,36 @@ long NeAACDecInit(NeAACDecHandle hpDecoder,
     return bits;
 }
 
-/* Init the library using a DecoderSpecificInfo */
-char NeAACDecInit2(NeAACDecHandle hpDecoder,
-                               unsigned char *pBuffer,
-                               unsigned long SizeOfDecoderSpecificInfo,
-                               unsigned long *samplerate,
-                               unsigned char *channels)
+long NeAACDecInit(NeAACDecHandle hpDecoder,
+                              unsigned char *buffer,
+                              unsigned long buffer_size,
+                              unsigned long *samplerate,
+                              unsigned char *channels)
 {
     NeAACDecStruct* hDecoder = (NeAACDecStruct*)hpDecoder;
-    int8_t rc;
-    mp4AudioSpecificConfig mp4ASC;
+    faad_allocator *prev;
+    long ret;
 
-    if((hDecoder == NULL)
-        || (pBuffer == NULL)
-        || (SizeOfDecoderSpecificInfo < 2)
-        || (samplerate == NULL)
-        || (channels == NULL))
-    {
+    if ((hDecoder == NULL) || (samplerate == NULL) || (channels == NULL))
         return -1;
-    }
 
+    prev = faad_set_allocator(&hDecoder->allocator);
+    ret = decoder_init(hDecoder, buffer, buffer_size, samplerate, channels);
+    faad_set_allocator(prev);
+
+    return ret;
+}
+
+static char decoder_init2(NeAACDecStruct *hDecoder,
+                          unsigned char *pBuffer,
+                          unsigned long SizeOfDecoderSpecificInfo,
+                          unsigned long *samplerate,
+                          unsigned char *channels)
+{
+    int8_t rc;
+    mp4AudioSpecificConfig mp4ASC;
+
+    hDecoder->layout_valid = 0;
     hDecoder->adif_header_present = 0;
     hDecoder->adts_header_present = 0;
 
@@ -455,6 +528,16 @@ char NeAACDecInit2(NeAACDecHandle hpDecoder,
     {
         hDecoder->sf_index = get_sr_index(mp4ASC.samplingFrequency / 2);
     }
+
+    /* core only: decoded as if the stream had no SBR, at the core samplerate */
+    hDecoder->core_only = hDecoder->config.dontDecodeSBR;
+    if (hDecoder->core_only)
+    {
+        *samplerate = get_sample_rate(hDecoder->sf_index);
+        hDecoder->sbr_present_flag = 0;
+        hDecoder->downSampledSBR = 0;
+        hDecoder->forceUpSampling = 0;
+    }
 #endif
 
     if (rc != 0)
@@ -469,6 +552,8 @@ char NeAACDecInit2(NeAACDecHandle hpDecoder,
         return -1;
 #endif
 
+    init_arena(hDecoder, *channels);
+
     /* must be done before frameLength is divided by 2 for LD */
 #ifdef SSR_DEC
     if (hDecoder->object_type == SSR)
@@ -485,18 +570,55 @@ char NeAACDecInit2(NeAACDecHandle hpDecoder,
     return 0;
 }
 
+/* Init the library using a DecoderSpecificInfo */
+char NeAACDecInit2(NeAACDecHandle hpDecoder,
+                               unsigned char *pBuffer,
+                               unsigned long SizeOfDecoderSpecificInfo,
+                               unsigned long *samplerate,
+                               unsigned char *channels)
+{
+    NeAACDecStruct* hDecoder = (NeAACDecStruct*)hpDecoder;
+    faad_allocator *prev;
+    char ret;
+
+    if((hDecoder == NULL)
+        || (pBuffer == NULL)
+        || (SizeOfDecoderSpecificInfo < 2)
+        || (samplerate == NULL)
+        || (channels == NULL))
+    {
+        return -1;
+    }
+
+    prev = faad_set_allocator(&hDecoder->allocator);
+    ret = decoder_init2(hDecoder, pBuffer, SizeOfDecoderSpecificInfo,
+        samplerate, channels);
+    faad_set_allocator(prev);
+
+    return ret;
+}
+
 #ifdef DRM
 char NeAACDecInitDRM(NeAACDecHandle *hpDecoder,
                                  unsigned long samplerate,
                                  unsigned char channels)
 {
     NeAACDecStruct** hDecoder = (NeAACDecStruct**)hpDecoder;
+    faad_allocator allocator, *prev;
     if (hDecoder == NULL)
         return 1; /* error */
 
+    /* the new handle keeps the allocator of the old one */
+    memset(&allocator, 0, sizeof(faad_allocator));
+    if (*hDecoder != NULL)
+        allocator = (*hDecoder)->allocator;
+
     NeAACDecClose(*hDecoder);
 
-    *hDecoder = NeAACDecOpen();
+    *hDecoder = NeAACDecOpenWithAllocator(allocator.malloc_func, allocator.free_func,
+        allocator.user_data, allocator.use_arena ? FAAD_ALLOC_ARENA : FAAD_ALLOC_DEFAULT);
+    if (*hDecoder == NULL)
+        return 1;
 
     /* Special object type defined for DRM */
     (*hDecoder)->config.defObjectType = DRM_ER_LC;
@@ -523,7 +645,10 @@ char NeAACDecInitDRM(NeAACDecHandle *hpDecoder,
         (*hDecoder)->sbr_present_flag = 1;
 #endif
 
+    prev = faad_set_allocator(&(*hDecoder)->allocator);
+    init_arena(*hDecoder, (*hDecoder)->channelConfiguration);
     (*hDecoder)->fb = filter_bank_init((*hDecoder)->frameLength);
+    faad_set_allocator(prev);
 
     return 0;
 }
@@ -533,10 +658,13 @@ void NeAACDecClose(NeAACDecHandle hpDecoder)
 {
     uint8_t i;
     NeAACDecStruct* hDecoder = (NeAACDecStruct*)hpDecoder;
+    faad_allocator allocator, *prev;
 
     if (hDecoder == NULL)
         return;
 
+    prev = faad_set_allocator(&hDecoder->allocator);
+
 #ifdef PROFILE
     printf("AAC decoder total:  %I64d cycles\n", hDecoder->cycles);
     printf("requant:            %I64d cycles\n", hDecoder->requant_cycles);
@@ -560,6 +688,8 @@ void NeAACDecClose(NeAACDecHandle hpDecoder)
         if (hDecoder->lt_pred_stat[i]) faad_free(hDecoder->lt_pred_stat[i]);
 #endif
     }
+    if (hDecoder->dm_overlap[0]) faad_free(hDecoder->dm_overlap[0]);
+    if (hDecoder->dm_overlap[1]) faad_free(hDecoder->dm_overlap[1]);
 
 #ifdef SSR_DEC
     if (hDecoder->object_type == SSR)
@@ -580,7 +710,21 @@ void NeAACDecClose(NeAACDecHandle hpDecoder)
     }
 #endif
 
-    if (hDecoder) faad_free(hDecoder);
+    faad_pool_destroy(hDecoder->syn_pool);
+    faad_pool_destroy(hDecoder->ele_pool);
+    for (i = 0; i < MAX_SYNTAX_ELEMENTS; i++)
+    {
+        if (hDecoder->frame_jobs[0].ele_job[i]) faad_free(hDecoder->frame_jobs[0].ele_job[i]);
+        if (hDecoder->frame_jobs[1].ele_job[i]) faad_free(hDecoder->frame_jobs[1].ele_job[i]);
+    }
+
+    faad_arena_end(&hDecoder->allocator);
+
+    /* the handle itself never lives in the arena */
+    allocator = hDecoder->allocator;
+    faad_set_allocator(&allocator);
+    faad_free(hDecoder);
+    faad_set_allocator(prev);
 }
 
 void NeAACDecPostSeekReset(NeAACDecHandle hpDecoder, long frame)
@@ -595,6 +739,70 @@ void NeAACDecPostSeekReset(NeAACDecHandle hpDecoder, long frame)
     }
 }
 
+#define ARENA_BLOCK(size) ((((uint32_t)(size)) + FAAD_ARENA_ALIGN-1) & ~(uint32_t)(FAAD_ARENA_ALIGN-1))
+
+/* allocates the arena of a decoder in arena mode, sized for the stream
+   configuration known at init; anything allocated later that doesn't fit
+   comes from the allocator callbacks */
+static void init_arena(NeAACDecStruct *hDecoder, uint8_t channels)
+{
+    uint32_t frame_len = hDecoder->frameLength;
+    uint32_t size, ch_size;
+    uint8_t mul = 1;
+
+    if (!hDecoder->allocator.use_arena)
+        return;
+
+    if (channels == 0)
+        channels = 2;
+
+#ifdef SBR_DEC
+    if ((hDecoder->sbr_present_flag == 1) || (hDecoder->forceUpSampling == 1))
+        mul = 2;
+#endif
+
+    /* filterbank, the MDCT tables are shared between decoders */
+    size = ARENA_BLOCK(sizeof(fb_info));
+
+    /* output buffer, largest sample size */
+    size += ARENA_BLOCK(mul*frame_len*channels*sizeof(double));
+
+    /* per channel state */
+    ch_size = ARENA_BLOCK(mul*frame_len*sizeof(real_t)) +
+        ARENA_BLOCK(frame_len*sizeof(real_t));
+#ifdef MAIN_DEC
+    if (hDecoder->object_type == MAIN)
+        ch_size += ARENA_BLOCK(frame_len*sizeof(pred_state));
+#endif
+#ifdef LTP_DEC
+    if (is_ltp_ot(hDecoder->object_type))
+        ch_size += ARENA_BLOCK(frame_len*4*sizeof(int16_t));
+#endif
+#ifdef SBR_DEC
+    /* at most one SBR element per channel */
+    if (mul == 2)
+    {
+        ch_size += ARENA_BLOCK(sizeof(sbr_info)) +
+            ARENA_BLOCK(sizeof(qmfa_info)) + ARENA_BLOCK(2*32*10*sizeof(real_t)) +
+            ARENA_BLOCK(sizeof(qmfs_info)) + ARENA_BLOCK(2*64*20*sizeof(real_t)) +
+            10*ARENA_BLOCK(64*sizeof(real_t));
+    }
+#endif
+    /* overlap of the spectral downmix */
+    if (hDecoder->config.downMatrix == FAAD_DOWNMIX_SPECTRAL)
+        size += 2*ARENA_BLOCK(frame_len*sizeof(real_t));
+    /* deferred element reconstruction, at most one element per channel,
+       the batch pipeline has two frames in flight */
+    if (hDecoder->syn_pool != NULL)
+        ch_size += 2*ARENA_BLOCK(sizeof(element_job));
+    else if (hDecoder->defer_elements ||
+        (hDecoder->config.downMatrix == FAAD_DOWNMIX_SPECTRAL))
+        ch_size += ARENA_BLOCK(sizeof(element_job));
+    size += channels*ch_size;
+
+    faad_arena_init(&hDecoder->allocator, size);
+}
+
 static void create_channel_config(NeAACDecStruct *hDecoder, NeAACDecFrameInfo *hInfo)
 {
     hInfo->num_front_channels = 0;
@@ -813,13 +1021,159 @@ static void create_channel_config(NeAACDecStruct *hDecoder, NeAACDecFrameInfo *h
     }
 }
 
+static uint8_t frame_layout_changed(NeAACDecStruct *hDecoder)
+{
+    frame_layout *fl = &hDecoder->layout;
+
+    if (!hDecoder->layout_valid)
+        return 1;
+
+    return (fl->fr_channels != hDecoder->fr_channels) ||
+        (fl->channelConfiguration != hDecoder->channelConfiguration) ||
+        (fl->has_lfe != hDecoder->has_lfe) ||
+        (fl->first_syn_ele != hDecoder->first_syn_ele) ||
+        (fl->downMatrix_cfg != hDecoder->config.downMatrix) ||
+        (fl->outputFormat != hDecoder->config.outputFormat)
+#if (defined(PS_DEC) || defined(DRM_PS))
+        || (fl->ps_used != hDecoder->ps_used_global)
+#endif
+#ifdef SBR_DEC
+        || (fl->sbr_present_flag != hDecoder->sbr_present_flag)
+#endif
+        ;
+}
+
+/* everything about the output of a frame that follows from the stream
+   configuration: the channel config, the frame info and the output size */
+static void frame_layout_update(NeAACDecStruct *hDecoder)
+{
+    frame_layout *fl = &hDecoder->layout;
+    NeAACDecFrameInfo *info = &fl->info;
+    uint8_t channels = hDecoder->fr_channels;
+    uint8_t output_channels;
+    uint16_t frame_len = hDecoder->frameLength;
+    uint8_t stride;
+
+    fl->fr_channels = channels;
+    fl->channelConfiguration = hDecoder->channelConfiguration;
+    fl->has_lfe = hDecoder->has_lfe;
+    fl->first_syn_ele = hDecoder->first_syn_ele;
+    fl->downMatrix_cfg = hDecoder->config.downMatrix;
+    fl->outputFormat = hDecoder->config.outputFormat;
+#if (defined(PS_DEC) || defined(DRM_PS))
+    fl->ps_used = hDecoder->ps_used_global;
+#endif
+#ifdef SBR_DEC
+    fl->sbr_present_flag = hDecoder->sbr_present_flag;
+#endif
+
+    memset(info, 0, sizeof(NeAACDecFrameInfo));
+
+    if ((channels == 5 || channels == 6) && hDecoder->config.downMatrix)
+    {
+        hDecoder->downMatrix = 1;
+        output_channels = 2;
+    } else {
+        hDecoder->downMatrix = 0;
+        output_channels = channels;
+    }
+
+#if (defined(PS_DEC) || defined(DRM_PS))
+    hDecoder->upMatrix = 0;
+    /* check if we have a mono file */
+    if (output_channels == 1)
+    {
+        /* upMatrix to 2 channels for implicit signalling of PS */
+        hDecoder->upMatrix = 1;
+        output_channels = 2;
+    }
+#endif
+
+    /* Make a channel configuration based on either a PCE or a channelConfiguration */
+    create_channel_config(hDecoder, info);
+
+    /* number of samples in this frame */
+    info->samples = frame_len*output_channels;
+    /* number of channels in this frame */
+    info->channels = output_channels;
+    /* samplerate */
+    info->samplerate = get_sample_rate(hDecoder->sf_index);
+    /* object type */
+    info->object_type = hDecoder->object_type;
+    /* sbr */
+    info->sbr = NO_SBR;
+    /* header type */
+    info->header_type = RAW;
+    if (hDecoder->adif_header_present)
+        info->header_type = ADIF;
+    if (hDecoder->adts_header_present)
+        info->header_type = ADTS;
+#if 0
+    if (hDecoder->latm_header_present)
+        info->header_type = LATM;
+#endif
+#if (defined(PS_DEC) || defined(DRM_PS))
+    info->ps = hDecoder->ps_used_global;
+#endif
+
+    /* size of the buffer for the final samples */
+    stride = sample_size[hDecoder->config.outputFormat-1];
+#ifdef SBR_DEC
+    if (((hDecoder->sbr_present_flag == 1)&&(!hDecoder->downSampledSBR)) || (hDecoder->forceUpSampling == 1))
+    {
+        stride = 2 * stride;
+    }
+#endif
+    fl->frame_bytes = (uint32_t)frame_len*output_channels*stride;
+
+#ifdef SBR_DEC
+    if ((hDecoder->sbr_present_flag == 1) || (hDecoder->forceUpSampling == 1))
+    {
+        /* this data is different when SBR is used or when the data is upsampled */
+        if (!hDecoder->downSampledSBR)
+        {
+            frame_len *= 2;
+            info->samples *= 2;
+            info->samplerate *= 2;
+        }
+
+        /* sbr */
+        if (hDecoder->sbr_present_flag == 1)
+        {
+            info->object_type = HE_AAC;
+            info->sbr = SBR_UPSAMPLED;
+        } else {
+            info->sbr = NO_SBR_UPSAMPLED;
+        }
+        if (hDecoder->downSampledSBR)
+        {
+            info->sbr = SBR_DOWNSAMPLED;
+        }
+    }
+#endif
+
+    fl->output_channels = output_channels;
+    fl->frame_len = frame_len;
+    hDecoder->layout_valid = 1;
+}
+
 void* NeAACDecDecode(NeAACDecHandle hpDecoder,
                                  NeAACDecFrameInfo *hInfo,
                                  unsigned char *buffer,
                                  unsigned long buffer_size)
 {
     NeAACDecStruct* hDecoder = (NeAACDecStruct*)hpDecoder;
-    return aac_frame_decode(hDecoder, hInfo, buffer, buffer_size, NULL, 0);
+    faad_allocator *prev;
+    void *sample_buffer;
+
+    if (hDecoder == NULL)
+        return NULL;
+
+    prev = faad_set_allocator(&hDecoder->allocator);
+    sample_buffer = aac_frame_decode(hDecoder, hInfo, buffer, buffer_size, NULL, 0);
+    faad_set_allocator(prev);
+
+    return sample_buffer;
 }
 
 void* NeAACDecDecode2(NeAACDecHandle hpDecoder,
@@ -830,66 +1184,694 @@ void* NeAACDecDecode2(NeAACDecHandle hpDecoder,
                                   unsigned long sample_buffer_size)
 {
     NeAACDecStruct* hDecoder = (NeAACDecStruct*)hpDecoder;
+    faad_allocator *prev;
+    void *ret;
+
     if ((sample_buffer == NULL) || (sample_buffer_size == 0))
     {
         hInfo->error = 27;
         return NULL;
     }
+    if (hDecoder == NULL)
+        return NULL;
+    /* a new stream configuration is checked by aac_frame_decode() */
+    if (hDecoder->layout_valid &&
+        (sample_buffer_size < hDecoder->layout.frame_bytes))
+    {
+        memset(hInfo, 0, sizeof(NeAACDecFrameInfo));
+        hInfo->error = 27;
+        return NULL;
+    }
 
-    return aac_frame_decode(hDecoder, hInfo, buffer, buffer_size,
+    prev = faad_set_allocator(&hDecoder->allocator);
+    ret = aac_frame_decode(hDecoder, hInfo, buffer, buffer_size,
         sample_buffer, sample_buffer_size);
-}
-
-#ifdef DRM
-
-#define ERROR_STATE_INIT 6
+    faad_set_allocator(prev);
 
-static void conceal_output(NeAACDecStruct *hDecoder, uint16_t frame_len,
-                           uint8_t out_ch, void *sample_buffer)
-{
-    return;
+    return ret;
 }
-#endif
 
-static void* aac_frame_decode(NeAACDecStruct *hDecoder,
-                              NeAACDecFrameInfo *hInfo,
-                              unsigned char *buffer,
-                              unsigned long buffer_size,
-                              void **sample_buffer2,
-                              unsigned long sample_buffer_size)
+unsigned long NeAACDecDecodeBatch(NeAACDecHandle hpDecoder,
+                                  NeAACDecFrameInfo *hInfo,
+                                  unsigned char **buffers,
+                                  unsigned long *buffer_sizes,
+                                  unsigned long num_frames,
+                                  void *sample_buffer,
+                                  unsigned long sample_buffer_size)
 {
-    uint16_t i;
-    uint8_t channels = 0;
-    uint8_t output_channels = 0;
-    bitfile ld = {0};
-    uint32_t bitsconsumed;
-    uint16_t frame_len;
-    void *sample_buffer;
-    uint32_t startbit=0, endbit=0, payload_bits=0;
+    NeAACDecStruct* hDecoder = (NeAACDecStruct*)hpDecoder;
+    unsigned char *out = (unsigned char*)sample_buffer;
+    unsigned long i, used;
+    uint8_t size, defer_elements = 0, id3_tag = 0;
+    faad_allocator *prev;
+
+    /* safety checks, done once for the whole batch */
+    if ((hDecoder == NULL) || (hInfo == NULL) || (buffers == NULL) ||
+        (buffer_sizes == NULL) || (num_frames == 0))
+    {
+        return 0;
+    }
+    if ((sample_buffer == NULL) || (sample_buffer_size == 0))
+    {
+        hInfo[0].error = 27;
+        return 1;
+    }
 
-#ifdef PROFILE
-    int64_t count = faad_get_ts();
-#endif
+    size = sample_size[hDecoder->config.outputFormat-1];
+    memset(hInfo, 0, num_frames*sizeof(NeAACDecFrameInfo));
 
-    /* safety checks */
-    if ((hDecoder == NULL) || (hInfo == NULL) || (buffer == NULL))
+    /* an ID3v1 tag can only end the stream */
+    if ((buffer_sizes[num_frames-1] >= 128) &&
+        (memcmp(buffers[num_frames-1], "TAG", 3) == 0))
     {
-        return NULL;
+        id3_tag = 1;
+        num_frames--;
     }
 
-#if 0
-    printf("%d\n", buffer_size*8);
+    prev = faad_set_allocator(&hDecoder->allocator);
+    hDecoder->batched = 1;
+
+    /* parse each frame while the previous one is synthesized */
+    if ((hDecoder->syn_pool != NULL) && (num_frames > 1)
+#ifdef DRM
+        && (hDecoder->object_type != DRM_ER_LC)
 #endif
+        )
+    {
+        defer_elements = hDecoder->defer_elements;
+        hDecoder->defer_elements = 1;
+        hDecoder->pipelined = 1;
+    }
 
-    frame_len = hDecoder->frameLength;
+    for (i = 0; i < num_frames; i++)
+    {
+        void *frame_out = out;
 
+        /* the layout of a new stream configuration is checked when it is made */
+        if (hDecoder->layout_valid &&
+            (sample_buffer_size < hDecoder->layout.frame_bytes))
+        {
+            hInfo[i++].error = 27;
+            break;
+        }
 
-    memset(hInfo, 0, sizeof(NeAACDecFrameInfo));
-    memset(hDecoder->internal_channel, 0, MAX_CHANNELS*sizeof(hDecoder->internal_channel[0]));
+        hDecoder->fr_job->sample_buffer = NULL;
+        aac_frame_decode(hDecoder, &hInfo[i], buffers[i], buffer_sizes[i],
+            &frame_out, sample_buffer_size);
 
-#ifdef USE_TIME_LIMIT
-    if ((TIME_LIMIT * get_sample_rate(hDecoder->sf_index)) > hDecoder->TL_count)
-    {
+        if (hDecoder->pipelined)
+        {
+            finish_synthesis(hDecoder);
+            if ((i > 0) && (hInfo[i-1].error > 0))
+            {
+                /* the previous frame failed in synthesis, drop this one */
+                hDecoder->fr_job->num_ele_jobs = 0;
+                reset_frame_state(hDecoder);
+                break;
+            }
+            if (hInfo[i].error > 0)
+                reconstruct_elements(hDecoder, hDecoder->fr_job);
+            else if (hDecoder->fr_job->sample_buffer != NULL)
+                start_synthesis(hDecoder, &hInfo[i]);
+        }
+
+        if (hInfo[i].error > 0)
+        {
+            i++;
+            break;
+        }
+
+        /* frames without output (delay, metadata) are written over */
+        used = hInfo[i].samples*size;
+        out += used;
+        sample_buffer_size -= used;
+    }
+
+    if (hDecoder->pipelined)
+    {
+        finish_synthesis(hDecoder);
+        hDecoder->defer_elements = defer_elements;
+        hDecoder->pipelined = 0;
+    }
+
+    hDecoder->batched = 0;
+    faad_set_allocator(prev);
+
+    if (id3_tag && (i == num_frames) && ((i == 0) || (hInfo[i-1].error == 0)))
+    {
+        /* no error, but no output either */
+        hInfo[i++].bytesconsumed = 128;
+    }
+
+    return i;
+}
+
+/* segment parallel decoding, see NeAACDecDecodeSegments() */
+#define SEGMENT_PREROLL    8 /* frames decoded ahead of a segment to warm up its state */
+#define SEGMENT_MIN_FRAMES (4*SEGMENT_PREROLL)
+
+typedef struct
+{
+    NeAACDecStruct *hDecoder;
+    NeAACDecFrameInfo *hInfo;
+    unsigned char **buffers;   /* starts with the pre-roll frames */
+    unsigned long *buffer_sizes;
+    unsigned long preroll;
+    unsigned long num_frames;
+    unsigned long done;        /* frame infos filled in */
+
+    /* output; the first segment writes straight into the caller's buffer */
+    uint8_t *out;
+    unsigned long out_size;
+    unsigned long out_used;
+
+    /* PNS random generator: the state serial decoding has at the first
+       frame and at the first pre-roll frame, and the values drawn */
+    uint32_t rng[2];
+    uint32_t pre_rng[2];
+    uint32_t pre_draws;
+    uint32_t total_draws;
+    uint32_t *draws;           /* per frame, not filled in by the first segment */
+    uint8_t reseed;            /* start the pre-roll from pre_rng */
+    uint8_t skip;              /* nothing to decode in this pass */
+} segment_job;
+
+/* steps the PNS random generator over draws values */
+static void rng_skip(uint32_t rng[2], uint32_t draws)
+{
+    while (draws-- > 0)
+        ne_rng(&rng[0], &rng[1]);
+}
+
+/* opens a decoder in the state the given one had right after init */
+static NeAACDecStruct *open_segment_decoder(NeAACDecStruct *hDecoder)
+{
+    NeAACDecStruct *seg;
+    faad_allocator *prev;
+
+    seg = (NeAACDecStruct*)NeAACDecOpenWithAllocator(hDecoder->allocator.malloc_func,
+        hDecoder->allocator.free_func, hDecoder->allocator.user_data, FAAD_ALLOC_DEFAULT);
+    if (seg == NULL)
+        return NULL;
+
+    seg->config = hDecoder->config;
+    seg->adts_header_present = hDecoder->adts_header_present;
+    seg->adif_header_present = hDecoder->adif_header_present;
+    seg->latm_header_present = hDecoder->latm_header_present;
+    seg->sf_index = hDecoder->sf_index;
+    seg->object_type = hDecoder->object_type;
+    seg->channelConfiguration = hDecoder->channelConfiguration;
+    seg->pce = hDecoder->pce;
+    seg->pce_set = hDecoder->pce_set;
+#ifdef ERROR_RESILIENCE
+    seg->aacSectionDataResilienceFlag = hDecoder->aacSectionDataResilienceFlag;
+    seg->aacScalefactorDataResilienceFlag = hDecoder->aacScalefactorDataResilienceFlag;
+    seg->aacSpectralDataResilienceFlag = hDecoder->aacSpectralDataResilienceFlag;
+#endif
+#ifdef SBR_DEC
+    seg->sbr_present_flag = hDecoder->sbr_present_flag;
+    seg->downSampledSBR = hDecoder->downSampledSBR;
+    seg->forceUpSampling = hDecoder->forceUpSampling;
+    seg->core_only = hDecoder->core_only;
+#endif
+    seg->frameLength = hDecoder->frameLength;
+
+    prev = faad_set_allocator(&seg->allocator);
+    seg->fb = filter_bank_init(seg->frameLength);
+    faad_set_allocator(prev);
+
+    return seg;
+}
+
+static uint8_t segment_output(segment_job *sj, void *samples, unsigned long size,
+                              unsigned long frames_left)
+{
+    if (sj->out_used + size > sj->out_size)
+    {
+        /* assume the remaining frames are as long as this one */
+        unsigned long out_size = max(sj->out_used + size*frames_left, 2*sj->out_size);
+        uint8_t *out = (uint8_t*)faad_malloc(out_size);
+
+        if (out == NULL)
+            return 0;
+        if (sj->out != NULL)
+        {
+            memcpy(out, sj->out, sj->out_used);
+            faad_free(sj->out);
+        }
+        sj->out = out;
+        sj->out_size = out_size;
+    }
+
+    memcpy(sj->out + sj->out_used, samples, size);
+    sj->out_used += size;
+
+    return 1;
+}
+
+static void segment_decode(void *data, unsigned long index)
+{
+    segment_job *sj = (segment_job*)data + index;
+    NeAACDecStruct *hDecoder = sj->hDecoder;
+    uint8_t size = sample_size[hDecoder->config.outputFormat-1];
+    faad_allocator *prev;
+    unsigned long i;
+
+    if (sj->skip)
+        return;
+    if (index == 0)
+    {
+        hDecoder->rng_draws = 0;
+        sj->done = NeAACDecDecodeBatch(hDecoder, sj->hInfo, sj->buffers,
+            sj->buffer_sizes, sj->num_frames, sj->out, sj->out_size);
+        sj->total_draws = hDecoder->rng_draws;
+        return;
+    }
+
+    prev = faad_set_allocator(&hDecoder->allocator);
+
+    if (sj->reseed)
+    {
+        hDecoder->__r1 = sj->pre_rng[0];
+        hDecoder->__r2 = sj->pre_rng[1];
+    }
+    hDecoder->rng_draws = 0;
+
+    for (i = 0; i < sj->preroll; i++)
+    {
+        NeAACDecFrameInfo info;
+
+        aac_frame_decode(hDecoder, &info, sj->buffers[i], sj->buffer_sizes[i], NULL, 0);
+    }
+    sj->pre_draws = hDecoder->rng_draws;
+    sj->total_draws = 0;
+    sj->out_used = 0;
+
+    for (i = 0; i < sj->num_frames; i++)
+    {
+        NeAACDecFrameInfo *hInfo = &sj->hInfo[i];
+        void *samples;
+
+        hDecoder->rng_draws = 0;
+        samples = aac_frame_decode(hDecoder, hInfo, sj->buffers[sj->preroll+i],
+            sj->buffer_sizes[sj->preroll+i], NULL, 0);
+        sj->draws[i] = hDecoder->rng_draws;
+        sj->total_draws += hDecoder->rng_draws;
+
+        sj->done = i+1;
+        if (hInfo->error > 0)
+            break;
+        if ((hInfo->samples > 0) &&
+            !segment_output(sj, samples, hInfo->samples*size, sj->num_frames-i))
+        {
+            hInfo->error = 15;
+            break;
+        }
+    }
+
+    faad_set_allocator(prev);
+}
+
+unsigned long NeAACDecDecodeSegments(NeAACDecHandle hpDecoder,
+                                     NeAACDecFrameInfo *hInfo,
+                                     unsigned char **buffers,
+                                     unsigned long *buffer_sizes,
+                                     unsigned long num_frames,
+                                     void *sample_buffer,
+                                     unsigned long sample_buffer_size,
+                                     unsigned char num_segments)
+{
+    NeAACDecStruct* hDecoder = (NeAACDecStruct*)hpDecoder;
+    segment_job *jobs;
+    uint32_t *draws;
+    faad_pool *pool;
+    faad_allocator heap, *prev;
+    unsigned long i, j, first, seg_len, done, left;
+    uint8_t *out;
+    uint8_t k, size, redo, failed = 0;
+
+    if ((hDecoder == NULL) || (hInfo == NULL) || (buffers == NULL) ||
+        (buffer_sizes == NULL) || (num_frames == 0))
+    {
+        return 0;
+    }
+
+    /* only the filterbank, SBR and PS state is warmed up by the pre-roll,
+       the prediction state of Main and LTP has a much longer memory */
+    if (num_segments > num_frames/SEGMENT_MIN_FRAMES)
+        num_segments = (uint8_t)(num_frames/SEGMENT_MIN_FRAMES);
+    if ((num_segments < 2) || (sample_buffer == NULL) || (sample_buffer_size == 0) ||
+        ((hDecoder->object_type != LC) && (hDecoder->object_type != ER_LC)))
+    {
+        return NeAACDecDecodeBatch(hpDecoder, hInfo, buffers, buffer_sizes,
+            num_frames, sample_buffer, sample_buffer_size);
+    }
+
+    /* the jobs and threads only live for this call, keep them out of the
+       arena, which only gives back its most recent block */
+    heap = hDecoder->allocator;
+    heap.arena = NULL;
+    prev = faad_set_allocator(&heap);
+
+    jobs = (segment_job*)faad_malloc(num_segments*sizeof(segment_job));
+    draws = (uint32_t*)faad_malloc(num_frames*sizeof(uint32_t));
+    if ((jobs == NULL) || (draws == NULL))
+    {
+        if (jobs) faad_free(jobs);
+        if (draws) faad_free(draws);
+        faad_set_allocator(prev);
+        return NeAACDecDecodeBatch(hpDecoder, hInfo, buffers, buffer_sizes,
+            num_frames, sample_buffer, sample_buffer_size);
+    }
+    memset(jobs, 0, num_segments*sizeof(segment_job));
+
+    seg_len = num_frames/num_segments;
+    for (k = 0; k < num_segments; k++)
+    {
+        first = k*seg_len;
+
+        jobs[k].preroll = (k == 0) ? 0 : SEGMENT_PREROLL;
+        jobs[k].num_frames = (k == num_segments-1) ? (num_frames - first) : seg_len;
+        jobs[k].hInfo = &hInfo[first];
+        jobs[k].buffers = &buffers[first - jobs[k].preroll];
+        jobs[k].buffer_sizes = &buffer_sizes[first - jobs[k].preroll];
+        jobs[k].draws = &draws[first];
+        if (k == 0)
+        {
+            jobs[k].hDecoder = hDecoder;
+            jobs[k].out = (uint8_t*)sample_buffer;
+            jobs[k].out_size = sample_buffer_size;
+            jobs[k].rng[0] = hDecoder->__r1;
+            jobs[k].rng[1] = hDecoder->__r2;
+        } else {
+            jobs[k].hDecoder = open_segment_decoder(hDecoder);
+            if (jobs[k].hDecoder == NULL)
+                failed = 1;
+        }
+    }
+
+    /* the calling thread decodes one of the segments */
+    pool = NULL;
+    if (!failed)
+        pool = faad_pool_create(num_segments-1);
+    if (!failed && (pool != NULL))
+    {
+        faad_pool_run(pool, segment_decode, jobs, num_segments);
+
+        /* the PNS noise comes from one generator running through the whole
+           stream. The number of values a frame draws doesn't depend on the
+           state, so the state serial decoding has at each segment follows
+           from the counts, and the segments that drew noise in their
+           pre-roll or frames are decoded again from it */
+        redo = 0;
+        for (k = 0; k < num_segments; k++)
+            jobs[k].skip = 1;
+        for (k = 1; k < num_segments; k++)
+        {
+            segment_job *sj = &jobs[k];
+            segment_job *pj = &jobs[k-1];
+
+            /* the pre-roll frames are the last frames of the previous segment */
+            if ((pj->done < pj->num_frames) || (pj->hInfo[pj->done-1].error > 0) ||
+                (sj->pre_draws > pj->total_draws))
+            {
+                break;
+            }
+            sj->pre_rng[0] = pj->rng[0];
+            sj->pre_rng[1] = pj->rng[1];
+            rng_skip(sj->pre_rng, pj->total_draws - sj->pre_draws);
+            sj->rng[0] = sj->pre_rng[0];
+            sj->rng[1] = sj->pre_rng[1];
+            rng_skip(sj->rng, sj->pre_draws);
+
+            if ((sj->pre_draws == 0) && (sj->total_draws == 0))
+                continue;
+
+            NeAACDecClose(sj->hDecoder);
+            sj->hDecoder = open_segment_decoder(hDecoder);
+            if (sj->hDecoder == NULL)
+            {
+                /* ends the output at this segment */
+                sj->done = 1;
+                sj->hInfo[0].error = 15;
+                break;
+            }
+            sj->reseed = 1;
+            sj->skip = 0;
+            redo = 1;
+        }
+        if (redo)
+            faad_pool_run(pool, segment_decode, jobs, num_segments);
+    }
+    faad_pool_destroy(pool);
+
+    /* stitch the segments together */
+    done = 0;
+    if (!failed && (pool != NULL))
+    {
+        size = sample_size[hDecoder->config.outputFormat-1];
+        out = jobs[0].out;
+        left = sample_buffer_size;
+        for (k = 0; k < num_segments; k++)
+        {
+            segment_job *sj = &jobs[k];
+            uint8_t *seg_out = sj->out;
+
+            for (j = 0; j < sj->done; j++)
+            {
+                unsigned long used = sj->hInfo[j].samples*size;
+
+                done++;
+                if (sj->hInfo[j].error > 0)
+                    break;
+                if (used > left)
+                {
+                    sj->hInfo[j].error = 27;
+                    break;
+                }
+                if (k > 0)
+                    memcpy(out, seg_out, used);
+                out += used;
+                seg_out += used;
+                left -= used;
+            }
+            if (j < sj->num_frames)
+                break;
+        }
+    }
+
+    /* leave the decoder ready for the frame after the last one decoded,
+       with the generator state serial decoding has there */
+    if (!failed && (pool != NULL) && (done > seg_len))
+    {
+        first = max(done - SEGMENT_PREROLL, seg_len);
+        k = (uint8_t)min(first/seg_len, (unsigned long)num_segments - 1);
+
+        for (i = k*seg_len; i < first; i++)
+            rng_skip(jobs[k].rng, draws[i]);
+        hDecoder->__r1 = jobs[k].rng[0];
+        hDecoder->__r2 = jobs[k].rng[1];
+
+        faad_set_allocator(&hDecoder->allocator);
+        for (i = first; i < done; i++)
+        {
+            NeAACDecFrameInfo info;
+
+            aac_frame_decode(hDecoder, &info, buffers[i], buffer_sizes[i], NULL, 0);
+        }
+        faad_set_allocator(&heap);
+    }
+
+    /* the segment decoders allocate from the same callbacks, outside of
+       any arena */
+    for (k = 1; k < num_segments; k++)
+    {
+        if (jobs[k].out) faad_free(jobs[k].out);
+        NeAACDecClose(jobs[k].hDecoder);
+    }
+    faad_free(draws);
+    faad_free(jobs);
+
+    faad_set_allocator(prev);
+
+    if (failed || (pool == NULL))
+    {
+        /* no threads, nothing decoded yet */
+        return NeAACDecDecodeBatch(hpDecoder, hInfo, buffers, buffer_sizes,
+            num_frames, sample_buffer, sample_buffer_size);
+    }
+
+    return done;
+}
+
+unsigned char NeAACDecGetChannelBuffers(NeAACDecHandle hpDecoder,
+                                        const void **channel_buffers,
+                                        unsigned char max_channels)
+{
+    NeAACDecStruct* hDecoder = (NeAACDecStruct*)hpDecoder;
+    uint8_t ch, channels;
+
+    if ((hDecoder == NULL) || (channel_buffers == NULL))
+        return 0;
+
+    /* a downmix only exists in the converted output */
+    if (hDecoder->downMatrix)
+        return 0;
+
+    channels = min(hDecoder->output_channels, max_channels);
+    for (ch = 0; ch < channels; ch++)
+    {
+        /* with upMatrix both output channels come from the mono channel */
+        if (hDecoder->upMatrix)
+            channel_buffers[ch] = hDecoder->time_out[hDecoder->internal_channel[0]];
+        else
+            channel_buffers[ch] = hDecoder->time_out[hDecoder->internal_channel[ch]];
+    }
+
+    return channels;
+}
+
+unsigned char NeAACDecSetElementThreads(NeAACDecHandle hpDecoder,
+                                        unsigned char num_threads,
+                                        NeAACDecRunJobsFunc run_jobs,
+                                        void *user_data)
+{
+    NeAACDecStruct* hDecoder = (NeAACDecStruct*)hpDecoder;
+    faad_pool *pool = NULL;
+    faad_allocator *prev;
+
+    if (hDecoder == NULL)
+        return 0;
+
+    prev = faad_set_allocator(&hDecoder->allocator);
+
+    /* the decoding thread takes part in the work */
+    if ((run_jobs == NULL) && (num_threads > 1))
+    {
+        pool = faad_pool_create(num_threads-1);
+        if (pool == NULL)
+        {
+            faad_set_allocator(prev);
+            return 0;
+        }
+    }
+
+    faad_pool_destroy(hDecoder->ele_pool);
+    hDecoder->ele_pool = pool;
+    hDecoder->run_jobs = run_jobs;
+    hDecoder->run_jobs_data = user_data;
+    hDecoder->defer_elements = (run_jobs != NULL) || (pool != NULL);
+
+    faad_set_allocator(prev);
+
+    return 1;
+}
+
+unsigned char NeAACDecSetBatchPipeline(NeAACDecHandle hpDecoder, unsigned char enable)
+{
+    NeAACDecStruct* hDecoder = (NeAACDecStruct*)hpDecoder;
+    faad_allocator *prev;
+
+    if (hDecoder == NULL)
+        return 0;
+
+    prev = faad_set_allocator(&hDecoder->allocator);
+    if (!enable)
+    {
+        faad_pool_destroy(hDecoder->syn_pool);
+        hDecoder->syn_pool = NULL;
+    } else if (hDecoder->syn_pool == NULL) {
+        /* a single synthesis thread, the parser is the calling thread */
+        hDecoder->syn_pool = faad_pool_create(1);
+    }
+    faad_set_allocator(prev);
+
+    return (!enable || (hDecoder->syn_pool != NULL));
+}
+
+#ifdef DRM
+
+#define ERROR_STATE_INIT 6
+
+static void conceal_output(NeAACDecStruct *hDecoder, uint16_t frame_len,
+                           uint8_t out_ch, void *sample_buffer)
+{
+    return;
+}
+#endif
+
+static void reset_frame_state(NeAACDecStruct *hDecoder)
+{
+    uint8_t i;
+
+#ifdef DRM
+    hDecoder->error_state = ERROR_STATE_INIT;
+#endif
+
+    /* reset filterbank state */
+    for (i = 0; i < MAX_CHANNELS; i++)
+    {
+        if (hDecoder->fb_intermed[i] != NULL)
+        {
+            memset(hDecoder->fb_intermed[i], 0, hDecoder->frameLength*sizeof(real_t));
+            hDecoder->fb_intermed_zero[i] = 1;
+        }
+    }
+    hDecoder->dm_overlap_valid = 0;
+    hDecoder->dm_parsed = 0;
+#ifdef SBR_DEC
+    for (i = 0; i < MAX_SYNTAX_ELEMENTS; i++)
+    {
+        if (hDecoder->sbr[i] != NULL)
+        {
+            sbrReset(hDecoder->sbr[i]);
+        }
+    }
+#endif
+}
+
+static void* aac_frame_decode(NeAACDecStruct *hDecoder,
+                              NeAACDecFrameInfo *hInfo,
+                              unsigned char *buffer,
+                              unsigned long buffer_size,
+                              void **sample_buffer2,
+                              unsigned long sample_buffer_size)
+{
+    uint8_t channels = 0;
+    uint8_t output_channels = 0;
+    bitfile ld = {0};
+    uint32_t bitsconsumed;
+    uint16_t frame_len;
+    void *sample_buffer;
+    uint32_t startbit=0, endbit=0, payload_bits=0;
+
+#ifdef PROFILE
+    int64_t count = faad_get_ts();
+#endif
+
+    /* safety checks */
+    if ((hDecoder == NULL) || (hInfo == NULL) || (buffer == NULL))
+    {
+        return NULL;
+    }
+
+#if 0
+    printf("%d\n", buffer_size*8);
+#endif
+
+
+
+    /* NeAACDecDecodeBatch() clears all frame infos at once */
+    if (!hDecoder->batched)
+        memset(hInfo, 0, sizeof(NeAACDecFrameInfo));
+    /* the elements of a stream map to the same channels in every frame */
+    if (!hDecoder->layout_valid)
+        memset(hDecoder->internal_channel, 0, MAX_CHANNELS*sizeof(hDecoder->internal_channel[0]));
+    hDecoder->output_channels = 0;
+
+#ifdef USE_TIME_LIMIT
+    if ((TIME_LIMIT * get_sample_rate(hDecoder->sf_index)) > hDecoder->TL_count)
+    {
         hDecoder->TL_count += 1024;
     } else {
         hInfo->error = (NUM_ERROR_MESSAGES-1);
@@ -901,8 +1883,8 @@ static void* aac_frame_decode(NeAACDecStruct *hDecoder,
     /* check for some common metadata tag types in the bitstream
      * No need to return an error
      */
-    /* ID3 */
-    if (buffer_size >= 128)
+    /* ID3, NeAACDecDecodeBatch() only checks the last access unit */
+    if (!hDecoder->batched && (buffer_size >= 128))
     {
         if (memcmp(buffer, "TAG", 3) == 0)
         {
@@ -993,6 +1975,21 @@ static void* aac_frame_decode(NeAACDecStruct *hDecoder,
     }
 #endif
 
+    /* elements parsed with deferred reconstruction, in the batch pipeline
+       they are synthesized on their own thread */
+    hDecoder->fr_job->drc = hDecoder->drc;
+    hDecoder->fr_job->spectral_dm = (hInfo->error == 0) &&
+        spectral_downmix_setup(hDecoder, hDecoder->fr_job);
+    if (hDecoder->pipelined)
+    {
+        hDecoder->fr_job->drc_state = *hDecoder->drc;
+        hDecoder->fr_job->drc = &hDecoder->fr_job->drc_state;
+    } else {
+        uint8_t error = reconstruct_elements(hDecoder, hDecoder->fr_job);
+        if (hInfo->error == 0)
+            hInfo->error = error;
+    }
+
 #if 0
     if(hDecoder->latm_header_present)
     {
@@ -1045,52 +2042,6 @@ static void* aac_frame_decode(NeAACDecStruct *hDecoder,
             hDecoder->channelConfiguration = 0;
     }
 
-    if ((channels == 5 || channels == 6) && hDecoder->config.downMatrix)
-    {
-        hDecoder->downMatrix = 1;
-        output_channels = 2;
-    } else {
-        output_channels = channels;
-    }
-
-#if (defined(PS_DEC) || defined(DRM_PS))
-    hDecoder->upMatrix = 0;
-    /* check if we have a mono file */
-    if (output_channels == 1)
-    {
-        /* upMatrix to 2 channels for implicit signalling of PS */
-        hDecoder->upMatrix = 1;
-        output_channels = 2;
-    }
-#endif
-
-    /* Make a channel configuration based on either a PCE or a channelConfiguration */
-    create_channel_config(hDecoder, hInfo);
-
-    /* number of samples in this frame */
-    hInfo->samples = frame_len*output_channels;
-    /* number of channels in this frame */
-    hInfo->channels = output_channels;
-    /* samplerate */
-    hInfo->samplerate = get_sample_rate(hDecoder->sf_index);
-    /* object type */
-    hInfo->object_type = hDecoder->object_type;
-    /* sbr */
-    hInfo->sbr = NO_SBR;
-    /* header type */
-    hInfo->header_type = RAW;
-    if (hDecoder->adif_header_present)
-        hInfo->header_type = ADIF;
-    if (hDecoder->adts_header_present)
-        hInfo->header_type = ADTS;
-#if 0
-    if (hDecoder->latm_header_present)
-        hInfo->header_type = LATM;
-#endif
-#if (defined(PS_DEC) || defined(DRM_PS))
-    hInfo->ps = hDecoder->ps_used_global;
-#endif
-
     /* check if frame has channel elements */
     if (channels == 0)
     {
@@ -1098,38 +2049,48 @@ static void* aac_frame_decode(NeAACDecStruct *hDecoder,
         return NULL;
     }
 
-    /* allocate the buffer for the final samples */
-    if ((hDecoder->sample_buffer == NULL) ||
-        (hDecoder->alloced_channels != output_channels))
+    /* the channel config and the output size only change with the stream */
+    if (frame_layout_changed(hDecoder))
     {
-        static const uint8_t str[] = { sizeof(int16_t), sizeof(int32_t), sizeof(int32_t),
-            sizeof(float32_t), sizeof(double), sizeof(int16_t), sizeof(int16_t),
-            sizeof(int16_t), sizeof(int16_t), 0, 0, 0
-        };
-        uint8_t stride = str[hDecoder->config.outputFormat-1];
-#ifdef SBR_DEC
-        if (((hDecoder->sbr_present_flag == 1)&&(!hDecoder->downSampledSBR)) || (hDecoder->forceUpSampling == 1))
-        {
-            stride = 2 * stride;
-        }
-#endif
-        /* check if we want to use internal sample_buffer */
-        if (sample_buffer_size == 0)
+        frame_layout_update(hDecoder);
+
+        /* check if the provided sample buffer is big enough */
+        if ((sample_buffer_size != 0) &&
+            (sample_buffer_size < hDecoder->layout.frame_bytes))
         {
-            if (hDecoder->sample_buffer)
-                faad_free(hDecoder->sample_buffer);
-            hDecoder->sample_buffer = NULL;
-            hDecoder->sample_buffer = faad_malloc(frame_len*output_channels*stride);
-        } else if (sample_buffer_size < frame_len*output_channels*stride) {
-            /* provided sample buffer is not big enough */
             hInfo->error = 27;
             return NULL;
         }
-        hDecoder->alloced_channels = output_channels;
     }
-
+    output_channels = hDecoder->layout.output_channels;
+    frame_len = hDecoder->layout.frame_len;
+
+    hInfo->samples = hDecoder->layout.info.samples;
+    hInfo->channels = hDecoder->layout.info.channels;
+    hInfo->samplerate = hDecoder->layout.info.samplerate;
+    hInfo->sbr = hDecoder->layout.info.sbr;
+    hInfo->object_type = hDecoder->layout.info.object_type;
+    hInfo->header_type = hDecoder->layout.info.header_type;
+    hInfo->num_front_channels = hDecoder->layout.info.num_front_channels;
+    hInfo->num_side_channels = hDecoder->layout.info.num_side_channels;
+    hInfo->num_back_channels = hDecoder->layout.info.num_back_channels;
+    hInfo->num_lfe_channels = hDecoder->layout.info.num_lfe_channels;
+    memcpy(hInfo->channel_position, hDecoder->layout.info.channel_position,
+        MAX_CHANNELS*sizeof(uint8_t));
+    hInfo->ps = hDecoder->layout.info.ps;
+
+    /* check if we want to use internal sample_buffer */
     if (sample_buffer_size == 0)
     {
+        if ((hDecoder->sample_buffer == NULL) ||
+            (hDecoder->alloced_channels != output_channels))
+        {
+            if (hDecoder->sample_buffer)
+                faad_free(hDecoder->sample_buffer);
+            hDecoder->sample_buffer = NULL;
+            hDecoder->sample_buffer = faad_malloc(hDecoder->layout.frame_bytes);
+            hDecoder->alloced_channels = output_channels;
+        }
         sample_buffer = hDecoder->sample_buffer;
     } else {
         sample_buffer = *sample_buffer2;
@@ -1140,14 +2101,6 @@ static void* aac_frame_decode(NeAACDecStruct *hDecoder,
     {
         uint8_t ele;
 
-        /* this data is different when SBR is used or when the data is upsampled */
-        if (!hDecoder->downSampledSBR)
-        {
-            frame_len *= 2;
-            hInfo->samples *= 2;
-            hInfo->samplerate *= 2;
-        }
-
         /* check if every element was provided with SBR data */
         for (ele = 0; ele < hDecoder->fr_ch_ele; ele++)
         {
@@ -1157,25 +2110,33 @@ static void* aac_frame_decode(NeAACDecStruct *hDecoder,
                 goto error;
             }
         }
-
-        /* sbr */
-        if (hDecoder->sbr_present_flag == 1)
-        {
-            hInfo->object_type = HE_AAC;
-            hInfo->sbr = SBR_UPSAMPLED;
-        } else {
-            hInfo->sbr = NO_SBR_UPSAMPLED;
-        }
-        if (hDecoder->downSampledSBR)
-        {
-            hInfo->sbr = SBR_DOWNSAMPLED;
-        }
     }
 #endif
 
 
-    sample_buffer = output_to_PCM(hDecoder, hDecoder->time_out, sample_buffer,
-        output_channels, frame_len, hDecoder->config.outputFormat);
+    if (hDecoder->pipelined)
+    {
+        /* converted once the frame is synthesized, see finish_synthesis() */
+        frame_job *fj = hDecoder->fr_job;
+
+        fj->sample_buffer = sample_buffer;
+        fj->frame_len = frame_len;
+        fj->output_channels = output_channels;
+        /* a spectral downmix is already stereo */
+        fj->downMatrix = fj->spectral_dm ? 0 : hDecoder->downMatrix;
+        fj->upMatrix = hDecoder->upMatrix;
+        memcpy(fj->internal_channel, hDecoder->internal_channel, MAX_CHANNELS*sizeof(uint8_t));
+    } else if (hDecoder->fr_job->spectral_dm) {
+        /* the stereo mix is in the first two channels */
+        hDecoder->downMatrix = 0;
+        sample_buffer = output_to_PCM(hDecoder, hDecoder->time_out, sample_buffer,
+            output_channels, frame_len, hDecoder->config.outputFormat);
+        hDecoder->downMatrix = 1;
+    } else {
+        sample_buffer = output_to_PCM(hDecoder, hDecoder->time_out, sample_buffer,
+            output_channels, frame_len, hDecoder->config.outputFormat);
+    }
+    hDecoder->output_channels = output_channels;
 
 
 #ifdef DRM
@@ -1214,28 +2175,14 @@ static void* aac_frame_decode(NeAACDecStruct *hDecoder,
 
 error:
 
-
-#ifdef DRM
-    hDecoder->error_state = ERROR_STATE_INIT;
-#endif
-
-    /* reset filterbank state */
-    for (i = 0; i < MAX_CHANNELS; i++)
-    {
-        if (hDecoder->fb_intermed[i] != NULL)
-        {
-            memset(hDecoder->fb_intermed[i], 0, hDecoder->frameLength*sizeof(real_t));
-        }
-    }
-#ifdef SBR_DEC
-    for (i = 0; i < MAX_SYNTAX_ELEMENTS; i++)
+    if (hDecoder->pipelined)
     {
-        if (hDecoder->sbr[i] != NULL)
-        {
-            sbrReset(hDecoder->sbr[i]);
-        }
+        /* the previous frame may still use the state reset below */
+        finish_synthesis(hDecoder);
+        reconstruct_elements(hDecoder, hDecoder->fr_job);
     }
-#endif
+
+    reset_frame_state(hDecoder);
 
 
     faad_endbits(&ld);
@@ -635,7 +635,7 @@ static void drm_ps_delta_decode(drm_ps_info *ps)
     }
 }
 
-static void drm_calc_sa_side_signal(drm_ps_info *ps, qmf_t X[38][64])
+static void drm_calc_sa_side_signal(drm_ps_info *ps, qmf_row_t X[38])
 {
     uint8_t s, b, k;
     complex_t qfrac, tmp0, tmp, in, R0;
@@ -664,8 +664,8 @@ static void drm_calc_sa_side_signal(drm_ps_info *ps, qmf_t X[38][64])
             const real_t gamma = REAL_CONST(1.5);
             const real_t sigma = REAL_CONST(1.5625);
 
-            RE(in) = QMF_RE(X[s][b]);
-            IM(in) = QMF_IM(X[s][b]);
+            RE(in) = QMF_ROW_RE(X[s], b);
+            IM(in) = QMF_ROW_IM(X[s], b);
 
 #ifdef FIXED_POINT
             /* NOTE: all input is scaled by 2^(-5) because of fixed point QMF
@@ -750,7 +750,7 @@ static void drm_calc_sa_side_signal(drm_ps_info *ps, qmf_t X[38][64])
         ps->delay_buf_index_ser[k] = temp_delay_ser[k];
 }
 
-static void drm_add_ambiance(drm_ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][64])
+static void drm_add_ambiance(drm_ps_info *ps, qmf_row_t X_left[38], qmf_row_t X_right[38])
 {
     uint8_t s, b, ifreq, qclass;
     real_t sa_map[MAX_SA_BAND], sa_dir_map[MAX_SA_BAND], k_sa_map[MAX_SA_BAND], k_sa_dir_map[MAX_SA_BAND];
@@ -783,18 +783,18 @@ static void drm_add_ambiance(drm_ps_info *ps, qmf_t X_left[38][64], qmf_t X_righ
         {
             for (b = 0; b < sa_freq_scale[DRM_NUM_SA_BANDS]; b++)
             {
-                QMF_RE(X_right[s][b]) = MUL_F(QMF_RE(X_left[s][b]), sa_dir_map[b]) - MUL_F(QMF_RE(ps->SA[s][b]), sa_map[b]);
-                QMF_IM(X_right[s][b]) = MUL_F(QMF_IM(X_left[s][b]), sa_dir_map[b]) - MUL_F(QMF_IM(ps->SA[s][b]), sa_map[b]);
-                QMF_RE(X_left[s][b]) = MUL_F(QMF_RE(X_left[s][b]), sa_dir_map[b]) + MUL_F(QMF_RE(ps->SA[s][b]), sa_map[b]);
-                QMF_IM(X_left[s][b]) = MUL_F(QMF_IM(X_left[s][b]), sa_dir_map[b]) + MUL_F(QMF_IM(ps->SA[s][b]), sa_map[b]);
+                QMF_ROW_RE(X_right[s], b) = MUL_F(QMF_ROW_RE(X_left[s], b), sa_dir_map[b]) - MUL_F(QMF_RE(ps->SA[s][b]), sa_map[b]);
+                QMF_ROW_IM(X_right[s], b) = MUL_F(QMF_ROW_IM(X_left[s], b), sa_dir_map[b]) - MUL_F(QMF_IM(ps->SA[s][b]), sa_map[b]);
+                QMF_ROW_RE(X_left[s], b) = MUL_F(QMF_ROW_RE(X_left[s], b), sa_dir_map[b]) + MUL_F(QMF_RE(ps->SA[s][b]), sa_map[b]);
+                QMF_ROW_IM(X_left[s], b) = MUL_F(QMF_ROW_IM(X_left[s], b), sa_dir_map[b]) + MUL_F(QMF_IM(ps->SA[s][b]), sa_map[b]);
 
                 sa_map[b]     += k_sa_map[b];
                 sa_dir_map[b] += k_sa_dir_map[b];
             }
             for (b = sa_freq_scale[DRM_NUM_SA_BANDS]; b < NUM_OF_QMF_CHANNELS; b++)
             {
-                QMF_RE(X_right[s][b]) = QMF_RE(X_left[s][b]);
-                QMF_IM(X_right[s][b]) = QMF_IM(X_left[s][b]);
+                QMF_ROW_RE(X_right[s], b) = QMF_ROW_RE(X_left[s], b);
+                QMF_ROW_IM(X_right[s], b) = QMF_ROW_IM(X_left[s], b);
             }
         }
     }
@@ -803,14 +803,14 @@ static void drm_add_ambiance(drm_ps_info *ps, qmf_t X_left[38][64], qmf_t X_righ
         {
             for (b = 0; b < NUM_OF_QMF_CHANNELS; b++)
             {
-                QMF_RE(X_right[s][b]) = QMF_RE(X_left[s][b]);
-                QMF_IM(X_right[s][b]) = QMF_IM(X_left[s][b]);
+                QMF_ROW_RE(X_right[s], b) = QMF_ROW_RE(X_left[s], b);
+                QMF_ROW_IM(X_right[s], b) = QMF_ROW_IM(X_left[s], b);
             }
         }
     }
 }
 
-static void drm_add_pan(drm_ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][64])
+static void drm_add_pan(drm_ps_info *ps, qmf_row_t X_left[38], qmf_row_t X_right[38])
 {
     uint8_t s, b, qclass, ifreq;
     real_t tmp, coeff1, coeff2;
@@ -868,15 +868,15 @@ static void drm_add_pan(drm_ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38]
                 coeff2 = DIV_R(REAL_CONST(2.0), (REAL_CONST(1.0) + tmp));
                 coeff1 = MUL_R(coeff2, tmp);
 
-                QMF_RE(temp_l) = QMF_RE(X_left[s][b]);
-                QMF_IM(temp_l) = QMF_IM(X_left[s][b]);
-                QMF_RE(temp_r) = QMF_RE(X_right[s][b]);
-                QMF_IM(temp_r) = QMF_IM(X_right[s][b]);
+                QMF_RE(temp_l) = QMF_ROW_RE(X_left[s], b);
+                QMF_IM(temp_l) = QMF_ROW_IM(X_left[s], b);
+                QMF_RE(temp_r) = QMF_ROW_RE(X_right[s], b);
+                QMF_IM(temp_r) = QMF_ROW_IM(X_right[s], b);
 
-                QMF_RE(X_left[s][b]) = MUL_R(QMF_RE(temp_l), coeff1);
-                QMF_IM(X_left[s][b]) = MUL_R(QMF_IM(temp_l), coeff1);
-                QMF_RE(X_right[s][b]) = MUL_R(QMF_RE(temp_r), coeff2);
-                QMF_IM(X_right[s][b]) = MUL_R(QMF_IM(temp_r), coeff2);
+                QMF_ROW_RE(X_left[s], b) = MUL_R(QMF_RE(temp_l), coeff1);
+                QMF_ROW_IM(X_left[s], b) = MUL_R(QMF_IM(temp_l), coeff1);
+                QMF_ROW_RE(X_right[s], b) = MUL_R(QMF_RE(temp_r), coeff2);
+                QMF_ROW_IM(X_right[s], b) = MUL_R(QMF_IM(temp_r), coeff2);
 
                 /* 2^(a+k*b) = 2^a * 2^b * ... * 2^b */
                 /*                   ^^^^^^^^^^^^^^^ k times */
@@ -901,17 +901,17 @@ void drm_ps_free(drm_ps_info *ps)
 }
 
 /* main DRM PS decoding function */
-uint8_t drm_ps_decode(drm_ps_info *ps, uint8_t guess, qmf_t X_left[38][64], qmf_t X_right[38][64])
+uint8_t drm_ps_decode(drm_ps_info *ps, uint8_t guess, qmf_row_t X_left[38], qmf_row_t X_right[38])
 {
     if (ps == NULL)
     {
-        memcpy(X_right, X_left, sizeof(qmf_t)*30*64);
+        memcpy(X_right, X_left, sizeof(qmf_row_t)*30);
         return 0;
     }
 
     if (!ps->drm_ps_data_available && !guess)
     {
-        memcpy(X_right, X_left, sizeof(qmf_t)*30*64);
+        memcpy(X_right, X_left, sizeof(qmf_row_t)*30);
         memset(ps->g_prev_sa_index, 0, sizeof(ps->g_prev_sa_index));
         memset(ps->g_prev_pan_index, 0, sizeof(ps->g_prev_pan_index));
         return 0;
@@ -44,6 +44,7 @@
 #include "kbd_win.h"
 #include "sine_win.h"
 #include "mdct.h"
+#include "simd.h"
 
 
 fb_info *filter_bank_init(uint16_t frame_len)
@@ -161,13 +162,87 @@ static INLINE void mdct(fb_info *fb, real_t *in_data, real_t *out_data, uint16_t
 }
 #endif
 
+/* windowing and overlap-add kernels; a reversed window is read
+   backwards from w_end, so w_end[-i] is w[n-1-i] for a window of n */
+
+/* out[i] = add[i] + x[i]*w[i] */
+static INLINE void window_add(real_t *out, const real_t *add, const real_t *x,
+                              const real_t *w, uint16_t n)
+{
+    uint16_t i = 0;
+
+#ifdef SIMD_V4
+    for (; i + 4 <= n; i += 4)
+    {
+        v4_store(&out[i], v4_add(v4_load(&add[i]),
+            v4_mul(v4_load(&x[i]), v4_load(&w[i]))));
+    }
+#endif
+    for (; i < n; i++)
+        out[i] = add[i] + MUL_F(x[i], w[i]);
+}
+
+/* out[i] = x[i]*w_end[-i] */
+static INLINE void window_rev(real_t *out, const real_t *x, const real_t *w_end,
+                              uint16_t n)
+{
+    uint16_t i = 0;
+
+#ifdef SIMD_V4
+    for (; i + 4 <= n; i += 4)
+    {
+        v4_store(&out[i], v4_mul(v4_load(&x[i]),
+            v4_reverse(v4_load(&w_end[-i-3]))));
+    }
+#endif
+    for (; i < n; i++)
+        out[i] = MUL_F(x[i], w_end[-i]);
+}
+
+/* overlap of two short blocks: out[i] = x1[i]*w_end[-i] + x2[i]*w[i] */
+static INLINE void window_ola(real_t *out, const real_t *x1, const real_t *x2,
+                              const real_t *w_end, const real_t *w, uint16_t n)
+{
+    uint16_t i = 0;
+
+#ifdef SIMD_V4
+    for (; i + 4 <= n; i += 4)
+    {
+        v4_store(&out[i], v4_add(
+            v4_mul(v4_load(&x1[i]), v4_reverse(v4_load(&w_end[-i-3]))),
+            v4_mul(v4_load(&x2[i]), v4_load(&w[i]))));
+    }
+#endif
+    for (; i < n; i++)
+        out[i] = MUL_F(x1[i], w_end[-i]) + MUL_F(x2[i], w[i]);
+}
+
+/* same, added to add[i] */
+static INLINE void window_ola_add(real_t *out, const real_t *add,
+                                  const real_t *x1, const real_t *x2,
+                                  const real_t *w_end, const real_t *w, uint16_t n)
+{
+    uint16_t i = 0;
+
+#ifdef SIMD_V4
+    for (; i + 4 <= n; i += 4)
+    {
+        v4_store(&out[i], v4_add(v4_add(v4_load(&add[i]),
+            v4_mul(v4_load(&x1[i]), v4_reverse(v4_load(&w_end[-i-3])))),
+            v4_mul(v4_load(&x2[i]), v4_load(&w[i]))));
+    }
+#endif
+    for (; i < n; i++)
+        out[i] = add[i] + MUL_F(x1[i], w_end[-i]) + MUL_F(x2[i], w[i]);
+}
+
 void ifilter_bank(fb_info *fb, uint8_t window_sequence, uint8_t window_shape,
                   uint8_t window_shape_prev, real_t *freq_in,
                   real_t *time_out, real_t *overlap,
                   uint8_t object_type, uint16_t frame_len)
 {
     int16_t i;
-    ALIGN real_t transf_buf[2*1024] = {0};
+    ALIGN real_t transf_buf[2*1024]; /* fully written by the iMDCT */
 
     const real_t *window_long = NULL;
     const real_t *window_long_prev = NULL;
@@ -218,22 +293,10 @@ void ifilter_bank(fb_info *fb, uint8_t window_sequence, uint8_t window_shape,
         imdct_long(fb, freq_in, transf_buf, 2*nlong);
 
         /* add second half output of previous frame to windowed output of current frame */
-        for (i = 0; i < nlong; i+=4)
-        {
-            time_out[i]   = overlap[i]   + MUL_F(transf_buf[i],window_long_prev[i]);
-            time_out[i+1] = overlap[i+1] + MUL_F(transf_buf[i+1],window_long_prev[i+1]);
-            time_out[i+2] = overlap[i+2] + MUL_F(transf_buf[i+2],window_long_prev[i+2]);
-            time_out[i+3] = overlap[i+3] + MUL_F(transf_buf[i+3],window_long_prev[i+3]);
-        }
+        window_add(time_out, overlap, transf_buf, window_long_prev, nlong);
 
         /* window the second half and save as overlap for next frame */
-        for (i = 0; i < nlong; i+=4)
-        {
-            overlap[i]   = MUL_F(transf_buf[nlong+i],window_long[nlong-1-i]);
-            overlap[i+1] = MUL_F(transf_buf[nlong+i+1],window_long[nlong-2-i]);
-            overlap[i+2] = MUL_F(transf_buf[nlong+i+2],window_long[nlong-3-i]);
-            overlap[i+3] = MUL_F(transf_buf[nlong+i+3],window_long[nlong-4-i]);
-        }
+        window_rev(overlap, transf_buf+nlong, window_long+nlong-1, nlong);
         break;
 
     case LONG_START_SEQUENCE:
@@ -241,58 +304,46 @@ void ifilter_bank(fb_info *fb, uint8_t window_sequence, uint8_t window_shape,
         imdct_long(fb, freq_in, transf_buf, 2*nlong);
 
         /* add second half output of previous frame to windowed output of current frame */
-        for (i = 0; i < nlong; i+=4)
-        {
-            time_out[i]   = overlap[i]   + MUL_F(transf_buf[i],window_long_prev[i]);
-            time_out[i+1] = overlap[i+1] + MUL_F(transf_buf[i+1],window_long_prev[i+1]);
-            time_out[i+2] = overlap[i+2] + MUL_F(transf_buf[i+2],window_long_prev[i+2]);
-            time_out[i+3] = overlap[i+3] + MUL_F(transf_buf[i+3],window_long_prev[i+3]);
-        }
+        window_add(time_out, overlap, transf_buf, window_long_prev, nlong);
 
         /* window the second half and save as overlap for next frame */
         /* construct second half window using padding with 1's and 0's */
         for (i = 0; i < nflat_ls; i++)
             overlap[i] = transf_buf[nlong+i];
-        for (i = 0; i < nshort; i++)
-            overlap[nflat_ls+i] = MUL_F(transf_buf[nlong+nflat_ls+i],window_short[nshort-i-1]);
+        window_rev(overlap+nflat_ls, transf_buf+nlong+nflat_ls, window_short+nshort-1, nshort);
         for (i = 0; i < nflat_ls; i++)
             overlap[nflat_ls+nshort+i] = 0;
         break;
 
     case EIGHT_SHORT_SEQUENCE:
         /* perform iMDCT for each short block */
-        faad_imdct(fb->mdct256, freq_in+0*nshort, transf_buf+2*nshort*0);
-        faad_imdct(fb->mdct256, freq_in+1*nshort, transf_buf+2*nshort*1);
-        faad_imdct(fb->mdct256, freq_in+2*nshort, transf_buf+2*nshort*2);
-        faad_imdct(fb->mdct256, freq_in+3*nshort, transf_buf+2*nshort*3);
-        faad_imdct(fb->mdct256, freq_in+4*nshort, transf_buf+2*nshort*4);
-        faad_imdct(fb->mdct256, freq_in+5*nshort, transf_buf+2*nshort*5);
-        faad_imdct(fb->mdct256, freq_in+6*nshort, transf_buf+2*nshort*6);
-        faad_imdct(fb->mdct256, freq_in+7*nshort, transf_buf+2*nshort*7);
+        faad_imdct_multi(fb->mdct256, freq_in, transf_buf, 8);
 
         /* add second half output of previous frame to windowed output of current frame */
         for (i = 0; i < nflat_ls; i++)
             time_out[i] = overlap[i];
-        for(i = 0; i < nshort; i++)
+        window_add(time_out+nflat_ls, overlap+nflat_ls, transf_buf, window_short_prev, nshort);
+        for (i = 1; i < 4; i++)
         {
-            time_out[nflat_ls+         i] = overlap[nflat_ls+         i] + MUL_F(transf_buf[nshort*0+i],window_short_prev[i]);
-            time_out[nflat_ls+1*nshort+i] = overlap[nflat_ls+nshort*1+i] + MUL_F(transf_buf[nshort*1+i],window_short[nshort-1-i]) + MUL_F(transf_buf[nshort*2+i],window_short[i]);
-            time_out[nflat_ls+2*nshort+i] = overlap[nflat_ls+nshort*2+i] + MUL_F(transf_buf[nshort*3+i],window_short[nshort-1-i]) + MUL_F(transf_buf[nshort*4+i],window_short[i]);
-            time_out[nflat_ls+3*nshort+i] = overlap[nflat_ls+nshort*3+i] + MUL_F(transf_buf[nshort*5+i],window_short[nshort-1-i]) + MUL_F(transf_buf[nshort*6+i],window_short[i]);
-            if (i < trans)
-                time_out[nflat_ls+4*nshort+i] = overlap[nflat_ls+nshort*4+i] + MUL_F(transf_buf[nshort*7+i],window_short[nshort-1-i]) + MUL_F(transf_buf[nshort*8+i],window_short[i]);
+            window_ola_add(time_out+nflat_ls+i*nshort, overlap+nflat_ls+i*nshort,
+                transf_buf+nshort*(2*i-1), transf_buf+nshort*2*i,
+                window_short+nshort-1, window_short, nshort);
         }
+        window_ola_add(time_out+nflat_ls+4*nshort, overlap+nflat_ls+4*nshort,
+            transf_buf+nshort*7, transf_buf+nshort*8,
+            window_short+nshort-1, window_short, trans);
 
         /* window the second half and save as overlap for next frame */
-        for(i = 0; i < nshort; i++)
+        window_ola(overlap+(nflat_ls+4*nshort+trans-nlong),
+            transf_buf+nshort*7+trans, transf_buf+nshort*8+trans,
+            window_short+nshort-1-trans, window_short+trans, nshort-trans);
+        for (i = 5; i < 8; i++)
         {
-            if (i >= trans)
-                overlap[nflat_ls+4*nshort+i-nlong] = MUL_F(transf_buf[nshort*7+i],window_short[nshort-1-i]) + MUL_F(transf_buf[nshort*8+i],window_short[i]);
-            overlap[nflat_ls+5*nshort+i-nlong] = MUL_F(transf_buf[nshort*9+i],window_short[nshort-1-i]) + MUL_F(transf_buf[nshort*10+i],window_short[i]);
-            overlap[nflat_ls+6*nshort+i-nlong] = MUL_F(transf_buf[nshort*11+i],window_short[nshort-1-i]) + MUL_F(transf_buf[nshort*12+i],window_short[i]);
-            overlap[nflat_ls+7*nshort+i-nlong] = MUL_F(transf_buf[nshort*13+i],window_short[nshort-1-i]) + MUL_F(transf_buf[nshort*14+i],window_short[i]);
-            overlap[nflat_ls+8*nshort+i-nlong] = MUL_F(transf_buf[nshort*15+i],window_short[nshort-1-i]);
+            window_ola(overlap+(nflat_ls+i*nshort-nlong),
+                transf_buf+nshort*(2*i-1), transf_buf+nshort*2*i,
+                window_short+nshort-1, window_short, nshort);
         }
+        window_rev(overlap+(nflat_ls+8*nshort-nlong), transf_buf+nshort*15, window_short+nshort-1, nshort);
         for (i = 0; i < nflat_ls; i++)
             overlap[nflat_ls+nshort+i] = 0;
         break;
@@ -305,14 +356,12 @@ void ifilter_bank(fb_info *fb, uint8_t window_sequence, uint8_t window_shape,
         /* construct first half window using padding with 1's and 0's */
         for (i = 0; i < nflat_ls; i++)
             time_out[i] = overlap[i];
-        for (i = 0; i < nshort; i++)
-            time_out[nflat_ls+i] = overlap[nflat_ls+i] + MUL_F(transf_buf[nflat_ls+i],window_short_prev[i]);
+        window_add(time_out+nflat_ls, overlap+nflat_ls, transf_buf+nflat_ls, window_short_prev, nshort);
         for (i = 0; i < nflat_ls; i++)
             time_out[nflat_ls+nshort+i] = overlap[nflat_ls+nshort+i] + transf_buf[nflat_ls+nshort+i];
 
         /* window the second half and save as overlap for next frame */
-        for (i = 0; i < nlong; i++)
-            overlap[i] = MUL_F(transf_buf[nlong+i],window_long[nlong-1-i]);
+        window_rev(overlap, transf_buf+nlong, window_long+nlong-1, nlong);
 		break;
     }
 
@@ -38,6 +38,7 @@
 
 #include "bits.h"
 #include "huffman.h"
+#include "threads.h"
 #include "codebook/hcb.h"
 
 
@@ -54,6 +55,7 @@ static uint8_t huffman_binary_pair(uint8_t cb, bitfile *ld, int16_t *sp);
 static uint8_t huffman_binary_pair_sign(uint8_t cb, bitfile *ld, int16_t *sp);
 static int16_t huffman_codebook(uint8_t i);
 static void vcb11_check_LAV(uint8_t cb, int16_t *sp);
+static void huffman_build_lut(uint8_t cb);
 
 int8_t huffman_scale_factor(bitfile *ld)
 {
@@ -104,6 +106,22 @@ int hcb_2_quad_table_size[] = { 0, 114, 86, 0, 185, 0, 0, 0, 0, 0, 0, 0 };
 int hcb_2_pair_table_size[] = { 0, 0, 0, 0, 0, 0, 126, 0, 83, 0, 210, 373 };
 int hcb_bin_table_size[] = { 0, 0, 0, 161, 0, 161, 0, 127, 0, 337, 0, 0 };
 
+/* lookahead tables for huffman_spectral_section(), indexed by the next
+   HCB_LUT_BITS bits of the stream. An entry holds as many complete
+   codewords, sign bits included, as fit in those bits (up to
+   hcb_lut_max[cb]): bits 0-4 are the number of bits used, bits 5-6 the
+   number of codewords and bits 8-31 the signed values, hcb_lut_width[cb]
+   bits each. No codewords means that the first one is longer or has an
+   escape. */
+#define HCB_LUT_BITS 10
+
+static uint32_t hcb_lut[ESC_HCB+1][1 << HCB_LUT_BITS];
+static uint8_t hcb_lut_ready = 0;
+static faad_mutex hcb_lut_lock = FAAD_MUTEX_INITIALIZER;
+
+static const uint8_t hcb_lut_width[] = { 0, 2, 2, 3, 3, 4, 4, 4, 4, 5, 5, 5 };
+static const uint8_t hcb_lut_max[] = { 0, 3, 3, 2, 2, 3, 3, 3, 3, 2, 2, 2 };
+
 static INLINE void huffman_sign_bits(bitfile *ld, int16_t *sp, uint8_t len)
 {
     uint8_t i;
@@ -399,6 +417,120 @@ uint8_t huffman_spectral_data(uint8_t cb, bitfile *ld, int16_t *sp)
 }
 
 
+/* fills hcb_lut[cb] by running the codeword decoders above on every
+   HCB_LUT_BITS bit pattern */
+static void huffman_build_lut(uint8_t cb)
+{
+    uint8_t dim = (cb < FIRST_PAIR_HCB) ? QUAD_LEN : PAIR_LEN;
+    uint8_t width = hcb_lut_width[cb];
+    uint32_t v;
+
+    for (v = 0; v < (1 << HCB_LUT_BITS); v++)
+    {
+        uint32_t word = v << (32 - HCB_LUT_BITS);
+        uint8_t buf[8] = { 0 };
+        uint32_t entry = 0, used = 0, shift = 8;
+        uint8_t n, i;
+        bitfile ld;
+
+        buf[0] = (uint8_t)(word >> 24);
+        buf[1] = (uint8_t)(word >> 16);
+        buf[2] = (uint8_t)(word >> 8);
+        buf[3] = (uint8_t)word;
+        faad_initbits(&ld, buf, sizeof(buf));
+
+        for (n = 0; n < hcb_lut_max[cb]; n++)
+        {
+            int16_t sp[QUAD_LEN];
+            uint8_t err, esc = 0;
+
+            /* escapes are left to huffman_spectral_data() */
+            if (cb == ESC_HCB)
+                err = huffman_2step_pair_sign(cb, &ld, sp);
+            else
+                err = huffman_spectral_data(cb, &ld, sp);
+
+            for (i = 0; i < dim; i++)
+            {
+                if ((sp[i] == 16) || (sp[i] == -16))
+                    esc = 1;
+            }
+            if (err || esc || (faad_get_processed_bits(&ld) > HCB_LUT_BITS))
+                break;
+
+            used = faad_get_processed_bits(&ld);
+            for (i = 0; i < dim; i++, shift += width)
+                entry |= ((uint32_t)sp[i] & ((1 << width) - 1)) << shift;
+        }
+
+        hcb_lut[cb][v] = entry | (n << 5) | used;
+    }
+}
+
+/* builds the lookahead tables, once for all decoders */
+void huffman_init(void)
+{
+    uint8_t cb;
+
+    faad_mutex_lock(&hcb_lut_lock);
+    if (!hcb_lut_ready)
+    {
+        for (cb = 1; cb <= ESC_HCB; cb++)
+            huffman_build_lut(cb);
+        hcb_lut_ready = 1;
+    }
+    faad_mutex_unlock(&hcb_lut_lock);
+}
+
+/* decodes the len values of a whole section, several codewords per table
+   lookup where possible; same results as huffman_spectral_data() */
+uint8_t huffman_spectral_section(uint8_t cb, bitfile *ld, int16_t *sp, uint16_t len)
+{
+    uint8_t dim = (cb < FIRST_PAIR_HCB) ? QUAD_LEN : PAIR_LEN;
+    uint16_t k = 0;
+    uint8_t err;
+
+    /* with the error flag set flushing does nothing, so every codeword
+       would be decoded from the same bits */
+    if ((cb <= ESC_HCB) && !ld->error)
+    {
+        const uint32_t *lut = hcb_lut[cb];
+        const uint8_t width = hcb_lut_width[cb];
+
+        while (k < len)
+        {
+            uint32_t e = lut[faad_showbits(ld, HCB_LUT_BITS)];
+            uint32_t n = ((e >> 5) & 3) * dim;
+            uint32_t i, v;
+
+            if ((n == 0) || (n > (uint32_t)(len - k)))
+            {
+                /* long codeword, escape or end of the section */
+                if ((err = huffman_spectral_data(cb, ld, &sp[k])) > 0)
+                    return err;
+                k += dim;
+                continue;
+            }
+
+            faad_flushbits(ld, e & 31);
+            for (i = 0, v = e >> 8; i < n; i++, v >>= width)
+                sp[k+i] = (int16_t)((int32_t)(v << (32 - width)) >> (32 - width));
+            k += n;
+        }
+
+        return 0;
+    }
+
+    for (k = 0; k < len; k += dim)
+    {
+        if ((err = huffman_spectral_data(cb, ld, &sp[k])) > 0)
+            return err;
+    }
+
+    return 0;
+}
+
+
 #ifdef ERROR_RESILIENCE
 
 /* Special version of huffman_spectral_data
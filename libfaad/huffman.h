@@ -35,8 +35,10 @@
 extern "C" {
 #endif
 
+void huffman_init(void);
 int8_t huffman_scale_factor(bitfile *ld);
 uint8_t huffman_spectral_data(uint8_t cb, bitfile *ld, int16_t *sp);
+uint8_t huffman_spectral_section(uint8_t cb, bitfile *ld, int16_t *sp, uint16_t len);
 #ifdef ERROR_RESILIENCE
 int8_t huffman_spectral_data_2(uint8_t cb, bits_t *ld, int16_t *sp);
 #endif
@@ -41,7 +41,12 @@ extern "C" {
 
 #ifndef FIXED_POINT
 
+#ifdef SMALL_IQ_TABLE
+/* only the common small magnitudes, iquant() computes the others */
+#define IQ_TABLE_SIZE 256
+#else
 #define IQ_TABLE_SIZE 8192
+#endif
 
 #ifdef _MSC_VER
 #pragma warning(disable:4305)
@@ -306,6 +311,7 @@ ALIGN static const real_t iq_table[IQ_TABLE_SIZE] =
     1600.1499964845941,
     1608.58848496618,
     1617.0380548731737,
+#ifndef SMALL_IQ_TABLE
     1625.4986772154357,
     1633.9703231916887,
     1642.4529641875577,
@@ -8242,6 +8248,7 @@ ALIGN static const real_t iq_table[IQ_TABLE_SIZE] =
     165059.7418265946,
     165086.61740784015,
     165113.4940829452
+#endif
 };
 
 #else
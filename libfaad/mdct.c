@@ -57,9 +57,23 @@
 #include "cfft.h"
 #include "mdct.h"
 #include "mdct_tab.h"
+#include "threads.h"
 
 
-mdct_info *faad_mdct_init(uint16_t N)
+/* mdct_info and its cfft_info only depend on N and are read only after
+   creation, so all decoders share one reference counted instance per size */
+#define MDCT_CACHE_SIZE 8
+
+typedef struct
+{
+    mdct_info *mdct;
+    uint32_t refcount;
+} mdct_cache_entry;
+
+static mdct_cache_entry mdct_cache[MDCT_CACHE_SIZE];
+static faad_mutex mdct_cache_lock = FAAD_MUTEX_INITIALIZER;
+
+static mdct_info *mdct_create(uint16_t N)
 {
     mdct_info *mdct = (mdct_info*)faad_malloc(sizeof(mdct_info));
 
@@ -104,7 +118,7 @@ mdct_info *faad_mdct_init(uint16_t N)
     return mdct;
 }
 
-void faad_mdct_end(mdct_info *mdct)
+static void mdct_destroy(mdct_info *mdct)
 {
     if (mdct != NULL)
     {
@@ -119,17 +133,104 @@ void faad_mdct_end(mdct_info *mdct)
     }
 }
 
+mdct_info *faad_mdct_init(uint16_t N)
+{
+    uint8_t i;
+    mdct_info *mdct = NULL;
+    faad_allocator *prev;
+
+    faad_mutex_lock(&mdct_cache_lock);
+
+    for (i = 0; i < MDCT_CACHE_SIZE; i++)
+    {
+        if ((mdct_cache[i].mdct != NULL) && (mdct_cache[i].mdct->N == N))
+        {
+            mdct = mdct_cache[i].mdct;
+            mdct_cache[i].refcount++;
+            break;
+        }
+    }
+
+    if (mdct == NULL)
+    {
+        /* shared tables must not come from a decoder's allocator */
+        prev = faad_set_allocator(NULL);
+        mdct = mdct_create(N);
+        faad_set_allocator(prev);
+
+        for (i = 0; i < MDCT_CACHE_SIZE; i++)
+        {
+            if (mdct_cache[i].mdct == NULL)
+            {
+                mdct_cache[i].mdct = mdct;
+                mdct_cache[i].refcount = 1;
+                break;
+            }
+        }
+    }
+
+    faad_mutex_unlock(&mdct_cache_lock);
+
+    return mdct;
+}
+
+void faad_mdct_end(mdct_info *mdct)
+{
+    uint8_t i;
+    faad_allocator *prev;
+
+    if (mdct == NULL)
+        return;
+
+    faad_mutex_lock(&mdct_cache_lock);
+
+    for (i = 0; i < MDCT_CACHE_SIZE; i++)
+    {
+        if (mdct_cache[i].mdct == mdct)
+        {
+            if (--mdct_cache[i].refcount == 0)
+            {
+                mdct_cache[i].mdct = NULL;
+
+                prev = faad_set_allocator(NULL);
+                mdct_destroy(mdct);
+                faad_set_allocator(prev);
+            }
+            break;
+        }
+    }
+
+    faad_mutex_unlock(&mdct_cache_lock);
+
+    /* not cached because the cache was full */
+    if (i == MDCT_CACHE_SIZE)
+    {
+        prev = faad_set_allocator(NULL);
+        mdct_destroy(mdct);
+        faad_set_allocator(prev);
+    }
+}
+
+/* post-IFFT complex multiplication of Z[k] */
+static INLINE void imdct_post(complex_t y, const complex_t *Z,
+                              const complex_t *sincos, uint16_t k)
+{
+    ComplexMult(&IM(y), &RE(y),
+        IM(Z[k]), RE(Z[k]), RE(sincos[k]), IM(sincos[k]));
+}
+
 void faad_imdct(mdct_info *mdct, real_t *X_in, real_t *X_out)
 {
-    uint16_t k;
+    uint16_t k, j;
 
-    complex_t x;
 #ifdef ALLOW_SMALL_FRAMELENGTH
 #ifdef FIXED_POINT
     real_t scale, b_scale = 0;
 #endif
 #endif
     ALIGN complex_t Z1[512];
+    ALIGN complex_t work[512];
+    complex_t *Z;
     complex_t *sincos = mdct->sincos;
 
     uint16_t N  = mdct->N;
@@ -165,66 +266,209 @@ void faad_imdct(mdct_info *mdct, real_t *X_in, real_t *X_out)
     count1 = faad_get_ts();
 #endif
 
-    /* complex IFFT, any non-scaling FFT can be used here */
-    cfftb(mdct->cfft, Z1);
+    /* complex IFFT, any non-scaling FFT can be used here; the result is
+       in Z1 or in work, depending on the number of passes */
+    Z = cfftb_buf(mdct->cfft, Z1, work);
 
 #ifdef PROFILE
     count1 = faad_get_ts() - count1;
 #endif
 
-    /* post-IFFT complex multiplication */
-    for (k = 0; k < N4; k++)
+    /* post-IFFT complex multiplication and reordering in one pass: output
+       pairs k and N8-1-k use the same four values of Z (N8 is even) */
+    for (k = 0; k < N8/2; k++)
     {
-        RE(x) = RE(Z1[k]);
-        IM(x) = IM(Z1[k]);
-        ComplexMult(&IM(Z1[k]), &RE(Z1[k]),
-            IM(x), RE(x), RE(sincos[k]), IM(sincos[k]));
+        complex_t y[4];
+
+        j = N8 - 1 - k;
+
+        imdct_post(y[0], Z, sincos, k);
+        imdct_post(y[1], Z, sincos, j);
+        imdct_post(y[2], Z, sincos, N8 + k);
+        imdct_post(y[3], Z, sincos, N4 - 1 - k);
 
 #ifdef ALLOW_SMALL_FRAMELENGTH
 #ifdef FIXED_POINT
         /* non-power of 2 MDCT scaling */
         if (b_scale)
         {
-            RE(Z1[k]) = MUL_C(RE(Z1[k]), scale);
-            IM(Z1[k]) = MUL_C(IM(Z1[k]), scale);
+            uint8_t i;
+
+            for (i = 0; i < 4; i++)
+            {
+                RE(y[i]) = MUL_C(RE(y[i]), scale);
+                IM(y[i]) = MUL_C(IM(y[i]), scale);
+            }
         }
 #endif
 #endif
+
+        X_out[              2*k] =  IM(y[2]);
+        X_out[              2*j] =  IM(y[3]);
+        X_out[          1 + 2*k] = -RE(y[1]);
+        X_out[          1 + 2*j] = -RE(y[0]);
+
+        X_out[N4 +          2*k] =  RE(y[0]);
+        X_out[N4 +          2*j] =  RE(y[1]);
+        X_out[N4 +      1 + 2*k] = -IM(y[3]);
+        X_out[N4 +      1 + 2*j] = -IM(y[2]);
+
+        X_out[N2 +          2*k] =  RE(y[2]);
+        X_out[N2 +          2*j] =  RE(y[3]);
+        X_out[N2 +      1 + 2*k] = -IM(y[1]);
+        X_out[N2 +      1 + 2*j] = -IM(y[0]);
+
+        X_out[N2 + N4 +     2*k] = -IM(y[0]);
+        X_out[N2 + N4 +     2*j] = -IM(y[1]);
+        X_out[N2 + N4 + 1 + 2*k] =  RE(y[3]);
+        X_out[N2 + N4 + 1 + 2*j] =  RE(y[2]);
     }
 
-    /* reordering */
-    for (k = 0; k < N8; k+=2)
-    {
-        X_out[              2*k] =  IM(Z1[N8 +     k]);
-        X_out[          2 + 2*k] =  IM(Z1[N8 + 1 + k]);
+#ifdef PROFILE
+    count2 = faad_get_ts() - count2;
+    mdct->fft_cycles += count1;
+    mdct->cycles += (count2 - count1);
+#endif
+}
+
+#ifdef SIMD_V4
+/* largest N done four blocks at a time (short blocks) */
+#define IMDCT_X4_MAX_N 256
 
-        X_out[          1 + 2*k] = -RE(Z1[N8 - 1 - k]);
-        X_out[          3 + 2*k] = -RE(Z1[N8 - 2 - k]);
+static INLINE void imdct_pre_x4(v4sf *Z, uint16_t k, v4sf x1, v4sf x2,
+                                const complex_t *sincos)
+{
+    const v4sf c1 = v4_set1(RE(sincos[k]));
+    const v4sf c2 = v4_set1(IM(sincos[k]));
 
-        X_out[N4 +          2*k] =  RE(Z1[         k]);
-        X_out[N4 +    + 2 + 2*k] =  RE(Z1[     1 + k]);
+    IM4(Z, k) = v4_add(v4_mul(x1, c1), v4_mul(x2, c2));
+    RE4(Z, k) = v4_sub(v4_mul(x2, c1), v4_mul(x1, c2));
+}
 
-        X_out[N4 +      1 + 2*k] = -IM(Z1[N4 - 1 - k]);
-        X_out[N4 +      3 + 2*k] = -IM(Z1[N4 - 2 - k]);
+static INLINE void imdct_post_x4(v4sf *y, const v4sf *Z, uint16_t k,
+                                 const complex_t *sincos)
+{
+    const v4sf c1 = v4_set1(RE(sincos[k]));
+    const v4sf c2 = v4_set1(IM(sincos[k]));
 
-        X_out[N2 +          2*k] =  RE(Z1[N8 +     k]);
-        X_out[N2 +    + 2 + 2*k] =  RE(Z1[N8 + 1 + k]);
+    IM4(y, 0) = v4_add(v4_mul(IM4(Z, k), c1), v4_mul(RE4(Z, k), c2));
+    RE4(y, 0) = v4_sub(v4_mul(RE4(Z, k), c1), v4_mul(IM4(Z, k), c2));
+}
 
-        X_out[N2 +      1 + 2*k] = -IM(Z1[N8 - 1 - k]);
-        X_out[N2 +      3 + 2*k] = -IM(Z1[N8 - 2 - k]);
+/* faad_imdct() of four consecutive blocks, one per vector lane, with
+   the same operations per block */
+static void imdct_x4(mdct_info *mdct, real_t *X_in, real_t *X_out)
+{
+    uint16_t k, j;
+    ALIGN v4sf Z1[IMDCT_X4_MAX_N/2];
+    ALIGN v4sf work[IMDCT_X4_MAX_N/2];
+    ALIGN v4sf out[IMDCT_X4_MAX_N];
+    v4sf *Z;
+    complex_t *sincos = mdct->sincos;
 
-        X_out[N2 + N4 +     2*k] = -IM(Z1[         k]);
-        X_out[N2 + N4 + 2 + 2*k] = -IM(Z1[     1 + k]);
+    uint16_t N  = mdct->N;
+    uint16_t N2 = N >> 1;
+    uint16_t N4 = N >> 2;
+    uint16_t N8 = N >> 3;
 
-        X_out[N2 + N4 + 1 + 2*k] =  RE(Z1[N4 - 1 - k]);
-        X_out[N2 + N4 + 3 + 2*k] =  RE(Z1[N4 - 2 - k]);
+    /* pre-IFFT complex multiplication; transposing 4 inputs of each block
+       gives X_in[2*k] and X_in[N2-1-2*k] for k, k+1, N4-1-k and N4-2-k */
+    for (k = 0; k < N4/2; k += 2)
+    {
+        v4sf a0, a1, a2, a3, b0, b1, b2, b3;
+
+        a0 = v4_load(&X_in[       2*k]);
+        a1 = v4_load(&X_in[  N2 + 2*k]);
+        a2 = v4_load(&X_in[2*N2 + 2*k]);
+        a3 = v4_load(&X_in[3*N2 + 2*k]);
+        v4_transpose(a0, a1, a2, a3);
+
+        b0 = v4_load(&X_in[  N2 - 4 - 2*k]);
+        b1 = v4_load(&X_in[2*N2 - 4 - 2*k]);
+        b2 = v4_load(&X_in[3*N2 - 4 - 2*k]);
+        b3 = v4_load(&X_in[4*N2 - 4 - 2*k]);
+        v4_transpose(b0, b1, b2, b3);
+
+        imdct_pre_x4(Z1, k,          a0, b3, sincos);
+        imdct_pre_x4(Z1, k + 1,      a2, b1, sincos);
+        imdct_pre_x4(Z1, N4 - 1 - k, b2, a1, sincos);
+        imdct_pre_x4(Z1, N4 - 2 - k, b0, a3, sincos);
     }
 
-#ifdef PROFILE
-    count2 = faad_get_ts() - count2;
-    mdct->fft_cycles += count1;
-    mdct->cycles += (count2 - count1);
+    Z = cfftb_x4(mdct->cfft, Z1, work);
+
+    /* post-IFFT complex multiplication and reordering, as in faad_imdct() */
+    for (k = 0; k < N8/2; k++)
+    {
+        v4sf y[8];
+
+        j = N8 - 1 - k;
+
+        imdct_post_x4(&RE4(y, 0), Z, k, sincos);
+        imdct_post_x4(&RE4(y, 1), Z, j, sincos);
+        imdct_post_x4(&RE4(y, 2), Z, N8 + k, sincos);
+        imdct_post_x4(&RE4(y, 3), Z, N4 - 1 - k, sincos);
+
+        out[              2*k] =        IM4(y, 2);
+        out[              2*j] =        IM4(y, 3);
+        out[          1 + 2*k] = v4_neg(RE4(y, 1));
+        out[          1 + 2*j] = v4_neg(RE4(y, 0));
+
+        out[N4 +          2*k] =        RE4(y, 0);
+        out[N4 +          2*j] =        RE4(y, 1);
+        out[N4 +      1 + 2*k] = v4_neg(IM4(y, 3));
+        out[N4 +      1 + 2*j] = v4_neg(IM4(y, 2));
+
+        out[N2 +          2*k] =        RE4(y, 2);
+        out[N2 +          2*j] =        RE4(y, 3);
+        out[N2 +      1 + 2*k] = v4_neg(IM4(y, 1));
+        out[N2 +      1 + 2*j] = v4_neg(IM4(y, 0));
+
+        out[N2 + N4 +     2*k] = v4_neg(IM4(y, 0));
+        out[N2 + N4 +     2*j] = v4_neg(IM4(y, 1));
+        out[N2 + N4 + 1 + 2*k] =        RE4(y, 3);
+        out[N2 + N4 + 1 + 2*j] =        RE4(y, 2);
+    }
+
+    /* back to one block after the other */
+    for (k = 0; k < N; k += 4)
+    {
+        v4sf o0 = out[k], o1 = out[k+1], o2 = out[k+2], o3 = out[k+3];
+
+        v4_transpose(o0, o1, o2, o3);
+
+        v4_store(&X_out[      k], o0);
+        v4_store(&X_out[  N + k], o1);
+        v4_store(&X_out[2*N + k], o2);
+        v4_store(&X_out[3*N + k], o3);
+    }
+}
 #endif
+
+/* count consecutive blocks, X_in + i*N/2 to X_out + i*N */
+void faad_imdct_multi(mdct_info *mdct, real_t *X_in, real_t *X_out, uint8_t count)
+{
+    uint16_t N = mdct->N;
+
+#ifdef SIMD_V4
+    /* the transposes need N4 to be a multiple of 4 */
+    if ((N <= IMDCT_X4_MAX_N) && ((N % 16) == 0))
+    {
+        for (; count >= 4; count -= 4)
+        {
+            imdct_x4(mdct, X_in, X_out);
+            X_in += 2*N;
+            X_out += 4*N;
+        }
+    }
+#endif
+
+    for (; count > 0; count--)
+    {
+        faad_imdct(mdct, X_in, X_out);
+        X_in += N/2;
+        X_out += N;
+    }
 }
 
 #ifdef LTP_DEC
@@ -234,6 +478,8 @@ void faad_mdct(mdct_info *mdct, real_t *X_in, real_t *X_out)
 
     complex_t x;
     ALIGN complex_t Z1[512];
+    ALIGN complex_t work[512];
+    complex_t *Z;
     complex_t *sincos = mdct->sincos;
 
     uint16_t N  = mdct->N;
@@ -283,14 +529,14 @@ void faad_mdct(mdct_info *mdct, real_t *X_in, real_t *X_out)
     }
 
     /* complex FFT, any non-scaling FFT can be used here  */
-    cfftf(mdct->cfft, Z1);
+    Z = cfftf_buf(mdct->cfft, Z1, work);
 
     /* post-FFT complex multiplication */
     for (k = 0; k < N4; k++)
     {
         uint16_t n = k << 1;
         ComplexMult(&RE(x), &IM(x),
-            RE(Z1[k]), IM(Z1[k]), RE(sincos[k]), IM(sincos[k]));
+            RE(Z[k]), IM(Z[k]), RE(sincos[k]), IM(sincos[k]));
 
         X_out[         n] = -RE(x);
         X_out[N2 - 1 - n] =  IM(x);
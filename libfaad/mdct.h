@@ -39,6 +39,7 @@ extern "C" {
 mdct_info *faad_mdct_init(uint16_t N);
 void faad_mdct_end(mdct_info *mdct);
 void faad_imdct(mdct_info *mdct, real_t *X_in, real_t *X_out);
+void faad_imdct_multi(mdct_info *mdct, real_t *X_in, real_t *X_out, uint8_t count);
 void faad_mdct(mdct_info *mdct, real_t *X_in, real_t *X_out);
 
 
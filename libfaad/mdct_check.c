@@ -0,0 +1,288 @@
+/*
+** FAAD2 - Freeware Advanced Audio (AAC) Decoder including SBR decoding
+** Copyright (C) 2003-2005 M. Bakker, Nero AG, http://www.nero.com
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**
+** Any non-GPL usage of this software or parts of this software is strictly
+** forbidden.
+**
+** The "appropriate copyright message" mentioned in section 2c of the GPLv2
+** must read: "Code from FAAD2 is copyright (c) Nero AG, www.nero.com"
+**
+** Commercial non-GPL licensing of this software is possible.
+** For more info contact Nero AG through Mpeg4AAClicense@nero.com.
+**
+** $Id$
+**/
+
+/*
+ * make check: faad_imdct(), faad_imdct_multi() and faad_mdct() must give
+ * the same bits as the plain transform, which does the pre-twiddle, an in
+ * place FFT, the post-twiddle and the reordering in separate passes.
+ */
+
+#include "common.h"
+#include "structs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfft.h"
+#include "mdct.h"
+
+#define MAX_N    2048
+#define RUNS     50
+#define BLOCKS   8
+
+static const uint16_t sizes[] = {
+    2048, 256,
+#ifdef LD_DEC
+    1024,
+#endif
+#ifdef ALLOW_SMALL_FRAMELENGTH
+    1920, 240,
+#ifdef LD_DEC
+    960,
+#endif
+#endif
+};
+
+static void ref_imdct(mdct_info *mdct, real_t *X_in, real_t *X_out)
+{
+    uint16_t k;
+
+    complex_t x;
+#ifdef ALLOW_SMALL_FRAMELENGTH
+#ifdef FIXED_POINT
+    real_t scale = 0, b_scale = 0;
+#endif
+#endif
+    ALIGN complex_t Z1[512];
+    complex_t *sincos = mdct->sincos;
+
+    uint16_t N  = mdct->N;
+    uint16_t N2 = N >> 1;
+    uint16_t N4 = N >> 2;
+    uint16_t N8 = N >> 3;
+
+#ifdef ALLOW_SMALL_FRAMELENGTH
+#ifdef FIXED_POINT
+    if (N & (N-1))
+    {
+        b_scale = 1;
+        scale = COEF_CONST(1.0666666666666667);
+    }
+#endif
+#endif
+
+    for (k = 0; k < N4; k++)
+    {
+        ComplexMult(&IM(Z1[k]), &RE(Z1[k]),
+            X_in[2*k], X_in[N2 - 1 - 2*k], RE(sincos[k]), IM(sincos[k]));
+    }
+
+    cfftb(mdct->cfft, Z1);
+
+    for (k = 0; k < N4; k++)
+    {
+        RE(x) = RE(Z1[k]);
+        IM(x) = IM(Z1[k]);
+        ComplexMult(&IM(Z1[k]), &RE(Z1[k]),
+            IM(x), RE(x), RE(sincos[k]), IM(sincos[k]));
+
+#ifdef ALLOW_SMALL_FRAMELENGTH
+#ifdef FIXED_POINT
+        if (b_scale)
+        {
+            RE(Z1[k]) = MUL_C(RE(Z1[k]), scale);
+            IM(Z1[k]) = MUL_C(IM(Z1[k]), scale);
+        }
+#endif
+#endif
+    }
+
+    for (k = 0; k < N8; k+=2)
+    {
+        X_out[              2*k] =  IM(Z1[N8 +     k]);
+        X_out[          2 + 2*k] =  IM(Z1[N8 + 1 + k]);
+
+        X_out[          1 + 2*k] = -RE(Z1[N8 - 1 - k]);
+        X_out[          3 + 2*k] = -RE(Z1[N8 - 2 - k]);
+
+        X_out[N4 +          2*k] =  RE(Z1[         k]);
+        X_out[N4 +      2 + 2*k] =  RE(Z1[     1 + k]);
+
+        X_out[N4 +      1 + 2*k] = -IM(Z1[N4 - 1 - k]);
+        X_out[N4 +      3 + 2*k] = -IM(Z1[N4 - 2 - k]);
+
+        X_out[N2 +          2*k] =  RE(Z1[N8 +     k]);
+        X_out[N2 +      2 + 2*k] =  RE(Z1[N8 + 1 + k]);
+
+        X_out[N2 +      1 + 2*k] = -IM(Z1[N8 - 1 - k]);
+        X_out[N2 +      3 + 2*k] = -IM(Z1[N8 - 2 - k]);
+
+        X_out[N2 + N4 +     2*k] = -IM(Z1[         k]);
+        X_out[N2 + N4 + 2 + 2*k] = -IM(Z1[     1 + k]);
+
+        X_out[N2 + N4 + 1 + 2*k] =  RE(Z1[N4 - 1 - k]);
+        X_out[N2 + N4 + 3 + 2*k] =  RE(Z1[N4 - 2 - k]);
+    }
+}
+
+#ifdef LTP_DEC
+static void ref_mdct(mdct_info *mdct, real_t *X_in, real_t *X_out)
+{
+    uint16_t k;
+
+    complex_t x;
+    ALIGN complex_t Z1[512];
+    complex_t *sincos = mdct->sincos;
+
+    uint16_t N  = mdct->N;
+    uint16_t N2 = N >> 1;
+    uint16_t N4 = N >> 2;
+    uint16_t N8 = N >> 3;
+
+#ifndef FIXED_POINT
+    real_t scale = REAL_CONST(N);
+#else
+    real_t scale = REAL_CONST(4.0/N);
+#endif
+
+#ifdef ALLOW_SMALL_FRAMELENGTH
+#ifdef FIXED_POINT
+    if (N & (N-1))
+        scale = MUL_C(scale, COEF_CONST(1.0327955589886444));
+#endif
+#endif
+
+    for (k = 0; k < N8; k++)
+    {
+        uint16_t n = k << 1;
+        RE(x) = X_in[N - N4 - 1 - n] + X_in[N - N4 +     n];
+        IM(x) = X_in[    N4 +     n] - X_in[    N4 - 1 - n];
+
+        ComplexMult(&RE(Z1[k]), &IM(Z1[k]),
+            RE(x), IM(x), RE(sincos[k]), IM(sincos[k]));
+
+        RE(Z1[k]) = MUL_R(RE(Z1[k]), scale);
+        IM(Z1[k]) = MUL_R(IM(Z1[k]), scale);
+
+        RE(x) =  X_in[N2 - 1 - n] - X_in[        n];
+        IM(x) =  X_in[N2 +     n] + X_in[N - 1 - n];
+
+        ComplexMult(&RE(Z1[k + N8]), &IM(Z1[k + N8]),
+            RE(x), IM(x), RE(sincos[k + N8]), IM(sincos[k + N8]));
+
+        RE(Z1[k + N8]) = MUL_R(RE(Z1[k + N8]), scale);
+        IM(Z1[k + N8]) = MUL_R(IM(Z1[k + N8]), scale);
+    }
+
+    cfftf(mdct->cfft, Z1);
+
+    for (k = 0; k < N4; k++)
+    {
+        uint16_t n = k << 1;
+        ComplexMult(&RE(x), &IM(x),
+            RE(Z1[k]), IM(Z1[k]), RE(sincos[k]), IM(sincos[k]));
+
+        X_out[         n] = -RE(x);
+        X_out[N2 - 1 - n] =  IM(x);
+        X_out[N2 +     n] = -IM(x);
+        X_out[N  - 1 - n] =  RE(x);
+    }
+}
+#endif
+
+/* spectral and time samples well inside the range of the decoder */
+static void fill_random(real_t *x, uint16_t len, real_t range)
+{
+    static uint32_t r1 = 1, r2 = 1;
+    uint16_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        uint32_t r = ne_rng(&r1, &r2);
+#ifdef FIXED_POINT
+        x[i] = (real_t)((int32_t)(r % (uint32_t)(2*range + 1)) - range);
+#else
+        x[i] = range * ((real_t)r / 2147483648.0f - 1.0f);
+#endif
+    }
+}
+
+static uint16_t compare(const char *what, uint16_t N, const real_t *a, const real_t *b,
+                        uint16_t len)
+{
+    uint16_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        if (memcmp(&a[i], &b[i], sizeof(real_t)) != 0)
+        {
+            fprintf(stderr, "%s N=%d: sample %d differs\n", what, N, i);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    static ALIGN real_t in[BLOCKS*MAX_N], out[BLOCKS*MAX_N], ref[BLOCKS*MAX_N];
+    uint16_t s, failed = 0;
+#ifdef FIXED_POINT
+    const real_t range = REAL_CONST(8192);
+#else
+    const real_t range = REAL_CONST(32768);
+#endif
+
+    for (s = 0; s < sizeof(sizes)/sizeof(sizes[0]); s++)
+    {
+        uint16_t N = sizes[s], run, b;
+        mdct_info *mdct = faad_mdct_init(N);
+
+        for (run = 0; run < RUNS; run++)
+        {
+            fill_random(in, BLOCKS*N/2, range);
+
+            faad_imdct(mdct, in, out);
+            ref_imdct(mdct, in, ref);
+            failed += compare("faad_imdct", N, out, ref, N);
+
+            faad_imdct_multi(mdct, in, out, BLOCKS);
+            for (b = 0; b < BLOCKS; b++)
+                ref_imdct(mdct, in + b*N/2, ref + b*N);
+            failed += compare("faad_imdct_multi", N, out, ref, BLOCKS*N);
+
+#ifdef LTP_DEC
+            fill_random(in, N, range);
+
+            faad_mdct(mdct, in, out);
+            ref_mdct(mdct, in, ref);
+            failed += compare("faad_mdct", N, out, ref, N/2);
+#endif
+        }
+
+        faad_mdct_end(mdct);
+    }
+
+    if (failed)
+        fprintf(stderr, "%d transforms differ\n", failed);
+
+    return failed ? 1 : 0;
+}
@@ -61,6 +61,13 @@ void ms_decode(ic_stream *ics, ic_stream *icsr, real_t *l_spec, real_t *r_spec,
                     if ((ics->ms_used[g][sfb] || ics->ms_mask_present == 2) &&
                         !is_intensity(icsr, g, sfb) && !is_noise(ics, g, sfb))
                     {
+                        /* both bands are zero, so are their sum and difference */
+                        if (is_zero_band(ics, g, sfb) && is_zero_band(icsr, g, sfb) &&
+                            !is_noise(icsr, g, sfb))
+                        {
+                            continue;
+                        }
+
                         for (i = ics->swb_offset[sfb]; i < min(ics->swb_offset[sfb+1], ics->swb_offset_max); i++)
                         {
                             k = (group*nshort) + i;
@@ -35,9 +35,31 @@
 extern "C" {
 #endif
 
+#include "syntax.h"
+
 void ms_decode(ic_stream *ics, ic_stream *icsr, real_t *l_spec, real_t *r_spec,
                uint16_t frame_len);
 
+/* no spectral values were coded for the band, its quantised data is all zero;
+   noise and intensity bands get filled later by pns_decode() and is_decode() */
+static INLINE uint8_t is_zero_band(ic_stream *ics, uint8_t group, uint8_t sfb)
+{
+    if (ics->pulse_data_present)
+        return 0;
+    if (sfb >= ics->max_sfb)
+        return 1;
+    switch (ics->sfb_cb[group][sfb])
+    {
+    case ZERO_HCB:
+    case NOISE_HCB:
+    case INTENSITY_HCB:
+    case INTENSITY_HCB2:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
 #ifdef __cplusplus
 }
 #endif
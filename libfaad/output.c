@@ -33,6 +33,17 @@
 
 #include "output.h"
 
+/* xorshift32, one lane of hDecoder->dither_state */
+static INLINE uint32_t dither_rng(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return (*state = x);
+}
+
 #ifndef FIXED_POINT
 
 
@@ -86,13 +97,252 @@ if (sample >= 0.0f)            \
 
 #define CONV(a,b) ((a<<1)|(b&0x1))
 
+/* triangular dither in (-1, 1) LSB: the sum of two uniform values in
+   [-0.5, 0.5) */
+static INLINE real_t tpdf_dither(NeAACDecStruct *hDecoder)
+{
+    real_t r1 = (real_t)(int32_t)dither_rng(&hDecoder->dither_state[0]);
+    real_t r2 = (real_t)(int32_t)dither_rng(&hDecoder->dither_state[0]);
+
+    return (r1 + r2) * (1.0f/4294967296.0f);
+}
+
+#ifdef SIMD_V4
+/* samples per channel interleaved at a time by to_PCM_simd() */
+#define PCM_BLOCK 64
+
+/* get_sample() for the four samples starting at sample */
+static INLINE v4sf get_sample4(real_t **input, uint8_t channel, uint16_t sample,
+                               uint8_t down_matrix, uint8_t *internal_channel)
+{
+    const v4sf dm_mul = v4_set1(DM_MUL), rsqrt2 = v4_set1(RSQRT2);
+    v4sf c, s;
+
+    if (!down_matrix)
+        return v4_load(&input[internal_channel[channel]][sample]);
+
+    c = v4_mul(v4_load(&input[internal_channel[0]][sample]), rsqrt2);
+    s = v4_mul(v4_load(&input[internal_channel[channel ? 4 : 3]][sample]), rsqrt2);
+    return v4_mul(dm_mul, v4_add(v4_add(
+        v4_load(&input[internal_channel[channel+1]][sample]), c), s));
+}
+
+/* dither_rng() in every lane */
+static INLINE v4si dither_rng4(v4si x)
+{
+    x = v4i_xor(x, v4i_shl(x, 13));
+    x = v4i_xor(x, v4i_shr(x, 17));
+    return v4i_xor(x, v4i_shl(x, 5));
+}
+
+/* CLIP() followed by lrintf(), or by the cast without HAS_LRINTF; NaN
+   gives 0 */
+static INLINE v4si clip_round4(v4sf x, float max, float min)
+{
+    const v4sf zero = v4_set1(0.0f);
+
+    x = v4_sel_eq(x, x, x, zero);
+#ifndef HAS_LRINTF
+    x = v4_add(x, v4_sel_ge(x, zero, v4_set1(0.5f), v4_set1(-0.5f)));
+    return v4_trunc(v4_min(v4_max(x, v4_set1(min)), v4_set1(max)));
+#else
+    return v4_round(v4_min(v4_max(x, v4_set1(min)), v4_set1(max)));
+#endif
+}
+
+/* converts n samples, a multiple of 8, from in to sample_buffer[pos] */
+static void convert_PCM(const real_t *in, uint32_t n, void *sample_buffer,
+                        uint32_t pos, uint8_t format, v4si *dither)
+{
+    int16_t *short_out = (int16_t*)sample_buffer + pos;
+    int32_t *int_out = (int32_t*)sample_buffer + pos;
+    float32_t *float_out = (float32_t*)sample_buffer + pos;
+    const v4sf scale = v4_set1(1.0f/4294967296.0f);
+    uint32_t k;
+
+    switch (format)
+    {
+    case FAAD_FMT_16BIT:
+        for (k = 0; k < n; k += 8)
+        {
+            v4i_store_s16(short_out + k,
+                clip_round4(v4_load(in + k), 32767.0f, -32768.0f),
+                clip_round4(v4_load(in + k + 4), 32767.0f, -32768.0f));
+        }
+        break;
+    case FAAD_FMT_16BIT_DITHER:
+        {
+            v4si r = *dither;
+
+            for (k = 0; k < n; k += 8)
+            {
+                v4si r1 = dither_rng4(r);
+                v4si r2 = dither_rng4(r1);
+                v4si r3 = dither_rng4(r2);
+                v4sf a, b;
+
+                r = dither_rng4(r3);
+                a = v4_add(v4_load(in + k),
+                    v4_mul(v4_add(v4_from_int(r1), v4_from_int(r2)), scale));
+                b = v4_add(v4_load(in + k + 4),
+                    v4_mul(v4_add(v4_from_int(r3), v4_from_int(r)), scale));
+                v4i_store_s16(short_out + k,
+                    clip_round4(a, 32767.0f, -32768.0f), clip_round4(b, 32767.0f, -32768.0f));
+            }
+            *dither = r;
+        }
+        break;
+    case FAAD_FMT_24BIT:
+        for (k = 0; k < n; k += 4)
+        {
+            v4i_store(int_out + k, clip_round4(v4_mul(v4_load(in + k), v4_set1(256.0f)),
+                8388607.0f, -8388608.0f));
+        }
+        break;
+    case FAAD_FMT_32BIT:
+        for (k = 0; k < n; k += 4)
+        {
+            v4i_store(int_out + k, clip_round4(v4_mul(v4_load(in + k), v4_set1(65536.0f)),
+                2147483647.0f, -2147483648.0f));
+        }
+        break;
+    case FAAD_FMT_FLOAT:
+        for (k = 0; k < n; k += 4)
+            v4_store(float_out + k, v4_mul(v4_load(in + k), v4_set1(FLOAT_SCALE)));
+        break;
+    }
+}
+
+/* interleaved output of mono, stereo (also up- and downmixed) and 5.1,
+   converted from tmp a block at a time; returns 0 for the layouts that are
+   left to the C loops */
+static uint8_t to_PCM_simd(NeAACDecStruct *hDecoder, real_t **input,
+                           uint8_t channels, uint16_t frame_len,
+                           void *sample_buffer, uint8_t format)
+{
+    uint8_t *ic = hDecoder->internal_channel;
+    uint8_t dm = hDecoder->downMatrix;
+    real_t tmp[PCM_BLOCK*6];
+    /* float output needs no conversion, it is interleaved in place */
+    float32_t *float_out = (format == FAAD_FMT_FLOAT) ? (float32_t*)sample_buffer : NULL;
+    v4sf gain = v4_set1(float_out ? FLOAT_SCALE : 1.0f);
+    uint16_t i, s, n;
+    v4si dither;
+
+    if ((frame_len & 7) || ((channels > 2) && (channels != 6 || dm)))
+        return 0;
+
+    dither = v4i_load(hDecoder->dither_state);
+
+    if (channels == 1)
+    {
+        convert_PCM(input[ic[0]], frame_len, sample_buffer, 0, format, &dither);
+        v4i_store(hDecoder->dither_state, dither);
+        return 1;
+    }
+
+    for (i = 0; i < frame_len; i += n)
+    {
+        real_t *o = float_out ? float_out + (uint32_t)i*channels : tmp;
+
+        n = min(PCM_BLOCK, frame_len - i);
+
+        if (channels == 2)
+        {
+            for (s = i; s < i + n; s += 4, o += 8)
+            {
+                v4sf l, r;
+
+                if (hDecoder->upMatrix)
+                {
+                    l = r = v4_load(&input[ic[0]][s]);
+                } else {
+                    l = get_sample4(input, 0, s, dm, ic);
+                    r = get_sample4(input, 1, s, dm, ic);
+                }
+                v4_store(o, v4_mul(v4_zip_lo(l, r), gain));
+                v4_store(o + 4, v4_mul(v4_zip_hi(l, r), gain));
+            }
+        } else {
+            for (s = i; s < i + n; s += 4, o += 24)
+            {
+                v4sf c0 = v4_load(&input[ic[0]][s]);
+                v4sf c1 = v4_load(&input[ic[1]][s]);
+                v4sf c2 = v4_load(&input[ic[2]][s]);
+                v4sf c3 = v4_load(&input[ic[3]][s]);
+                v4sf c4 = v4_load(&input[ic[4]][s]);
+                v4sf c5 = v4_load(&input[ic[5]][s]);
+                v4sf lo = v4_zip_lo(c4, c5);
+                v4sf hi = v4_zip_hi(c4, c5);
+
+                /* c0..c3 become the first four channels of samples
+                   s..s+3, lo and hi hold the last two */
+                v4_transpose(c0, c1, c2, c3);
+                v4_store(o,      v4_mul(c0, gain));
+                v4_store(o + 4,  v4_mul(v4_lo_lo(lo, c1), gain));
+                v4_store(o + 8,  v4_mul(v4_hi_hi(c1, lo), gain));
+                v4_store(o + 12, v4_mul(c2, gain));
+                v4_store(o + 16, v4_mul(v4_lo_lo(hi, c3), gain));
+                v4_store(o + 20, v4_mul(v4_hi_hi(c3, hi), gain));
+            }
+        }
+
+        if (!float_out)
+        {
+            convert_PCM(tmp, (uint32_t)n*channels, sample_buffer, (uint32_t)i*channels,
+                format, &dither);
+        }
+    }
+
+    v4i_store(hDecoder->dither_state, dither);
+
+    return 1;
+}
+
+/* one channel of planar output, in is NULL for a downmix; returns the
+   number of samples done */
+static uint16_t to_PCM_planar_simd(NeAACDecStruct *hDecoder, real_t **input,
+                                   real_t *in, uint8_t ch, uint16_t frame_len,
+                                   void *sample_buffer, uint8_t format)
+{
+    real_t tmp[PCM_BLOCK];
+    uint16_t i, s, n, len = frame_len & ~7;
+
+    if (in != NULL)
+    {
+        convert_PCM(in, len, sample_buffer, 0, format, NULL);
+        return len;
+    }
+
+    for (i = 0; i < len; i += n)
+    {
+        n = min(PCM_BLOCK, len - i);
+
+        for (s = 0; s < n; s += 4)
+        {
+            v4_store(tmp + s, get_sample4(input, ch, i + s, hDecoder->downMatrix,
+                hDecoder->internal_channel));
+        }
+        convert_PCM(tmp, n, sample_buffer, i, format, NULL);
+    }
+
+    return len;
+}
+#endif
+
 static void to_PCM_16bit(NeAACDecStruct *hDecoder, real_t **input,
-                         uint8_t channels, uint16_t frame_len,
+                         uint8_t channels, uint16_t frame_len, uint8_t dither,
                          int16_t **sample_buffer)
 {
     uint8_t ch, ch1;
     uint16_t i;
 
+#ifdef SIMD_V4
+    if (to_PCM_simd(hDecoder, input, channels, frame_len, *sample_buffer,
+        dither ? FAAD_FMT_16BIT_DITHER : FAAD_FMT_16BIT))
+        return;
+#endif
+
     switch (CONV(channels,hDecoder->downMatrix))
     {
     case CONV(1,0):
@@ -101,6 +351,8 @@ static void to_PCM_16bit(NeAACDecStruct *hDecoder, real_t **input,
         {
             real_t inp = input[hDecoder->internal_channel[0]][i];
 
+            if (dither)
+                inp += tpdf_dither(hDecoder);
             CLIP(inp, 32767.0f, -32768.0f);
 
             (*sample_buffer)[i] = (int16_t)lrintf(inp);
@@ -114,6 +366,8 @@ static void to_PCM_16bit(NeAACDecStruct *hDecoder, real_t **input,
             {
                 real_t inp0 = input[ch][i];
 
+                if (dither)
+                    inp0 += tpdf_dither(hDecoder);
                 CLIP(inp0, 32767.0f, -32768.0f);
 
                 (*sample_buffer)[(i*2)+0] = (int16_t)lrintf(inp0);
@@ -127,6 +381,11 @@ static void to_PCM_16bit(NeAACDecStruct *hDecoder, real_t **input,
                 real_t inp0 = input[ch ][i];
                 real_t inp1 = input[ch1][i];
 
+                if (dither)
+                {
+                    inp0 += tpdf_dither(hDecoder);
+                    inp1 += tpdf_dither(hDecoder);
+                }
                 CLIP(inp0, 32767.0f, -32768.0f);
                 CLIP(inp1, 32767.0f, -32768.0f);
 
@@ -142,6 +401,8 @@ static void to_PCM_16bit(NeAACDecStruct *hDecoder, real_t **input,
             {
                 real_t inp = get_sample(input, ch, i, hDecoder->downMatrix, hDecoder->internal_channel);
 
+                if (dither)
+                    inp += tpdf_dither(hDecoder);
                 CLIP(inp, 32767.0f, -32768.0f);
 
                 (*sample_buffer)[(i*channels)+ch] = (int16_t)lrintf(inp);
@@ -158,6 +419,11 @@ static void to_PCM_24bit(NeAACDecStruct *hDecoder, real_t **input,
     uint8_t ch, ch1;
     uint16_t i;
 
+#ifdef SIMD_V4
+    if (to_PCM_simd(hDecoder, input, channels, frame_len, *sample_buffer, FAAD_FMT_24BIT))
+        return;
+#endif
+
     switch (CONV(channels,hDecoder->downMatrix))
     {
     case CONV(1,0):
@@ -228,6 +494,11 @@ static void to_PCM_32bit(NeAACDecStruct *hDecoder, real_t **input,
     uint8_t ch, ch1;
     uint16_t i;
 
+#ifdef SIMD_V4
+    if (to_PCM_simd(hDecoder, input, channels, frame_len, *sample_buffer, FAAD_FMT_32BIT))
+        return;
+#endif
+
     switch (CONV(channels,hDecoder->downMatrix))
     {
     case CONV(1,0):
@@ -298,6 +569,11 @@ static void to_PCM_float(NeAACDecStruct *hDecoder, real_t **input,
     uint8_t ch, ch1;
     uint16_t i;
 
+#ifdef SIMD_V4
+    if (to_PCM_simd(hDecoder, input, channels, frame_len, *sample_buffer, FAAD_FMT_FLOAT))
+        return;
+#endif
+
     switch (CONV(channels,hDecoder->downMatrix))
     {
     case CONV(1,0):
@@ -395,6 +671,135 @@ static void to_PCM_double(NeAACDecStruct *hDecoder, real_t **input,
     }
 }
 
+/* source buffer of output channel ch for planar output, NULL when the
+   channel is a downmix */
+static INLINE real_t *planar_input(NeAACDecStruct *hDecoder, real_t **input,
+                                   uint8_t channels, uint8_t ch)
+{
+    if (hDecoder->downMatrix && (channels > 1))
+        return NULL;
+
+    if (hDecoder->upMatrix)
+        return input[hDecoder->internal_channel[0]];
+
+    return input[hDecoder->internal_channel[ch]];
+}
+
+static void to_PCM_16bit_planar(NeAACDecStruct *hDecoder, real_t **input,
+                                uint8_t channels, uint16_t frame_len,
+                                int16_t *sample_buffer)
+{
+    uint8_t ch;
+    uint16_t i;
+
+    for (ch = 0; ch < channels; ch++)
+    {
+        real_t *in = planar_input(hDecoder, input, channels, ch);
+        int16_t *out = sample_buffer + ch*frame_len;
+
+#ifdef SIMD_V4
+        i = to_PCM_planar_simd(hDecoder, input, in, ch, frame_len, out, FAAD_FMT_16BIT);
+#else
+        i = 0;
+#endif
+        if (in != NULL)
+        {
+            for(; i < frame_len; i++)
+            {
+                real_t inp = in[i];
+
+                CLIP(inp, 32767.0f, -32768.0f);
+
+                out[i] = (int16_t)lrintf(inp);
+            }
+        } else {
+            for(; i < frame_len; i++)
+            {
+                real_t inp = get_sample(input, ch, i, hDecoder->downMatrix, hDecoder->internal_channel);
+
+                CLIP(inp, 32767.0f, -32768.0f);
+
+                out[i] = (int16_t)lrintf(inp);
+            }
+        }
+    }
+}
+
+static void to_PCM_32bit_planar(NeAACDecStruct *hDecoder, real_t **input,
+                                uint8_t channels, uint16_t frame_len,
+                                int32_t *sample_buffer)
+{
+    uint8_t ch;
+    uint16_t i;
+
+    for (ch = 0; ch < channels; ch++)
+    {
+        real_t *in = planar_input(hDecoder, input, channels, ch);
+        int32_t *out = sample_buffer + ch*frame_len;
+
+#ifdef SIMD_V4
+        i = to_PCM_planar_simd(hDecoder, input, in, ch, frame_len, out, FAAD_FMT_32BIT);
+#else
+        i = 0;
+#endif
+        if (in != NULL)
+        {
+            for(; i < frame_len; i++)
+            {
+                real_t inp = in[i];
+
+                inp *= 65536.0f;
+                CLIP(inp, 2147483647.0f, -2147483648.0f);
+
+                out[i] = (int32_t)lrintf(inp);
+            }
+        } else {
+            for(; i < frame_len; i++)
+            {
+                real_t inp = get_sample(input, ch, i, hDecoder->downMatrix, hDecoder->internal_channel);
+
+                inp *= 65536.0f;
+                CLIP(inp, 2147483647.0f, -2147483648.0f);
+
+                out[i] = (int32_t)lrintf(inp);
+            }
+        }
+    }
+}
+
+static void to_PCM_float_planar(NeAACDecStruct *hDecoder, real_t **input,
+                                uint8_t channels, uint16_t frame_len,
+                                float32_t *sample_buffer)
+{
+    uint8_t ch;
+    uint16_t i;
+
+    for (ch = 0; ch < channels; ch++)
+    {
+        real_t *in = planar_input(hDecoder, input, channels, ch);
+        float32_t *out = sample_buffer + ch*frame_len;
+
+#ifdef SIMD_V4
+        i = to_PCM_planar_simd(hDecoder, input, in, ch, frame_len, out, FAAD_FMT_FLOAT);
+#else
+        i = 0;
+#endif
+        if (in != NULL)
+        {
+            for(; i < frame_len; i++)
+            {
+                out[i] = in[i]*FLOAT_SCALE;
+            }
+        } else {
+            for(; i < frame_len; i++)
+            {
+                real_t inp = get_sample(input, ch, i, hDecoder->downMatrix, hDecoder->internal_channel);
+                out[i] = inp*FLOAT_SCALE;
+            }
+        }
+    }
+}
+
 void *output_to_PCM(NeAACDecStruct *hDecoder,
                     real_t **input, void *sample_buffer, uint8_t channels,
                     uint16_t frame_len, uint8_t format)
@@ -412,7 +817,10 @@ void *output_to_PCM(NeAACDecStruct *hDecoder,
     switch (format)
     {
     case FAAD_FMT_16BIT:
-        to_PCM_16bit(hDecoder, input, channels, frame_len, &short_sample_buffer);
+        to_PCM_16bit(hDecoder, input, channels, frame_len, 0, &short_sample_buffer);
+        break;
+    case FAAD_FMT_16BIT_DITHER:
+        to_PCM_16bit(hDecoder, input, channels, frame_len, 1, &short_sample_buffer);
         break;
     case FAAD_FMT_24BIT:
         to_PCM_24bit(hDecoder, input, channels, frame_len, &int_sample_buffer);
@@ -426,6 +834,15 @@ void *output_to_PCM(NeAACDecStruct *hDecoder,
     case FAAD_FMT_DOUBLE:
         to_PCM_double(hDecoder, input, channels, frame_len, &double_sample_buffer);
         break;
+    case FAAD_FMT_16BIT_PLANAR:
+        to_PCM_16bit_planar(hDecoder, input, channels, frame_len, short_sample_buffer);
+        break;
+    case FAAD_FMT_32BIT_PLANAR:
+        to_PCM_32bit_planar(hDecoder, input, channels, frame_len, int_sample_buffer);
+        break;
+    case FAAD_FMT_FLOAT_PLANAR:
+        to_PCM_float_planar(hDecoder, input, channels, frame_len, float_sample_buffer);
+        break;
     }
 
 #ifdef PROFILE
@@ -441,6 +858,15 @@ void *output_to_PCM(NeAACDecStruct *hDecoder,
 #define DM_MUL FRAC_CONST(0.3203772410170407) // 1/(1+sqrt(2) + 1/sqrt(2))
 #define RSQRT2 FRAC_CONST(0.7071067811865475244) // 1/sqrt(2)
 
+/* triangular dither in (-1, 1) LSB of the 16 bit output */
+static INLINE int32_t tpdf_dither(NeAACDecStruct *hDecoder)
+{
+    int32_t r1 = (int32_t)dither_rng(&hDecoder->dither_state[0]) >> (32-REAL_BITS);
+    int32_t r2 = (int32_t)dither_rng(&hDecoder->dither_state[0]) >> (32-REAL_BITS);
+
+    return r1 + r2;
+}
+
 static INLINE real_t get_sample(real_t **input, uint8_t channel, uint16_t sample,
                                 uint8_t down_matrix, uint8_t up_matrix,
                                 uint8_t *internal_channel)
@@ -471,12 +897,39 @@ void* output_to_PCM(NeAACDecStruct *hDecoder,
 {
     uint8_t ch;
     uint16_t i;
+    uint32_t pos, step;
+    uint8_t dither = 0;
     int16_t *short_sample_buffer = (int16_t*)sample_buffer;
     int32_t *int_sample_buffer = (int32_t*)sample_buffer;
 
+    /* planar formats only differ in the sample positions, the dithered
+       one only in the rounding */
+    step = channels;
+    switch (format)
+    {
+    case FAAD_FMT_16BIT_DITHER:
+        format = FAAD_FMT_16BIT;
+        dither = 1;
+        break;
+    case FAAD_FMT_16BIT_PLANAR:
+        format = FAAD_FMT_16BIT;
+        step = 1;
+        break;
+    case FAAD_FMT_32BIT_PLANAR:
+        format = FAAD_FMT_32BIT;
+        step = 1;
+        break;
+    case FAAD_FMT_FIXED_PLANAR:
+        format = FAAD_FMT_FIXED;
+        step = 1;
+        break;
+    }
+
     /* Copy output to a standard PCM buffer */
     for (ch = 0; ch < channels; ch++)
     {
+        pos = (step == 1) ? ch*frame_len : ch;
+
         switch (format)
         {
         case FAAD_FMT_16BIT:
@@ -484,6 +937,8 @@ void* output_to_PCM(NeAACDecStruct *hDecoder,
             {
                 int32_t tmp = get_sample(input, ch, i, hDecoder->downMatrix, hDecoder->upMatrix,
                     hDecoder->internal_channel);
+                if (dither)
+                    tmp += tpdf_dither(hDecoder);
                 if (tmp >= 0)
                 {
                     tmp += (1 << (REAL_BITS-1));
@@ -499,7 +954,7 @@ void* output_to_PCM(NeAACDecStruct *hDecoder,
                     }
                 }
                 tmp >>= REAL_BITS;
-                short_sample_buffer[(i*channels)+ch] = (int16_t)tmp;
+                short_sample_buffer[pos+i*step] = (int16_t)tmp;
             }
             break;
         case FAAD_FMT_24BIT:
@@ -523,7 +978,7 @@ void* output_to_PCM(NeAACDecStruct *hDecoder,
                         tmp = -8388608;
                     }
                 }
-                int_sample_buffer[(i*channels)+ch] = (int32_t)tmp;
+                int_sample_buffer[pos+i*step] = (int32_t)tmp;
             }
             break;
         case FAAD_FMT_32BIT:
@@ -539,7 +994,7 @@ void* output_to_PCM(NeAACDecStruct *hDecoder,
                     tmp += -(1 << (16-REAL_BITS-1));
                     tmp <<= (16-REAL_BITS);
                 }
-                int_sample_buffer[(i*channels)+ch] = (int32_t)tmp;
+                int_sample_buffer[pos+i*step] = (int32_t)tmp;
             }
             break;
         case FAAD_FMT_FIXED:
@@ -547,7 +1002,7 @@ void* output_to_PCM(NeAACDecStruct *hDecoder,
             {
                 real_t tmp = get_sample(input, ch, i, hDecoder->downMatrix, hDecoder->upMatrix,
                     hDecoder->internal_channel);
-                int_sample_buffer[(i*channels)+ch] = (int32_t)tmp;
+                int_sample_buffer[pos+i*step] = (int32_t)tmp;
             }
             break;
         }
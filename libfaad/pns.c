@@ -155,13 +155,15 @@ static INLINE void gen_rand_vector(real_t *spec, int16_t scale_factor, uint16_t
 #endif
 }
 
-void pns_decode(ic_stream *ics_left, ic_stream *ics_right,
-                real_t *spec_left, real_t *spec_right, uint16_t frame_len,
-                uint8_t channel_pair, uint8_t object_type,
-                /* RNG states */ uint32_t *__r1, uint32_t *__r2)
+/* returns the number of random values drawn from __r1/__r2 */
+uint16_t pns_decode(ic_stream *ics_left, ic_stream *ics_right,
+                    real_t *spec_left, real_t *spec_right, uint16_t frame_len,
+                    uint8_t channel_pair, uint8_t object_type,
+                    /* RNG states */ uint32_t *__r1, uint32_t *__r2)
 {
     uint8_t g, sfb, b;
     uint16_t size, offs;
+    uint16_t draws = 0;
 
     uint8_t group = 0;
     uint16_t nshort = frame_len >> 3;
@@ -218,6 +220,7 @@ void pns_decode(ic_stream *ics_left, ic_stream *ics_right,
                     /* Generate random vector */
                     gen_rand_vector(&spec_left[(group*nshort)+offs],
                         ics_left->scale_factors[g][sfb], size, sub, __r1, __r2);
+                    draws += size;
                 }
 
 /* From the spec:
@@ -268,10 +271,13 @@ void pns_decode(ic_stream *ics_left, ic_stream *ics_right,
                         /* Generate random vector */
                         gen_rand_vector(&spec_right[(group*nshort)+offs],
                             ics_right->scale_factors[g][sfb], size, sub, __r1, __r2);
+                        draws += size;
                     }
                 }
             } /* sfb */
             group++;
         } /* b */
     } /* g */
+
+    return draws;
 }
@@ -36,6 +36,7 @@
 #include <stdio.h>
 #include "ps_dec.h"
 #include "ps_tables.h"
+#include "simd.h"
 
 /* constants */
 #define NEGATE_IPD_MASK            (0x1000)
@@ -169,9 +170,9 @@ static void channel_filter2(hyb_info *hyb, uint8_t frame_len, const real_t *filt
 static void INLINE DCT3_4_unscaled(real_t *y, real_t *x);
 static void channel_filter8(hyb_info *hyb, uint8_t frame_len, const real_t *filter,
                             qmf_t *buffer, qmf_t **X_hybrid);
-static void hybrid_analysis(hyb_info *hyb, qmf_t X[32][64], qmf_t X_hybrid[32][32],
+static void hybrid_analysis(hyb_info *hyb, qmf_row_t X[32], qmf_t X_hybrid[32][32],
                             uint8_t use34, uint8_t numTimeSlotsRate);
-static void hybrid_synthesis(hyb_info *hyb, qmf_t X[32][64], qmf_t X_hybrid[32][32],
+static void hybrid_synthesis(hyb_info *hyb, qmf_row_t X[32], qmf_t X_hybrid[32][32],
                              uint8_t use34, uint8_t numTimeSlotsRate);
 static int8_t delta_clip(int8_t i, int8_t min, int8_t max);
 static void delta_decode(uint8_t enable, int8_t *index, int8_t *index_prev,
@@ -185,9 +186,9 @@ static void map20indexto34(int8_t *index, uint8_t bins);
 static void map34indexto20(int8_t *index, uint8_t bins);
 #endif
 static void ps_data_decode(ps_info *ps);
-static void ps_decorrelate(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][64],
+static void ps_decorrelate(ps_info *ps, qmf_row_t X_left[38], qmf_row_t X_right[38],
                            qmf_t X_hybrid_left[32][32], qmf_t X_hybrid_right[32][32]);
-static void ps_mix_phase(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][64],
+static void ps_mix_phase(ps_info *ps, qmf_row_t X_left[38], qmf_row_t X_right[38],
                          qmf_t X_hybrid_left[32][32], qmf_t X_hybrid_right[32][32]);
 
 /*  */
@@ -505,7 +506,7 @@ static void channel_filter12(hyb_info *hyb, uint8_t frame_len, const real_t *fil
 /* Hybrid analysis: further split up QMF subbands
  * to improve frequency resolution
  */
-static void hybrid_analysis(hyb_info *hyb, qmf_t X[32][64], qmf_t X_hybrid[32][32],
+static void hybrid_analysis(hyb_info *hyb, qmf_row_t X[32], qmf_t X_hybrid[32][32],
                             uint8_t use34, uint8_t numTimeSlotsRate)
 {
     uint8_t k, n, band;
@@ -521,8 +522,8 @@ static void hybrid_analysis(hyb_info *hyb, qmf_t X[32][64], qmf_t X_hybrid[32][3
         /* add new samples */
         for (n = 0; n < hyb->frame_len; n++)
         {
-            QMF_RE(hyb->work[12 + n]) = QMF_RE(X[n + 6 /*delay*/][band]);
-            QMF_IM(hyb->work[12 + n]) = QMF_IM(X[n + 6 /*delay*/][band]);
+            QMF_RE(hyb->work[12 + n]) = QMF_ROW_RE(X[n + 6 /*delay*/], band);
+            QMF_IM(hyb->work[12 + n]) = QMF_ROW_IM(X[n + 6 /*delay*/], band);
         }
 
         /* store samples */
@@ -579,7 +580,7 @@ static void hybrid_analysis(hyb_info *hyb, qmf_t X[32][64], qmf_t X_hybrid[32][3
     }
 }
 
-static void hybrid_synthesis(hyb_info *hyb, qmf_t X[32][64], qmf_t X_hybrid[32][32],
+static void hybrid_synthesis(hyb_info *hyb, qmf_row_t X[32], qmf_t X_hybrid[32][32],
                              uint8_t use34, uint8_t numTimeSlotsRate)
 {
     uint8_t k, n, band;
@@ -591,13 +592,13 @@ static void hybrid_synthesis(hyb_info *hyb, qmf_t X[32][64], qmf_t X_hybrid[32][
     {
         for (n = 0; n < hyb->frame_len; n++)
         {
-            QMF_RE(X[n][band]) = 0;
-            QMF_IM(X[n][band]) = 0;
+            QMF_ROW_RE(X[n], band) = 0;
+            QMF_ROW_IM(X[n], band) = 0;
 
             for (k = 0; k < resolution[band]; k++)
             {
-                QMF_RE(X[n][band]) += QMF_RE(X_hybrid[n][offset + k]);
-                QMF_IM(X[n][band]) += QMF_IM(X_hybrid[n][offset + k]);
+                QMF_ROW_RE(X[n], band) += QMF_RE(X_hybrid[n][offset + k]);
+                QMF_ROW_IM(X[n], band) += QMF_IM(X_hybrid[n][offset + k]);
             }
         }
         offset += resolution[band];
@@ -1030,13 +1031,140 @@ static void ps_data_decode(ps_info *ps)
 #endif
 }
 
+/* g_DecaySlope: [0..1] */
+static real_t decay_slope(ps_info *ps, uint8_t gr, uint8_t sb)
+{
+    if (gr < ps->num_hybrid_groups || sb <= ps->decay_cutoff)
+    {
+        return FRAC_CONST(1.0);
+    } else {
+        int8_t decay = ps->decay_cutoff - sb;
+        if (decay <= -20 /* -1/DECAY_SLOPE */)
+        {
+            return 0;
+        } else {
+            /* decay(int)*decay_slope(frac) = g_DecaySlope(frac) */
+            return FRAC_CONST(1.0) + DECAY_SLOPE * decay;
+        }
+    }
+}
+
+#ifdef QMF_SOA
+/* the allpass filtering of ps_decorrelate() for the QMF channels, four at
+   a time; the channels are independent and all start from the same delay
+   indices, so a vector may span several groups; returns the first channel
+   not done */
+static uint8_t ps_decorrelate_x4(ps_info *ps, qmf_row_t X_left[38], qmf_row_t X_right[38],
+                                 real_t G_TransientRatio[32][34],
+                                 uint8_t *temp_delay, uint8_t *temp_delay_ser)
+{
+    uint8_t sb_bk[64];
+    uint8_t gr, sb, n, m;
+
+    /* select the parameter index b(k) of every QMF channel */
+    for (gr = ps->num_hybrid_groups; gr < ps->num_groups; gr++)
+    {
+        for (sb = ps->group_border[gr]; sb < ps->group_border[gr + 1]; sb++)
+            sb_bk[sb] = (~NEGATE_IPD_MASK) & ps->map_group2bk[gr];
+    }
+
+    gr = ps->num_hybrid_groups;
+    for (sb = ps->group_border[gr]; sb + 3 <= ps->nr_allpass_bands; sb += 4)
+    {
+        v4sf g_filt[NO_ALLPASS_LINKS], q_re[NO_ALLPASS_LINKS], q_im[NO_ALLPASS_LINKS];
+        v4sf phi_re, phi_im, g;
+
+        g = v4_set(decay_slope(ps, gr, sb), decay_slope(ps, gr, sb + 1),
+            decay_slope(ps, gr, sb + 2), decay_slope(ps, gr, sb + 3));
+        phi_re = v4_even(v4_load(Phi_Fract_Qmf[sb]), v4_load(Phi_Fract_Qmf[sb + 2]));
+        phi_im = v4_odd(v4_load(Phi_Fract_Qmf[sb]), v4_load(Phi_Fract_Qmf[sb + 2]));
+        for (m = 0; m < NO_ALLPASS_LINKS; m++)
+        {
+            g_filt[m] = v4_mul(g, v4_set1(filter_a[m]));
+            q_re[m] = v4_set(RE(Q_Fract_allpass_Qmf[sb][m]), RE(Q_Fract_allpass_Qmf[sb + 1][m]),
+                RE(Q_Fract_allpass_Qmf[sb + 2][m]), RE(Q_Fract_allpass_Qmf[sb + 3][m]));
+            q_im[m] = v4_set(IM(Q_Fract_allpass_Qmf[sb][m]), IM(Q_Fract_allpass_Qmf[sb + 1][m]),
+                IM(Q_Fract_allpass_Qmf[sb + 2][m]), IM(Q_Fract_allpass_Qmf[sb + 3][m]));
+        }
+
+        /* set delay indices */
+        *temp_delay = ps->saved_delay;
+        for (m = 0; m < NO_ALLPASS_LINKS; m++)
+            temp_delay_ser[m] = ps->delay_buf_index_ser[m];
+
+        for (n = ps->border_position[0]; n < ps->border_position[ps->num_env]; n++)
+        {
+            real_t *d_re = &QMF_ROW_RE(ps->delay_Qmf[*temp_delay], sb);
+            real_t *d_im = &QMF_ROW_IM(ps->delay_Qmf[*temp_delay], sb);
+            v4sf in_re = v4_load(&QMF_ROW_RE(X_left[n], sb));
+            v4sf in_im = v4_load(&QMF_ROW_IM(X_left[n], sb));
+            v4sf tmp_re, tmp_im, r0_re, r0_im, t_re, t_im, G;
+
+            /* z^(-2) * Phi_Fract[k] */
+            t_re = v4_load(d_re);
+            t_im = v4_load(d_im);
+            v4_store(d_re, in_re);
+            v4_store(d_im, in_im);
+            r0_re = v4_add(v4_mul(t_re, phi_re), v4_mul(t_im, phi_im));
+            r0_im = v4_sub(v4_mul(t_im, phi_re), v4_mul(t_re, phi_im));
+
+            for (m = 0; m < NO_ALLPASS_LINKS; m++)
+            {
+                d_re = &QMF_ROW_RE(ps->delay_Qmf_ser[m][temp_delay_ser[m]], sb);
+                d_im = &QMF_ROW_IM(ps->delay_Qmf_ser[m][temp_delay_ser[m]], sb);
+
+                /* z^(-d(m)) * Q_Fract_allpass[k,m] */
+                t_re = v4_load(d_re);
+                t_im = v4_load(d_im);
+                tmp_re = v4_add(v4_mul(t_re, q_re[m]), v4_mul(t_im, q_im[m]));
+                tmp_im = v4_sub(v4_mul(t_im, q_re[m]), v4_mul(t_re, q_im[m]));
+
+                /* -a(m) * g_DecaySlope[k] */
+                tmp_re = v4_sub(tmp_re, v4_mul(g_filt[m], r0_re));
+                tmp_im = v4_sub(tmp_im, v4_mul(g_filt[m], r0_im));
+
+                v4_store(d_re, v4_add(r0_re, v4_mul(g_filt[m], tmp_re)));
+                v4_store(d_im, v4_add(r0_im, v4_mul(g_filt[m], tmp_im)));
+
+                r0_re = tmp_re;
+                r0_im = tmp_im;
+            }
+
+            /* duck if a past transient is found */
+            G = v4_set(G_TransientRatio[n][sb_bk[sb]], G_TransientRatio[n][sb_bk[sb + 1]],
+                G_TransientRatio[n][sb_bk[sb + 2]], G_TransientRatio[n][sb_bk[sb + 3]]);
+            v4_store(&QMF_ROW_RE(X_right[n], sb), v4_mul(G, r0_re));
+            v4_store(&QMF_ROW_IM(X_right[n], sb), v4_mul(G, r0_im));
+
+            /* Update delay buffer indices */
+            if (++(*temp_delay) >= 2)
+            {
+                *temp_delay = 0;
+            }
+            for (m = 0; m < NO_ALLPASS_LINKS; m++)
+            {
+                if (++temp_delay_ser[m] >= ps->num_sample_delay_ser[m])
+                {
+                    temp_delay_ser[m] = 0;
+                }
+            }
+        }
+    }
+
+    return sb;
+}
+#endif
+
 /* decorrelate the mono signal using an allpass filter */
-static void ps_decorrelate(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][64],
+static void ps_decorrelate(ps_info *ps, qmf_row_t X_left[38], qmf_row_t X_right[38],
                            qmf_t X_hybrid_left[32][32], qmf_t X_hybrid_right[32][32])
 {
     uint8_t gr, n, m, bk;
     uint8_t temp_delay;
     uint8_t sb, maxsb;
+#ifdef QMF_SOA
+    uint8_t sb_done;
+#endif
     const complex_t *Phi_Fract_SubQmf;
     uint8_t temp_delay_ser[NO_ALLPASS_LINKS];
     real_t P_SmoothPeakDecayDiffNrg, nrg;
@@ -1085,8 +1213,8 @@ static void ps_decorrelate(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][
                     RE(inputLeft) = QMF_RE(X_hybrid_left[n][sb]);
                     IM(inputLeft) = QMF_IM(X_hybrid_left[n][sb]);
                 } else {
-                    RE(inputLeft) = QMF_RE(X_left[n][sb]);
-                    IM(inputLeft) = QMF_IM(X_left[n][sb]);
+                    RE(inputLeft) = QMF_ROW_RE(X_left[n], sb);
+                    IM(inputLeft) = QMF_ROW_IM(X_left[n], sb);
                 }
 
                 /* accumulate energy */
@@ -1163,6 +1291,11 @@ static void ps_decorrelate(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][
     }
 #endif
 
+#ifdef QMF_SOA
+    sb_done = ps_decorrelate_x4(ps, X_left, X_right, G_TransientRatio,
+        &temp_delay, temp_delay_ser);
+#endif
+
     /* apply stereo decorrelation filter to the signal */
     for (gr = 0; gr < ps->num_groups; gr++)
     {
@@ -1171,26 +1304,22 @@ static void ps_decorrelate(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][
         else
             maxsb = ps->group_border[gr + 1];
 
+        sb = ps->group_border[gr];
+#ifdef QMF_SOA
+        /* skip the QMF channels done by ps_decorrelate_x4() */
+        if (gr >= ps->num_hybrid_groups && sb < sb_done)
+        {
+            sb = min(sb_done, maxsb);
+        }
+#endif
+
         /* QMF channel */
-        for (sb = ps->group_border[gr]; sb < maxsb; sb++)
+        for (; sb < maxsb; sb++)
         {
             real_t g_DecaySlope;
             real_t g_DecaySlope_filt[NO_ALLPASS_LINKS];
 
-            /* g_DecaySlope: [0..1] */
-            if (gr < ps->num_hybrid_groups || sb <= ps->decay_cutoff)
-            {
-                g_DecaySlope = FRAC_CONST(1.0);
-            } else {
-                int8_t decay = ps->decay_cutoff - sb;
-                if (decay <= -20 /* -1/DECAY_SLOPE */)
-                {
-                    g_DecaySlope = 0;
-                } else {
-                    /* decay(int)*decay_slope(frac) = g_DecaySlope(frac) */
-                    g_DecaySlope = FRAC_CONST(1.0) + DECAY_SLOPE * decay;
-                }
-            }
+            g_DecaySlope = decay_slope(ps, gr, sb);
 
             /* calculate g_DecaySlope_filt for every m multiplied by filter_a[m] */
             for (m = 0; m < NO_ALLPASS_LINKS; m++)
@@ -1215,8 +1344,8 @@ static void ps_decorrelate(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][
                     IM(inputLeft) = QMF_IM(X_hybrid_left[n][sb]);
                 } else {
                     /* QMF filterbank input */
-                    RE(inputLeft) = QMF_RE(X_left[n][sb]);
-                    IM(inputLeft) = QMF_IM(X_left[n][sb]);
+                    RE(inputLeft) = QMF_ROW_RE(X_left[n], sb);
+                    IM(inputLeft) = QMF_ROW_IM(X_left[n], sb);
                 }
 
                 if (sb > ps->nr_allpass_bands && gr >= ps->num_hybrid_groups)
@@ -1224,12 +1353,12 @@ static void ps_decorrelate(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][
                     /* delay */
 
                     /* never hybrid subbands here, always QMF subbands */
-                    RE(tmp) = RE(ps->delay_Qmf[ps->delay_buf_index_delay[sb]][sb]);
-                    IM(tmp) = IM(ps->delay_Qmf[ps->delay_buf_index_delay[sb]][sb]);
+                    RE(tmp) = QMF_ROW_RE(ps->delay_Qmf[ps->delay_buf_index_delay[sb]], sb);
+                    IM(tmp) = QMF_ROW_IM(ps->delay_Qmf[ps->delay_buf_index_delay[sb]], sb);
                     RE(R0) = RE(tmp);
                     IM(R0) = IM(tmp);
-                    RE(ps->delay_Qmf[ps->delay_buf_index_delay[sb]][sb]) = RE(inputLeft);
-                    IM(ps->delay_Qmf[ps->delay_buf_index_delay[sb]][sb]) = IM(inputLeft);
+                    QMF_ROW_RE(ps->delay_Qmf[ps->delay_buf_index_delay[sb]], sb) = RE(inputLeft);
+                    QMF_ROW_IM(ps->delay_Qmf[ps->delay_buf_index_delay[sb]], sb) = IM(inputLeft);
                 } else {
                     /* allpass filter */
                     uint8_t m;
@@ -1249,11 +1378,11 @@ static void ps_decorrelate(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][
                         IM(Phi_Fract) = IM(Phi_Fract_SubQmf[sb]);
                     } else {
                         /* select data from the QMF subbands */
-                        RE(tmp0) = RE(ps->delay_Qmf[temp_delay][sb]);
-                        IM(tmp0) = IM(ps->delay_Qmf[temp_delay][sb]);
+                        RE(tmp0) = QMF_ROW_RE(ps->delay_Qmf[temp_delay], sb);
+                        IM(tmp0) = QMF_ROW_IM(ps->delay_Qmf[temp_delay], sb);
 
-                        RE(ps->delay_Qmf[temp_delay][sb]) = RE(inputLeft);
-                        IM(ps->delay_Qmf[temp_delay][sb]) = IM(inputLeft);
+                        QMF_ROW_RE(ps->delay_Qmf[temp_delay], sb) = RE(inputLeft);
+                        QMF_ROW_IM(ps->delay_Qmf[temp_delay], sb) = IM(inputLeft);
 
                         RE(Phi_Fract) = RE(Phi_Fract_Qmf[sb]);
                         IM(Phi_Fract) = IM(Phi_Fract_Qmf[sb]);
@@ -1285,8 +1414,8 @@ static void ps_decorrelate(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][
                             }
                         } else {
                             /* select data from the QMF subbands */
-                            RE(tmp0) = RE(ps->delay_Qmf_ser[m][temp_delay_ser[m]][sb]);
-                            IM(tmp0) = IM(ps->delay_Qmf_ser[m][temp_delay_ser[m]][sb]);
+                            RE(tmp0) = QMF_ROW_RE(ps->delay_Qmf_ser[m][temp_delay_ser[m]], sb);
+                            IM(tmp0) = QMF_ROW_IM(ps->delay_Qmf_ser[m][temp_delay_ser[m]], sb);
 
                             RE(Q_Fract_allpass) = RE(Q_Fract_allpass_Qmf[sb][m]);
                             IM(Q_Fract_allpass) = IM(Q_Fract_allpass_Qmf[sb][m]);
@@ -1310,8 +1439,8 @@ static void ps_decorrelate(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][
                             RE(ps->delay_SubQmf_ser[m][temp_delay_ser[m]][sb]) = RE(tmp2);
                             IM(ps->delay_SubQmf_ser[m][temp_delay_ser[m]][sb]) = IM(tmp2);
                         } else {
-                            RE(ps->delay_Qmf_ser[m][temp_delay_ser[m]][sb]) = RE(tmp2);
-                            IM(ps->delay_Qmf_ser[m][temp_delay_ser[m]][sb]) = IM(tmp2);
+                            QMF_ROW_RE(ps->delay_Qmf_ser[m][temp_delay_ser[m]], sb) = RE(tmp2);
+                            QMF_ROW_IM(ps->delay_Qmf_ser[m][temp_delay_ser[m]], sb) = IM(tmp2);
                         }
 
                         /* store for next iteration (or as output value if last iteration) */
@@ -1334,8 +1463,8 @@ static void ps_decorrelate(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][
                     QMF_IM(X_hybrid_right[n][sb]) = IM(R0);
                 } else {
                     /* QMF */
-                    QMF_RE(X_right[n][sb]) = RE(R0);
-                    QMF_IM(X_right[n][sb]) = IM(R0);
+                    QMF_ROW_RE(X_right[n], sb) = RE(R0);
+                    QMF_ROW_IM(X_right[n], sb) = IM(R0);
                 }
 
                 /* Update delay buffer index */
@@ -1446,7 +1575,54 @@ static real_t magnitude_c(complex_t c)
 #endif
 }
 
-static void ps_mix_phase(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][64],
+#ifdef QMF_SOA
+/* the mixing of ps_mix_phase() for QMF slot n, four channels at a time;
+   returns the first channel not done */
+static uint8_t ps_mix_phase_x4(qmf_row_t X_left, qmf_row_t X_right,
+                               uint8_t sb, uint8_t maxsb, uint8_t rotate,
+                               const complex_t H11, const complex_t H12,
+                               const complex_t H21, const complex_t H22)
+{
+    /* the imaginary parts are only set when rotating */
+    const v4sf h11_re = v4_set1(RE(H11)), h11_im = v4_set1(rotate ? IM(H11) : 0);
+    const v4sf h12_re = v4_set1(RE(H12)), h12_im = v4_set1(rotate ? IM(H12) : 0);
+    const v4sf h21_re = v4_set1(RE(H21)), h21_im = v4_set1(rotate ? IM(H21) : 0);
+    const v4sf h22_re = v4_set1(RE(H22)), h22_im = v4_set1(rotate ? IM(H22) : 0);
+
+    for (; sb + 4 <= maxsb; sb += 4)
+    {
+        v4sf l_re = v4_load(&QMF_ROW_RE(X_left, sb));
+        v4sf l_im = v4_load(&QMF_ROW_IM(X_left, sb));
+        v4sf r_re = v4_load(&QMF_ROW_RE(X_right, sb));
+        v4sf r_im = v4_load(&QMF_ROW_IM(X_right, sb));
+        v4sf tl_re, tl_im, tr_re, tr_im;
+
+        /* apply mixing */
+        tl_re = v4_add(v4_mul(h11_re, l_re), v4_mul(h21_re, r_re));
+        tl_im = v4_add(v4_mul(h11_re, l_im), v4_mul(h21_re, r_im));
+        tr_re = v4_add(v4_mul(h12_re, l_re), v4_mul(h22_re, r_re));
+        tr_im = v4_add(v4_mul(h12_re, l_im), v4_mul(h22_re, r_im));
+
+        if (rotate)
+        {
+            /* apply rotation */
+            tl_re = v4_sub(tl_re, v4_add(v4_mul(h11_im, l_im), v4_mul(h21_im, r_im)));
+            tl_im = v4_add(tl_im, v4_add(v4_mul(h11_im, l_re), v4_mul(h21_im, r_re)));
+            tr_re = v4_sub(tr_re, v4_add(v4_mul(h12_im, l_im), v4_mul(h22_im, r_im)));
+            tr_im = v4_add(tr_im, v4_add(v4_mul(h12_im, l_re), v4_mul(h22_im, r_re)));
+        }
+
+        v4_store(&QMF_ROW_RE(X_left, sb), tl_re);
+        v4_store(&QMF_ROW_IM(X_left, sb), tl_im);
+        v4_store(&QMF_ROW_RE(X_right, sb), tr_re);
+        v4_store(&QMF_ROW_IM(X_right, sb), tr_im);
+    }
+
+    return sb;
+}
+#endif
+
+static void ps_mix_phase(ps_info *ps, qmf_row_t X_left[38], qmf_row_t X_right[38],
                          qmf_t X_hybrid_left[32][32], qmf_t X_hybrid_right[32][32])
 {
     uint8_t n;
@@ -1457,7 +1633,7 @@ static void ps_mix_phase(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][64
     uint8_t nr_ipdopd_par;
     complex_t h11, h12, h21, h22;
     complex_t H11, H12, H21, H22;
-    complex_t deltaH11, deltaH12, deltaH21, deltaH22;
+    complex_t deltaH11 = {0}, deltaH12 = {0}, deltaH21 = {0}, deltaH22 = {0};
     complex_t tempLeft;
     complex_t tempRight;
     complex_t phaseLeft;
@@ -1812,8 +1988,17 @@ static void ps_mix_phase(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][64
                     IM(H22) += IM(deltaH22);
                 }
 
+                sb = ps->group_border[gr];
+#ifdef QMF_SOA
+                if (gr >= ps->num_hybrid_groups)
+                {
+                    sb = ps_mix_phase_x4(X_left[n], X_right[n], sb, maxsb,
+                        (ps->enable_ipdopd) && (bk < nr_ipdopd_par), H11, H12, H21, H22);
+                }
+#endif
+
                 /* channel is an alias to the subband */
-                for (sb = ps->group_border[gr]; sb < maxsb; sb++)
+                for (; sb < maxsb; sb++)
                 {
                     complex_t inLeft, inRight;
 
@@ -1825,10 +2010,10 @@ static void ps_mix_phase(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][64
                         RE(inRight) = RE(X_hybrid_right[n][sb]);
                         IM(inRight) = IM(X_hybrid_right[n][sb]);
                     } else {
-                        RE(inLeft) =  RE(X_left[n][sb]);
-                        IM(inLeft) =  IM(X_left[n][sb]);
-                        RE(inRight) = RE(X_right[n][sb]);
-                        IM(inRight) = IM(X_right[n][sb]);
+                        RE(inLeft) =  QMF_ROW_RE(X_left[n], sb);
+                        IM(inLeft) =  QMF_ROW_IM(X_left[n], sb);
+                        RE(inRight) = QMF_ROW_RE(X_right[n], sb);
+                        IM(inRight) = QMF_ROW_IM(X_right[n], sb);
                     }
 
                     /* apply mixing */
@@ -1855,10 +2040,10 @@ static void ps_mix_phase(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][64
                         RE(X_hybrid_right[n][sb]) = RE(tempRight);
                         IM(X_hybrid_right[n][sb]) = IM(tempRight);
                     } else {
-                        RE(X_left[n][sb])  = RE(tempLeft);
-                        IM(X_left[n][sb])  = IM(tempLeft);
-                        RE(X_right[n][sb]) = RE(tempRight);
-                        IM(X_right[n][sb]) = IM(tempRight);
+                        QMF_ROW_RE(X_left[n], sb)  = RE(tempLeft);
+                        QMF_ROW_IM(X_left[n], sb)  = IM(tempLeft);
+                        QMF_ROW_RE(X_right[n], sb) = RE(tempRight);
+                        QMF_ROW_IM(X_right[n], sb) = IM(tempRight);
                     }
                 }
             }
@@ -1976,7 +2161,7 @@ ps_info *ps_init(uint8_t sr_index, uint8_t numTimeSlotsRate)
 }
 
 /* main Parametric Stereo decoding function */
-uint8_t ps_decode(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][64])
+uint8_t ps_decode(ps_info *ps, qmf_row_t X_left[38], qmf_row_t X_right[38])
 {
     qmf_t X_hybrid_left[32][32] = {{0}};
     qmf_t X_hybrid_right[32][32] = {{0}};
@@ -111,9 +111,11 @@ typedef struct
     uint8_t delay_D[64];
     uint8_t delay_buf_index_delay[64];
 
-    complex_t delay_Qmf[14][64]; /* 14 samples delay max, 64 QMF channels */
+    /* QMF delay lines have the layout of the QMF matrix rows, so four
+       neighbouring channels can be filtered at once */
+    qmf_row_t delay_Qmf[14]; /* 14 samples delay max, 64 QMF channels */
     complex_t delay_SubQmf[2][32]; /* 2 samples delay max (SubQmf is always allpass filtered) */
-    complex_t delay_Qmf_ser[NO_ALLPASS_LINKS][5][64]; /* 5 samples delay max (table 8.34), 64 QMF channels */
+    qmf_row_t delay_Qmf_ser[NO_ALLPASS_LINKS][5]; /* 5 samples delay max (table 8.34), 64 QMF channels */
     complex_t delay_SubQmf_ser[NO_ALLPASS_LINKS][5][32]; /* 5 samples delay max (table 8.34) */
 
     /* transients */
@@ -142,7 +144,7 @@ uint16_t ps_data(ps_info *ps, bitfile *ld, uint8_t *header);
 ps_info *ps_init(uint8_t sr_index, uint8_t numTimeSlotsRate);
 void ps_free(ps_info *ps);
 
-uint8_t ps_decode(ps_info *ps, qmf_t X_left[38][64], qmf_t X_right[38][64]);
+uint8_t ps_decode(ps_info *ps, qmf_row_t X_left[38], qmf_row_t X_right[38]);
 
 
 #ifdef __cplusplus
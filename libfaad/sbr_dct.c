@@ -44,6 +44,7 @@
 
 
 #include "sbr_dct.h"
+#include "simd.h"
 
 void DCT4_32(real_t *y, real_t *x)
 {
@@ -1892,6 +1893,7 @@ static const real_t w_array_imag[] = {
     FRAC_CONST(-0.382683361692986), FRAC_CONST(-0.195090241632088)
 };
 
+#ifndef SIMD_V4
 // FFT decimation in frequency
 // 4*16*2+16=128+16=144 multiplications
 // 6*16*2+10*8+4*16*2=192+80+128=400 additions
@@ -2119,6 +2121,7 @@ static void fft_dif(real_t * Real, real_t * Imag)
     FFTReorder(Real, Imag);
 #endif // #ifdef REORDER_IN_FFT
 }
+#endif
 #undef n
 #undef log2n
 
@@ -2221,6 +2224,7 @@ static const real_t dct4_64_tab[] = {
     COEF_CONST(0.897167563438416), COEF_CONST(0.949727773666382)
 };
 
+#ifndef SIMD_V4
 /* size 64 only! */
 void dct4_kernel(real_t * in_real, real_t * in_imag, real_t * out_real, real_t * out_imag)
 {
@@ -2274,6 +2278,146 @@ void dct4_kernel(real_t * in_real, real_t * in_imag, real_t * out_real, real_t *
 
 }
 
+#else
+
+/* butterflies of dct4_kernel(), for four points at a time */
+static INLINE void bfly_x4(v4sf *r1, v4sf *i1, v4sf *r2, v4sf *i2)
+{
+    v4sf p1_real = *r1, p1_imag = *i1;
+
+    *r1 = v4_add(p1_real, *r2);
+    *i1 = v4_add(p1_imag, *i2);
+    *r2 = v4_sub(p1_real, *r2);
+    *i2 = v4_sub(p1_imag, *i2);
+}
+
+/* x[i2] = (x[i] - x[i2]) * (-i) */
+static INLINE void bfly_j_x4(v4sf *r1, v4sf *i1, v4sf *r2, v4sf *i2)
+{
+    v4sf p1_real = *r1, p1_imag = *i1;
+    v4sf p2_real = *r2, p2_imag = *i2;
+
+    *r1 = v4_add(p1_real, p2_real);
+    *i1 = v4_add(p1_imag, p2_imag);
+    *r2 = v4_sub(p1_imag, p2_imag);
+    *i2 = v4_sub(p2_real, p1_real);
+}
+
+static INLINE void bfly_w_x4(v4sf *r1, v4sf *i1, v4sf *r2, v4sf *i2,
+                             v4sf w_real, v4sf w_imag)
+{
+    v4sf p1_real = v4_sub(*r1, *r2);
+    v4sf p1_imag = v4_sub(*i1, *i2);
+
+    *r1 = v4_add(*r1, *r2);
+    *i1 = v4_add(*i1, *i2);
+    *r2 = v4_sub(v4_mul(p1_real, w_real), v4_mul(p1_imag, w_imag));
+    *i2 = v4_add(v4_mul(p1_real, w_imag), v4_mul(p1_imag, w_real));
+}
+
+/* size 64 only! Same operations as the C version: the first two FFT
+   stages work on 4 consecutive points, then a transpose puts point e of
+   each group of 8 in vector e, so the last three stages are the same
+   for all lanes */
+void dct4_kernel(real_t * in_real, real_t * in_imag, real_t * out_real, real_t * out_imag)
+{
+    /* bit reverse of 0..7, vector holding out[4*m..4*m+3] */
+    static const uint8_t bit_rev_tab[8] = { 0,4,2,6,1,5,3,7 };
+    v4sf re[8], im[8], tr[8], ti[8];
+    v4sf w_real, w_imag, c;
+    uint32_t i;
+
+    /* Step 2: modulate */
+    for (i = 0; i < 8; i++)
+    {
+        v4sf x_re = v4_load(&in_real[4*i]);
+        v4sf x_im = v4_load(&in_imag[4*i]);
+        v4sf tmp = v4_mul(v4_add(x_re, x_im), v4_load(&dct4_64_tab[4*i]));
+
+        re[i] = v4_add(v4_mul(x_im, v4_load(&dct4_64_tab[4*i + 64])), tmp);
+        im[i] = v4_add(v4_mul(x_re, v4_load(&dct4_64_tab[4*i + 32])), tmp);
+    }
+
+    /* Step 3: FFT, but with output in bit reverse order */
+    /* stage 1: x[i], x[i+16] */
+    for (i = 0; i < 4; i++)
+    {
+        bfly_w_x4(&re[i], &im[i], &re[i+4], &im[i+4],
+            v4_load(&w_array_real[4*i]), v4_load(&w_array_imag[4*i]));
+    }
+
+    /* stage 2: x[i], x[i+8], twiddles w[2*j] */
+    for (i = 0; i < 2; i++)
+    {
+        w_real = v4_even(v4_load(&w_array_real[8*i]), v4_load(&w_array_real[8*i+4]));
+        w_imag = v4_even(v4_load(&w_array_imag[8*i]), v4_load(&w_array_imag[8*i+4]));
+
+        bfly_w_x4(&re[i],   &im[i],   &re[i+2], &im[i+2], w_real, w_imag);
+        bfly_w_x4(&re[i+4], &im[i+4], &re[i+6], &im[i+6], w_real, w_imag);
+    }
+
+    /* tr[e], ti[e] = points e, e+8, e+16, e+24 */
+    v4_transpose(re[0], re[2], re[4], re[6]);
+    v4_transpose(re[1], re[3], re[5], re[7]);
+    v4_transpose(im[0], im[2], im[4], im[6]);
+    v4_transpose(im[1], im[3], im[5], im[7]);
+    for (i = 0; i < 4; i++)
+    {
+        tr[i] = re[2*i];   ti[i] = im[2*i];
+        tr[i+4] = re[2*i+1]; ti[i+4] = im[2*i+1];
+    }
+
+    /* stage 3 */
+    bfly_x4(&tr[0], &ti[0], &tr[4], &ti[4]);
+    {
+        v4sf p1_real = v4_sub(tr[1], tr[5]);
+        v4sf p1_imag = v4_sub(ti[1], ti[5]);
+
+        c = v4_set1(w_array_real[4]);
+        tr[1] = v4_add(tr[1], tr[5]);
+        ti[1] = v4_add(ti[1], ti[5]);
+        tr[5] = v4_mul(v4_add(p1_real, p1_imag), c);
+        ti[5] = v4_mul(v4_sub(p1_imag, p1_real), c);
+    }
+    bfly_j_x4(&tr[2], &ti[2], &tr[6], &ti[6]);
+    {
+        v4sf p1_real = v4_sub(tr[3], tr[7]);
+        v4sf p1_imag = v4_sub(ti[3], ti[7]);
+
+        c = v4_set1(w_array_real[12]);
+        tr[3] = v4_add(tr[3], tr[7]);
+        ti[3] = v4_add(ti[3], ti[7]);
+        tr[7] = v4_mul(v4_sub(p1_real, p1_imag), c);
+        ti[7] = v4_mul(v4_add(p1_real, p1_imag), c);
+    }
+
+    /* stage 4 */
+    bfly_x4(&tr[0], &ti[0], &tr[2], &ti[2]);
+    bfly_x4(&tr[4], &ti[4], &tr[6], &ti[6]);
+    bfly_j_x4(&tr[1], &ti[1], &tr[3], &ti[3]);
+    bfly_j_x4(&tr[5], &ti[5], &tr[7], &ti[7]);
+
+    /* stage 5 */
+    for (i = 0; i < 8; i += 2)
+        bfly_x4(&tr[i], &ti[i], &tr[i+1], &ti[i+1]);
+
+    /* Step 4: modulate + bitreverse reordering */
+    for (i = 0; i < 8; i++)
+    {
+        v4sf x_re = v4_swap_mid(tr[bit_rev_tab[i]]);
+        v4sf x_im = v4_swap_mid(ti[bit_rev_tab[i]]);
+        v4sf tmp = v4_mul(v4_add(x_re, x_im), v4_load(&dct4_64_tab[4*i + 3*32]));
+
+        v4_store(&out_real[4*i], v4_add(v4_mul(x_im, v4_load(&dct4_64_tab[4*i + 5*32])), tmp));
+        v4_store(&out_imag[4*i], v4_add(v4_mul(x_re, v4_load(&dct4_64_tab[4*i + 4*32])), tmp));
+    }
+    // i = 16, i_rev = 1 = rev(16);
+    out_imag[16] = MUL_C(v4_first(ti[1]) - v4_first(tr[1]), dct4_64_tab[16 + 3*32]);
+    out_real[16] = MUL_C(v4_first(tr[1]) + v4_first(ti[1]), dct4_64_tab[16 + 3*32]);
+}
+
+#endif
+
 #endif
 
 #endif
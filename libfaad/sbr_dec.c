@@ -129,8 +129,8 @@ sbr_info *sbrDecodeInit(uint16_t framelength, uint8_t id_aac,
             sbr->Q_temp_prev[1][j] = faad_malloc(64*sizeof(real_t));
         }
 
-        memset(sbr->Xsbr[0], 0, (sbr->numTimeSlotsRate+sbr->tHFGen)*64 * sizeof(qmf_t));
-        memset(sbr->Xsbr[1], 0, (sbr->numTimeSlotsRate+sbr->tHFGen)*64 * sizeof(qmf_t));
+        memset(sbr->Xsbr[0], 0, (sbr->numTimeSlotsRate+sbr->tHFGen) * sizeof(qmf_row_t));
+        memset(sbr->Xsbr[1], 0, (sbr->numTimeSlotsRate+sbr->tHFGen) * sizeof(qmf_row_t));
     } else {
         /* mono */
         uint8_t j;
@@ -144,7 +144,7 @@ sbr_info *sbrDecodeInit(uint16_t framelength, uint8_t id_aac,
             sbr->Q_temp_prev[0][j] = faad_malloc(64*sizeof(real_t));
         }
 
-        memset(sbr->Xsbr[0], 0, (sbr->numTimeSlotsRate+sbr->tHFGen)*64 * sizeof(qmf_t));
+        memset(sbr->Xsbr[0], 0, (sbr->numTimeSlotsRate+sbr->tHFGen) * sizeof(qmf_row_t));
     }
 
     return sbr;
@@ -210,8 +210,8 @@ void sbrReset(sbr_info *sbr)
             memset(sbr->Q_temp_prev[1][j], 0, 64*sizeof(real_t));
     }
 
-    memset(sbr->Xsbr[0], 0, (sbr->numTimeSlotsRate+sbr->tHFGen)*64 * sizeof(qmf_t));
-    memset(sbr->Xsbr[1], 0, (sbr->numTimeSlotsRate+sbr->tHFGen)*64 * sizeof(qmf_t));
+    memset(sbr->Xsbr[0], 0, (sbr->numTimeSlotsRate+sbr->tHFGen) * sizeof(qmf_row_t));
+    memset(sbr->Xsbr[1], 0, (sbr->numTimeSlotsRate+sbr->tHFGen) * sizeof(qmf_row_t));
 
     sbr->GQ_ringbuf_index[0] = 0;
     sbr->GQ_ringbuf_index[1] = 0;
@@ -294,15 +294,15 @@ static void sbr_save_matrix(sbr_info *sbr, uint8_t ch)
 
     for (i = 0; i < sbr->tHFGen; i++)
     {
-        memmove(sbr->Xsbr[ch][i], sbr->Xsbr[ch][i+sbr->numTimeSlotsRate], 64 * sizeof(qmf_t));
+        memmove(sbr->Xsbr[ch][i], sbr->Xsbr[ch][i+sbr->numTimeSlotsRate], sizeof(qmf_row_t));
     }
     for (i = sbr->tHFGen; i < MAX_NTSRHFG; i++)
     {
-        memset(sbr->Xsbr[ch][i], 0, 64 * sizeof(qmf_t));
+        memset(sbr->Xsbr[ch][i], 0, sizeof(qmf_row_t));
     }
 }
 
-static uint8_t sbr_process_channel(sbr_info *sbr, real_t *channel_buf, qmf_t X[MAX_NTSR][64],
+static uint8_t sbr_process_channel(sbr_info *sbr, real_t *channel_buf, qmf_row_t X[MAX_NTSR],
                                    uint8_t ch, uint8_t dont_process,
                                    const uint8_t downSampledSBR)
 {
@@ -360,7 +360,7 @@ static uint8_t sbr_process_channel(sbr_info *sbr, real_t *channel_buf, qmf_t X[M
         {
             for (k = 0; k < sbr->kx; k++)
             {
-                QMF_RE(sbr->Xsbr[ch][sbr->tHFAdj + l][k]) = 0;
+                QMF_ROW_RE(sbr->Xsbr[ch][sbr->tHFAdj + l], k) = 0;
             }
         }
 #endif
@@ -385,16 +385,16 @@ static uint8_t sbr_process_channel(sbr_info *sbr, real_t *channel_buf, qmf_t X[M
         {
             for (k = 0; k < 32; k++)
             {
-                QMF_RE(X[l][k]) = QMF_RE(sbr->Xsbr[ch][l + sbr->tHFAdj][k]);
+                QMF_ROW_RE(X[l], k) = QMF_ROW_RE(sbr->Xsbr[ch][l + sbr->tHFAdj], k);
 #ifndef SBR_LOW_POWER
-                QMF_IM(X[l][k]) = QMF_IM(sbr->Xsbr[ch][l + sbr->tHFAdj][k]);
+                QMF_ROW_IM(X[l], k) = QMF_ROW_IM(sbr->Xsbr[ch][l + sbr->tHFAdj], k);
 #endif
             }
             for (k = 32; k < 64; k++)
             {
-                QMF_RE(X[l][k]) = 0;
+                QMF_ROW_RE(X[l], k) = 0;
 #ifndef SBR_LOW_POWER
-                QMF_IM(X[l][k]) = 0;
+                QMF_ROW_IM(X[l], k) = 0;
 #endif
             }
         }
@@ -417,34 +417,34 @@ static uint8_t sbr_process_channel(sbr_info *sbr, real_t *channel_buf, qmf_t X[M
 #ifndef SBR_LOW_POWER
             for (k = 0; k < kx_band + bsco_band; k++)
             {
-                QMF_RE(X[l][k]) = QMF_RE(sbr->Xsbr[ch][l + sbr->tHFAdj][k]);
-                QMF_IM(X[l][k]) = QMF_IM(sbr->Xsbr[ch][l + sbr->tHFAdj][k]);
+                QMF_ROW_RE(X[l], k) = QMF_ROW_RE(sbr->Xsbr[ch][l + sbr->tHFAdj], k);
+                QMF_ROW_IM(X[l], k) = QMF_ROW_IM(sbr->Xsbr[ch][l + sbr->tHFAdj], k);
             }
             for (k = kx_band + bsco_band; k < kx_band + M_band; k++)
             {
-                QMF_RE(X[l][k]) = QMF_RE(sbr->Xsbr[ch][l + sbr->tHFAdj][k]);
-                QMF_IM(X[l][k]) = QMF_IM(sbr->Xsbr[ch][l + sbr->tHFAdj][k]);
+                QMF_ROW_RE(X[l], k) = QMF_ROW_RE(sbr->Xsbr[ch][l + sbr->tHFAdj], k);
+                QMF_ROW_IM(X[l], k) = QMF_ROW_IM(sbr->Xsbr[ch][l + sbr->tHFAdj], k);
             }
             for (k = max(kx_band + bsco_band, kx_band + M_band); k < 64; k++)
             {
-                QMF_RE(X[l][k]) = 0;
-                QMF_IM(X[l][k]) = 0;
+                QMF_ROW_RE(X[l], k) = 0;
+                QMF_ROW_IM(X[l], k) = 0;
             }
 #else
             for (k = 0; k < kx_band + bsco_band; k++)
             {
-                QMF_RE(X[l][k]) = QMF_RE(sbr->Xsbr[ch][l + sbr->tHFAdj][k]);
+                QMF_ROW_RE(X[l], k) = QMF_ROW_RE(sbr->Xsbr[ch][l + sbr->tHFAdj], k);
             }
             for (k = kx_band + bsco_band; k < min(kx_band + M_band, 63); k++)
             {
-                QMF_RE(X[l][k]) = QMF_RE(sbr->Xsbr[ch][l + sbr->tHFAdj][k]);
+                QMF_ROW_RE(X[l], k) = QMF_ROW_RE(sbr->Xsbr[ch][l + sbr->tHFAdj], k);
             }
             for (k = max(kx_band + bsco_band, kx_band + M_band); k < 64; k++)
             {
-                QMF_RE(X[l][k]) = 0;
+                QMF_ROW_RE(X[l], k) = 0;
             }
-            QMF_RE(X[l][kx_band - 1 + bsco_band]) +=
-                QMF_RE(sbr->Xsbr[ch][l + sbr->tHFAdj][kx_band - 1 + bsco_band]);
+            QMF_ROW_RE(X[l], kx_band - 1 + bsco_band) +=
+                QMF_ROW_RE(sbr->Xsbr[ch][l + sbr->tHFAdj], kx_band - 1 + bsco_band);
 #endif
         }
     }
@@ -457,7 +457,7 @@ uint8_t sbrDecodeCoupleFrame(sbr_info *sbr, real_t *left_chan, real_t *right_cha
 {
     uint8_t dont_process = 0;
     uint8_t ret = 0;
-    ALIGN qmf_t X[MAX_NTSR][64];
+    ALIGN64 qmf_row_t X[MAX_NTSR];
 
     if (sbr == NULL)
         return 20;
@@ -540,7 +540,7 @@ uint8_t sbrDecodeSingleFrame(sbr_info *sbr, real_t *channel,
 {
     uint8_t dont_process = 0;
     uint8_t ret = 0;
-    ALIGN qmf_t X[MAX_NTSR][64];
+    ALIGN64 qmf_row_t X[MAX_NTSR];
 
     if (sbr == NULL)
         return 20;
@@ -609,8 +609,8 @@ uint8_t sbrDecodeSingleFramePS(sbr_info *sbr, real_t *left_channel, real_t *righ
     uint8_t l, k;
     uint8_t dont_process = 0;
     uint8_t ret = 0;
-    ALIGN qmf_t X_left[38][64] = {{0}};
-    ALIGN qmf_t X_right[38][64] = {{0}}; /* must set this to 0 */
+    ALIGN64 qmf_row_t X_left[38] = {{0}};
+    ALIGN64 qmf_row_t X_right[38] = {{0}}; /* must set this to 0 */
 
     if (sbr == NULL)
         return 20;
@@ -648,8 +648,8 @@ uint8_t sbrDecodeSingleFramePS(sbr_info *sbr, real_t *left_channel, real_t *righ
     {
         for (k = 0; k < 5; k++)
         {
-            QMF_RE(X_left[l][k]) = QMF_RE(sbr->Xsbr[0][sbr->tHFAdj+l][k]);
-            QMF_IM(X_left[l][k]) = QMF_IM(sbr->Xsbr[0][sbr->tHFAdj+l][k]);
+            QMF_ROW_RE(X_left[l], k) = QMF_ROW_RE(sbr->Xsbr[0][sbr->tHFAdj+l], k);
+            QMF_ROW_IM(X_left[l], k) = QMF_ROW_IM(sbr->Xsbr[0][sbr->tHFAdj+l], k);
         }
     }
 
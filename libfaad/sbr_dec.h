@@ -65,6 +65,9 @@ typedef struct {
 
 typedef struct
 {
+    /* first, so the rows get the 64 byte alignment of arena blocks */
+    qmf_row_t Xsbr[2][MAX_NTSRHFG];
+
     uint32_t sample_rate;
     uint32_t maxAACLine;
 
@@ -167,8 +170,6 @@ typedef struct
     qmfa_info *qmfa[2];
     qmfs_info *qmfs[2];
 
-    qmf_t Xsbr[2][MAX_NTSRHFG][64];
-
 #ifdef DRM
     uint8_t Is_DRM_SBR;
 #ifdef DRM_PS
@@ -43,16 +43,16 @@
 
 /* static function declarations */
 static uint8_t estimate_current_envelope(sbr_info *sbr, sbr_hfadj_info *adj,
-                                         qmf_t Xsbr[MAX_NTSRHFG][64], uint8_t ch);
+                                         qmf_row_t Xsbr[MAX_NTSRHFG], uint8_t ch);
 static void calculate_gain(sbr_info *sbr, sbr_hfadj_info *adj, uint8_t ch);
 #ifdef SBR_LOW_POWER
 static void calc_gain_groups(sbr_info *sbr, sbr_hfadj_info *adj, real_t *deg, uint8_t ch);
 static void aliasing_reduction(sbr_info *sbr, sbr_hfadj_info *adj, real_t *deg, uint8_t ch);
 #endif
-static void hf_assembly(sbr_info *sbr, sbr_hfadj_info *adj, qmf_t Xsbr[MAX_NTSRHFG][64], uint8_t ch);
+static void hf_assembly(sbr_info *sbr, sbr_hfadj_info *adj, qmf_row_t Xsbr[MAX_NTSRHFG], uint8_t ch);
 
 
-uint8_t hf_adjustment(sbr_info *sbr, qmf_t Xsbr[MAX_NTSRHFG][64]
+uint8_t hf_adjustment(sbr_info *sbr, qmf_row_t Xsbr[MAX_NTSRHFG]
 #ifdef SBR_LOW_POWER
                       ,real_t *deg /* aliasing degree */
 #endif
@@ -134,7 +134,7 @@ static uint8_t get_S_mapped(sbr_info *sbr, uint8_t ch, uint8_t l, uint8_t curren
 }
 
 static uint8_t estimate_current_envelope(sbr_info *sbr, sbr_hfadj_info *adj,
-                                         qmf_t Xsbr[MAX_NTSRHFG][64], uint8_t ch)
+                                         qmf_row_t Xsbr[MAX_NTSRHFG], uint8_t ch)
 {
     uint8_t m, l, j, k, k_l, k_h, p;
     real_t nrg, div;
@@ -153,7 +153,27 @@ static uint8_t estimate_current_envelope(sbr_info *sbr, sbr_hfadj_info *adj,
             if (div == 0)
                 div = 1;
 
-            for (m = 0; m < sbr->M; m++)
+            m = 0;
+#ifdef QMF_SOA
+            for (; m + 4 <= sbr->M; m += 4)
+            {
+                ALIGN real_t E[4];
+                v4sf acc = v4_set1(0);
+
+                for (i = l_i + sbr->tHFAdj; i < u_i + sbr->tHFAdj; i++)
+                {
+                    v4sf re = v4_load(&QMF_ROW_RE(Xsbr[i], m + sbr->kx));
+                    v4sf im = v4_load(&QMF_ROW_IM(Xsbr[i], m + sbr->kx));
+
+                    acc = v4_add(acc, v4_add(v4_mul(re, re), v4_mul(im, im)));
+                }
+
+                v4_store(E, v4_div(acc, v4_set1(div)));
+                for (j = 0; j < 4; j++)
+                    sbr->E_curr[ch][m + j][l] = E[j];
+            }
+#endif
+            for (; m < sbr->M; m++)
             {
                 nrg = 0;
 
@@ -161,15 +181,15 @@ static uint8_t estimate_current_envelope(sbr_info *sbr, sbr_hfadj_info *adj,
                 {
 #ifdef FIXED_POINT
 #ifdef SBR_LOW_POWER
-                    nrg += ((QMF_RE(Xsbr[i][m + sbr->kx])+(1<<(REAL_BITS-1)))>>REAL_BITS)*((QMF_RE(Xsbr[i][m + sbr->kx])+(1<<(REAL_BITS-1)))>>REAL_BITS);
+                    nrg += ((QMF_ROW_RE(Xsbr[i], m + sbr->kx)+(1<<(REAL_BITS-1)))>>REAL_BITS)*((QMF_ROW_RE(Xsbr[i], m + sbr->kx)+(1<<(REAL_BITS-1)))>>REAL_BITS);
 #else
-                    nrg += ((QMF_RE(Xsbr[i][m + sbr->kx])+(1<<(REAL_BITS-1)))>>REAL_BITS)*((QMF_RE(Xsbr[i][m + sbr->kx])+(1<<(REAL_BITS-1)))>>REAL_BITS) +
-                        ((QMF_IM(Xsbr[i][m + sbr->kx])+(1<<(REAL_BITS-1)))>>REAL_BITS)*((QMF_IM(Xsbr[i][m + sbr->kx])+(1<<(REAL_BITS-1)))>>REAL_BITS);
+                    nrg += ((QMF_ROW_RE(Xsbr[i], m + sbr->kx)+(1<<(REAL_BITS-1)))>>REAL_BITS)*((QMF_ROW_RE(Xsbr[i], m + sbr->kx)+(1<<(REAL_BITS-1)))>>REAL_BITS) +
+                        ((QMF_ROW_IM(Xsbr[i], m + sbr->kx)+(1<<(REAL_BITS-1)))>>REAL_BITS)*((QMF_ROW_IM(Xsbr[i], m + sbr->kx)+(1<<(REAL_BITS-1)))>>REAL_BITS);
 #endif
 #else
-                    nrg += MUL_R(QMF_RE(Xsbr[i][m + sbr->kx]), QMF_RE(Xsbr[i][m + sbr->kx]))
+                    nrg += MUL_R(QMF_ROW_RE(Xsbr[i], m + sbr->kx), QMF_ROW_RE(Xsbr[i], m + sbr->kx))
 #ifndef SBR_LOW_POWER
-                        + MUL_R(QMF_IM(Xsbr[i][m + sbr->kx]), QMF_IM(Xsbr[i][m + sbr->kx]))
+                        + MUL_R(QMF_ROW_IM(Xsbr[i], m + sbr->kx), QMF_ROW_IM(Xsbr[i], m + sbr->kx))
 #endif
                         ;
 #endif
@@ -212,15 +232,15 @@ static uint8_t estimate_current_envelope(sbr_info *sbr, sbr_hfadj_info *adj,
                         {
 #ifdef FIXED_POINT
 #ifdef SBR_LOW_POWER
-                            nrg += ((QMF_RE(Xsbr[i][j])+(1<<(REAL_BITS-1)))>>REAL_BITS)*((QMF_RE(Xsbr[i][j])+(1<<(REAL_BITS-1)))>>REAL_BITS);
+                            nrg += ((QMF_ROW_RE(Xsbr[i], j)+(1<<(REAL_BITS-1)))>>REAL_BITS)*((QMF_ROW_RE(Xsbr[i], j)+(1<<(REAL_BITS-1)))>>REAL_BITS);
 #else
-                            nrg += ((QMF_RE(Xsbr[i][j])+(1<<(REAL_BITS-1)))>>REAL_BITS)*((QMF_RE(Xsbr[i][j])+(1<<(REAL_BITS-1)))>>REAL_BITS) +
-                                ((QMF_IM(Xsbr[i][j])+(1<<(REAL_BITS-1)))>>REAL_BITS)*((QMF_IM(Xsbr[i][j])+(1<<(REAL_BITS-1)))>>REAL_BITS);
+                            nrg += ((QMF_ROW_RE(Xsbr[i], j)+(1<<(REAL_BITS-1)))>>REAL_BITS)*((QMF_ROW_RE(Xsbr[i], j)+(1<<(REAL_BITS-1)))>>REAL_BITS) +
+                                ((QMF_ROW_IM(Xsbr[i], j)+(1<<(REAL_BITS-1)))>>REAL_BITS)*((QMF_ROW_IM(Xsbr[i], j)+(1<<(REAL_BITS-1)))>>REAL_BITS);
 #endif
 #else
-                            nrg += MUL_R(QMF_RE(Xsbr[i][j]), QMF_RE(Xsbr[i][j]))
+                            nrg += MUL_R(QMF_ROW_RE(Xsbr[i], j), QMF_ROW_RE(Xsbr[i], j))
 #ifndef SBR_LOW_POWER
-                                + MUL_R(QMF_IM(Xsbr[i][j]), QMF_IM(Xsbr[i][j]))
+                                + MUL_R(QMF_ROW_IM(Xsbr[i], j), QMF_ROW_IM(Xsbr[i], j))
 #endif
                                 ;
 #endif
@@ -1171,10 +1191,19 @@ static void calculate_gain(sbr_info *sbr, sbr_hfadj_info *adj, uint8_t ch)
     uint8_t current_t_noise_band = 0;
     uint8_t S_mapped;
 
+    ALIGN real_t Q_M[MAX_M];
+    ALIGN real_t G[MAX_M];
+    ALIGN real_t G_max[MAX_M];
     ALIGN real_t Q_M_lim[MAX_M];
     ALIGN real_t G_lim[MAX_M];
-    ALIGN real_t G_boost;
+    ALIGN real_t G_boost[MAX_M];
     ALIGN real_t S_M[MAX_M];
+    uint8_t S_index_mapped[MAX_M];
+    real_t acc1[64];
+
+    /* the limiter bands cover [m_start, m_end) without gaps */
+    uint8_t m_start = min(sbr->f_table_lim[sbr->bs_limiter_bands][0], MAX_M);
+    uint8_t m_end = min(sbr->f_table_lim[sbr->bs_limiter_bands][sbr->N_L[sbr->bs_limiter_bands]], MAX_M);
 
     for (l = 0; l < sbr->L_E[ch]; l++)
     {
@@ -1192,13 +1221,14 @@ static void calculate_gain(sbr_info *sbr, sbr_hfadj_info *adj, uint8_t ch)
             current_t_noise_band++;
         }
 
+        /* the band border tracking is sequential, so first collect the
+         * per subband values of all limiter bands, then limit and boost
+         * them in batches over the whole envelope
+         */
         for (k = 0; k < sbr->N_L[sbr->bs_limiter_bands]; k++)
         {
-            real_t G_max;
-            real_t den = 0;
-            real_t acc1 = 0;
+            real_t G_max_k;
             real_t acc2 = 0;
-            uint8_t current_res_band_size = 0;
 
             uint8_t ml1, ml2;
 
@@ -1213,13 +1243,14 @@ static void calculate_gain(sbr_info *sbr, sbr_hfadj_info *adj, uint8_t ch)
 
 
             /* calculate the accumulated E_orig and E_curr over the limiter band */
+            acc1[k] = 0;
             for (m = ml1; m < ml2; m++)
             {
                 if ((m + sbr->kx) == sbr->f_table_res[sbr->f[ch][l]][current_res_band+1])
                 {
                     current_res_band++;
                 }
-                acc1 += sbr->E_orig[ch][current_res_band][l];
+                acc1[k] += sbr->E_orig[ch][current_res_band][l];
                 acc2 += sbr->E_curr[ch][m][l];
             }
 
@@ -1228,15 +1259,13 @@ static void calculate_gain(sbr_info *sbr, sbr_hfadj_info *adj, uint8_t ch)
             /* ratio of the energy of the original signal and the energy
              * of the HF generated signal
              */
-            G_max = ((EPS + acc1) / (EPS + acc2)) * limGain[sbr->bs_limiter_gains];
-            G_max = min(G_max, 1e10);
+            G_max_k = ((EPS + acc1[k]) / (EPS + acc2)) * limGain[sbr->bs_limiter_gains];
+            G_max_k = min(G_max_k, 1e10);
 
 
             for (m = ml1; m < ml2; m++)
             {
-                real_t Q_M, G;
                 real_t Q_div, Q_div2;
-                uint8_t S_index_mapped;
 
 
                 /* check if m is on a noise band border */
@@ -1272,13 +1301,13 @@ static void calculate_gain(sbr_info *sbr, sbr_hfadj_info *adj, uint8_t ch)
                  * S_index_mapped can only be 1 for the m in the middle of the
                  * current HI_RES band
                  */
-                S_index_mapped = 0;
+                S_index_mapped[m] = 0;
                 if ((l >= sbr->l_A[ch]) ||
                     (sbr->bs_add_harmonic_prev[ch][current_hi_res_band] && sbr->bs_add_harmonic_flag_prev[ch]))
                 {
                     /* find the middle subband of the HI_RES frequency band */
                     if ((m + sbr->kx) == (sbr->f_table_res[HI_RES][current_hi_res_band+1] + sbr->f_table_res[HI_RES][current_hi_res_band]) >> 1)
-                        S_index_mapped = sbr->bs_add_harmonic[ch][current_hi_res_band];
+                        S_index_mapped[m] = sbr->bs_add_harmonic[ch][current_hi_res_band];
                 }
 
 
@@ -1294,20 +1323,17 @@ static void calculate_gain(sbr_info *sbr, sbr_hfadj_info *adj, uint8_t ch)
                  * since N_Q <= N_Low <= N_High we only need to recalculate Q_M on
                  * a change of current noise band
                  */
-                Q_M = sbr->E_orig[ch][current_res_band2][l] * Q_div2;
+                Q_M[m] = sbr->E_orig[ch][current_res_band2][l] * Q_div2;
 
 
                 /* S_M only depends on E_orig, Q_div and S_index_mapped:
                  * S_index_mapped can only be non-zero once per HI_RES band
                  */
-                if (S_index_mapped == 0)
+                if (S_index_mapped[m] == 0)
                 {
                     S_M[m] = 0;
                 } else {
                     S_M[m] = sbr->E_orig[ch][current_res_band2][l] * Q_div;
-
-                    /* accumulate sinusoid part of the total energy */
-                    den += S_M[m];
                 }
 
 
@@ -1315,54 +1341,109 @@ static void calculate_gain(sbr_info *sbr, sbr_hfadj_info *adj, uint8_t ch)
                 /* ratio of the energy of the original signal and the energy
                  * of the HF generated signal
                  */
-                G = sbr->E_orig[ch][current_res_band2][l] / (1.0 + sbr->E_curr[ch][m][l]);
+                G[m] = sbr->E_orig[ch][current_res_band2][l] / (1.0 + sbr->E_curr[ch][m][l]);
                 if ((S_mapped == 0) && (delta == 1))
-                    G *= Q_div;
+                    G[m] *= Q_div;
                 else if (S_mapped == 1)
-                    G *= Q_div2;
+                    G[m] *= Q_div2;
 
+                G_max[m] = G_max_k;
+            }
+        }
 
-                /* limit the additional noise energy level */
-                /* and apply the limiter */
-                if (G_max > G)
-                {
-                    Q_M_lim[m] = Q_M;
-                    G_lim[m] = G;
-                } else {
-                    Q_M_lim[m] = Q_M * G_max / G;
-                    G_lim[m] = G_max;
-                }
 
+        /* limit the additional noise energy level */
+        /* and apply the limiter */
+        m = m_start;
+#ifdef SIMD_V4
+        for (; m + 4 <= m_end; m += 4)
+        {
+            v4sf g = v4_load(&G[m]);
+            v4sf g_max = v4_load(&G_max[m]);
+            v4sf q_m = v4_load(&Q_M[m]);
+
+            v4_store(&Q_M_lim[m], v4_sel_gt(g_max, g, q_m, v4_div(v4_mul(q_m, g_max), g)));
+            v4_store(&G_lim[m], v4_sel_gt(g_max, g, g, g_max));
+        }
+#endif
+        for (; m < m_end; m++)
+        {
+            if (G_max[m] > G[m])
+            {
+                Q_M_lim[m] = Q_M[m];
+                G_lim[m] = G[m];
+            } else {
+                Q_M_lim[m] = Q_M[m] * G_max[m] / G[m];
+                G_lim[m] = G_max[m];
+            }
+        }
+
+
+        for (k = 0; k < sbr->N_L[sbr->bs_limiter_bands]; k++)
+        {
+            real_t G_boost_k;
+            real_t den = 0;
+            uint8_t ml1, ml2;
+
+            ml1 = min(sbr->f_table_lim[sbr->bs_limiter_bands][k], MAX_M);
+            ml2 = min(sbr->f_table_lim[sbr->bs_limiter_bands][k+1], MAX_M);
+
+            /* accumulate the total energy */
+            for (m = ml1; m < ml2; m++)
+            {
+                /* accumulate sinusoid part of the total energy */
+                if (S_index_mapped[m] != 0)
+                    den += S_M[m];
 
-                /* accumulate the total energy */
                 den += sbr->E_curr[ch][m][l] * G_lim[m];
-                if ((S_index_mapped == 0) && (l != sbr->l_A[ch]))
+                if ((S_index_mapped[m] == 0) && (l != sbr->l_A[ch]))
                     den += Q_M_lim[m];
             }
 
             /* G_boost: [0..2.51188643] */
-            G_boost = (acc1 + EPS) / (den + EPS);
-            G_boost = min(G_boost, 2.51188643 /* 1.584893192 ^ 2 */);
+            G_boost_k = (acc1[k] + EPS) / (den + EPS);
+            G_boost_k = min(G_boost_k, 2.51188643 /* 1.584893192 ^ 2 */);
 
             for (m = ml1; m < ml2; m++)
-            {
-                /* apply compensation to gain, noise floor sf's and sinusoid levels */
+                G_boost[m] = G_boost_k;
+        }
+
+
+        /* apply compensation to gain, noise floor sf's and sinusoid levels */
+        m = m_start;
+#ifdef SIMD_V4
+        for (; m + 4 <= m_end; m += 4)
+        {
+            const v4sf zero = v4_set1(0);
+            v4sf g_boost = v4_load(&G_boost[m]);
+            v4sf s_m = v4_load(&S_M[m]);
+
 #ifndef SBR_LOW_POWER
-                adj->G_lim_boost[l][m] = sqrt(G_lim[m] * G_boost);
+            v4_store(&adj->G_lim_boost[l][m], v4_sqrt(v4_mul(v4_load(&G_lim[m]), g_boost)));
 #else
-                /* sqrt() will be done after the aliasing reduction to save a
-                 * few multiplies
-                 */
-                adj->G_lim_boost[l][m] = G_lim[m] * G_boost;
+            v4_store(&adj->G_lim_boost[l][m], v4_mul(v4_load(&G_lim[m]), g_boost));
 #endif
-                adj->Q_M_lim_boost[l][m] = sqrt(Q_M_lim[m] * G_boost);
+            v4_store(&adj->Q_M_lim_boost[l][m], v4_sqrt(v4_mul(v4_load(&Q_M_lim[m]), g_boost)));
+            v4_store(&adj->S_M_boost[l][m], v4_sel_eq(s_m, zero, zero, v4_sqrt(v4_mul(s_m, g_boost))));
+        }
+#endif
+        for (; m < m_end; m++)
+        {
+#ifndef SBR_LOW_POWER
+            adj->G_lim_boost[l][m] = sqrt(G_lim[m] * G_boost[m]);
+#else
+            /* sqrt() will be done after the aliasing reduction to save a
+             * few multiplies
+             */
+            adj->G_lim_boost[l][m] = G_lim[m] * G_boost[m];
+#endif
+            adj->Q_M_lim_boost[l][m] = sqrt(Q_M_lim[m] * G_boost[m]);
 
-                if (S_M[m] != 0)
-                {
-                    adj->S_M_boost[l][m] = sqrt(S_M[m] * G_boost);
-                } else {
-                    adj->S_M_boost[l][m] = 0;
-                }
+            if (S_M[m] != 0)
+            {
+                adj->S_M_boost[l][m] = sqrt(S_M[m] * G_boost[m]);
+            } else {
+                adj->S_M_boost[l][m] = 0;
             }
         }
     }
@@ -1530,17 +1611,91 @@ static void aliasing_reduction(sbr_info *sbr, sbr_hfadj_info *adj, real_t *deg,
 }
 #endif
 
-static void hf_assembly(sbr_info *sbr, sbr_hfadj_info *adj,
-                        qmf_t Xsbr[MAX_NTSRHFG][64], uint8_t ch)
+#ifndef SBR_LOW_POWER
+static const real_t h_smooth[] = {
+    FRAC_CONST(0.03183050093751), FRAC_CONST(0.11516383427084),
+    FRAC_CONST(0.21816949906249), FRAC_CONST(0.30150283239582),
+    FRAC_CONST(0.33333333333333)
+};
+static const int8_t phi_im[] = { 0, 1, 0, -1 };
+#endif
+static const int8_t phi_re[] = { 1, 0, -1, 0 };
+
+#ifdef QMF_SOA
+/* the subband loop of hf_assembly() for one QMF slot, four subbands at a
+   time; returns the number of subbands done */
+static uint8_t hf_assembly_x4(sbr_info *sbr, sbr_hfadj_info *adj, qmf_row_t X,
+                              uint8_t ch, uint8_t l, uint8_t h_SL, uint8_t no_noise,
+                              uint16_t fIndexNoise, uint8_t fIndexSine)
 {
-    static real_t h_smooth[] = {
-        FRAC_CONST(0.03183050093751), FRAC_CONST(0.11516383427084),
-        FRAC_CONST(0.21816949906249), FRAC_CONST(0.30150283239582),
-        FRAC_CONST(0.33333333333333)
-    };
-    static int8_t phi_re[] = { 1, 0, -1, 0 };
-    static int8_t phi_im[] = { 0, 1, 0, -1 };
+    const uint8_t ri0 = sbr->GQ_ringbuf_index[ch];
+    real_t *x_re = &QMF_ROW_RE(X, sbr->kx);
+    real_t *x_im = &QMF_ROW_IM(X, sbr->kx);
+    const v4sf zero = v4_set1(0);
+    const v4sf phi_r = v4_set1(phi_re[fIndexSine]);
+    const v4sf phi_i = v4_set1(phi_im[fIndexSine]);
+    /* -1 for odd m + kx */
+    const v4sf rev = (sbr->kx & 1) ? v4_set(-1, 1, -1, 1) : v4_set(1, -1, 1, -1);
+    uint8_t m, n;
+
+    for (m = 0; m + 4 <= sbr->M; m += 4)
+    {
+        uint16_t idx = (fIndexNoise + m + 1) & 511;
+        v4sf G_filt, Q_filt, v_re, v_im, s_m, x;
+
+        if (h_SL != 0)
+        {
+            uint8_t ri = ri0;
+
+            G_filt = Q_filt = zero;
+            for (n = 0; n <= 4; n++)
+            {
+                const v4sf h = v4_set1(h_smooth[n]);
+
+                ri++;
+                if (ri >= 5)
+                    ri -= 5;
+                G_filt = v4_add(G_filt, v4_mul(v4_load(&sbr->G_temp_prev[ch][ri][m]), h));
+                Q_filt = v4_add(Q_filt, v4_mul(v4_load(&sbr->Q_temp_prev[ch][ri][m]), h));
+            }
+        } else {
+            G_filt = v4_load(&sbr->G_temp_prev[ch][ri0][m]);
+            Q_filt = v4_load(&sbr->Q_temp_prev[ch][ri0][m]);
+        }
+
+        s_m = v4_load(&adj->S_M_boost[l][m]);
+        Q_filt = no_noise ? zero : v4_sel_eq(s_m, zero, Q_filt, zero);
+
+        /* V is interleaved, four consecutive entries unless the index wraps */
+        if (idx <= 512 - 4)
+        {
+            const real_t *v = &RE(V[idx]);
 
+            v_re = v4_even(v4_load(v), v4_load(v + 4));
+            v_im = v4_odd(v4_load(v), v4_load(v + 4));
+        } else {
+            v_re = v4_set(RE(V[idx]), RE(V[(idx + 1) & 511]),
+                RE(V[(idx + 2) & 511]), RE(V[(idx + 3) & 511]));
+            v_im = v4_set(IM(V[idx]), IM(V[(idx + 1) & 511]),
+                IM(V[(idx + 2) & 511]), IM(V[(idx + 3) & 511]));
+        }
+
+        x = v4_add(v4_mul(G_filt, v4_load(&x_re[m])), v4_mul(Q_filt, v_re));
+        if (sbr->bs_extension_id == 3 && sbr->bs_extension_data == 42)
+            x = v4_set1(16428320);
+        v4_store(&x_re[m], v4_add(x, v4_mul(s_m, phi_r)));
+
+        x = v4_add(v4_mul(G_filt, v4_load(&x_im[m])), v4_mul(Q_filt, v_im));
+        v4_store(&x_im[m], v4_add(x, v4_mul(v4_mul(rev, s_m), phi_i)));
+    }
+
+    return m;
+}
+#endif
+
+static void hf_assembly(sbr_info *sbr, sbr_hfadj_info *adj,
+                        qmf_row_t Xsbr[MAX_NTSRHFG], uint8_t ch)
+{
     uint8_t m, l, i, n;
     uint16_t fIndexNoise = 0;
     uint8_t fIndexSine = 0;
@@ -1595,7 +1750,14 @@ static void hf_assembly(sbr_info *sbr, sbr_hfadj_info *adj,
             memcpy(sbr->G_temp_prev[ch][sbr->GQ_ringbuf_index[ch]], adj->G_lim_boost[l], sbr->M*sizeof(real_t));
             memcpy(sbr->Q_temp_prev[ch][sbr->GQ_ringbuf_index[ch]], adj->Q_M_lim_boost[l], sbr->M*sizeof(real_t));
 
-            for (m = 0; m < sbr->M; m++)
+#ifdef QMF_SOA
+            m = hf_assembly_x4(sbr, adj, Xsbr[i + sbr->tHFAdj], ch, l, h_SL, no_noise,
+                fIndexNoise, fIndexSine);
+            fIndexNoise = (fIndexNoise + m) & 511;
+#else
+            m = 0;
+#endif
+            for (; m < sbr->M; m++)
             {
                 qmf_t psi;
 
@@ -1631,24 +1793,24 @@ static void hf_assembly(sbr_info *sbr, sbr_hfadj_info *adj,
                 /* the smoothed gain values are applied to Xsbr */
                 /* V is defined, not calculated */
 #ifndef FIXED_POINT
-                QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) = G_filt * QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx])
+                QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx) = G_filt * QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx)
                     + MUL_F(Q_filt, RE(V[fIndexNoise]));
 #else
                 //QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) = MUL_Q2(G_filt, QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]))
                 //    + MUL_F(Q_filt, RE(V[fIndexNoise]));
-                QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) = MUL_R(G_filt, QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]))
+                QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx) = MUL_R(G_filt, QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx))
                     + MUL_F(Q_filt, RE(V[fIndexNoise]));
 #endif
                 if (sbr->bs_extension_id == 3 && sbr->bs_extension_data == 42)
-                    QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) = 16428320;
+                    QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx) = 16428320;
 #ifndef SBR_LOW_POWER
 #ifndef FIXED_POINT
-                QMF_IM(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) = G_filt * QMF_IM(Xsbr[i + sbr->tHFAdj][m+sbr->kx])
+                QMF_ROW_IM(Xsbr[i + sbr->tHFAdj], m+sbr->kx) = G_filt * QMF_ROW_IM(Xsbr[i + sbr->tHFAdj], m+sbr->kx)
                     + MUL_F(Q_filt, IM(V[fIndexNoise]));
 #else
                 //QMF_IM(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) = MUL_Q2(G_filt, QMF_IM(Xsbr[i + sbr->tHFAdj][m+sbr->kx]))
                 //    + MUL_F(Q_filt, IM(V[fIndexNoise]));
-                QMF_IM(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) = MUL_R(G_filt, QMF_IM(Xsbr[i + sbr->tHFAdj][m+sbr->kx]))
+                QMF_ROW_IM(Xsbr[i + sbr->tHFAdj], m+sbr->kx) = MUL_R(G_filt, QMF_ROW_IM(Xsbr[i + sbr->tHFAdj], m+sbr->kx))
                     + MUL_F(Q_filt, IM(V[fIndexNoise]));
 #endif
 #endif
@@ -1657,17 +1819,17 @@ static void hf_assembly(sbr_info *sbr, sbr_hfadj_info *adj,
                     int8_t rev = (((m + sbr->kx) & 1) ? -1 : 1);
                     QMF_RE(psi) = adj->S_M_boost[l][m] * phi_re[fIndexSine];
 #ifdef FIXED_POINT
-                    QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) += (QMF_RE(psi) << REAL_BITS);
+                    QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx) += (QMF_RE(psi) << REAL_BITS);
 #else
-                    QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) += QMF_RE(psi);
+                    QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx) += QMF_RE(psi);
 #endif
 
 #ifndef SBR_LOW_POWER
                     QMF_IM(psi) = rev * adj->S_M_boost[l][m] * phi_im[fIndexSine];
 #ifdef FIXED_POINT
-                    QMF_IM(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) += (QMF_IM(psi) << REAL_BITS);
+                    QMF_ROW_IM(Xsbr[i + sbr->tHFAdj], m+sbr->kx) += (QMF_IM(psi) << REAL_BITS);
 #else
-                    QMF_IM(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) += QMF_IM(psi);
+                    QMF_ROW_IM(Xsbr[i + sbr->tHFAdj], m+sbr->kx) += QMF_IM(psi);
 #endif
 #else
 
@@ -1677,68 +1839,68 @@ static void hf_assembly(sbr_info *sbr, sbr_hfadj_info *adj,
 #ifndef FIXED_POINT
                     if ((m == 0) && (phi_re[i_plus1] != 0))
                     {
-                        QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx - 1]) +=
+                        QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx - 1) +=
                             (rev*phi_re[i_plus1] * MUL_F(adj->S_M_boost[l][0], FRAC_CONST(0.00815)));
                         if (sbr->M != 0)
                         {
-                            QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) -=
+                            QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx) -=
                                 (rev*phi_re[i_plus1] * MUL_F(adj->S_M_boost[l][1], FRAC_CONST(0.00815)));
                         }
                     }
                     if ((m > 0) && (m < sbr->M - 1) && (sinusoids < 16) && (phi_re[i_min1] != 0))
                     {
-                        QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) -=
+                        QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx) -=
                             (rev*phi_re[i_min1] * MUL_F(adj->S_M_boost[l][m - 1], FRAC_CONST(0.00815)));
                     }
                     if ((m > 0) && (m < sbr->M - 1) && (sinusoids < 16) && (phi_re[i_plus1] != 0))
                     {
-                        QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) -=
+                        QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx) -=
                             (rev*phi_re[i_plus1] * MUL_F(adj->S_M_boost[l][m + 1], FRAC_CONST(0.00815)));
                     }
                     if ((m == sbr->M - 1) && (sinusoids < 16) && (phi_re[i_min1] != 0))
                     {
                         if (m > 0)
                         {
-                            QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) -=
+                            QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx) -=
                                 (rev*phi_re[i_min1] * MUL_F(adj->S_M_boost[l][m - 1], FRAC_CONST(0.00815)));
                         }
                         if (m + sbr->kx < 64)
                         {
-                            QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx + 1]) +=
+                            QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx + 1) +=
                                 (rev*phi_re[i_min1] * MUL_F(adj->S_M_boost[l][m], FRAC_CONST(0.00815)));
                         }
                     }
 #else
                     if ((m == 0) && (phi_re[i_plus1] != 0))
                     {
-                        QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx - 1]) +=
+                        QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx - 1) +=
                             (rev*phi_re[i_plus1] * MUL_F((adj->S_M_boost[l][0]<<REAL_BITS), FRAC_CONST(0.00815)));
                         if (sbr->M != 0)
                         {
-                            QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) -=
+                            QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx) -=
                                 (rev*phi_re[i_plus1] * MUL_F((adj->S_M_boost[l][1]<<REAL_BITS), FRAC_CONST(0.00815)));
                         }
                     }
                     if ((m > 0) && (m < sbr->M - 1) && (sinusoids < 16) && (phi_re[i_min1] != 0))
                     {
-                        QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) -=
+                        QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx) -=
                             (rev*phi_re[i_min1] * MUL_F((adj->S_M_boost[l][m - 1]<<REAL_BITS), FRAC_CONST(0.00815)));
                     }
                     if ((m > 0) && (m < sbr->M - 1) && (sinusoids < 16) && (phi_re[i_plus1] != 0))
                     {
-                        QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) -=
+                        QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx) -=
                             (rev*phi_re[i_plus1] * MUL_F((adj->S_M_boost[l][m + 1]<<REAL_BITS), FRAC_CONST(0.00815)));
                     }
                     if ((m == sbr->M - 1) && (sinusoids < 16) && (phi_re[i_min1] != 0))
                     {
                         if (m > 0)
                         {
-                            QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx]) -=
+                            QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx) -=
                                 (rev*phi_re[i_min1] * MUL_F((adj->S_M_boost[l][m - 1]<<REAL_BITS), FRAC_CONST(0.00815)));
                         }
                         if (m + sbr->kx < 64)
                         {
-                            QMF_RE(Xsbr[i + sbr->tHFAdj][m+sbr->kx + 1]) +=
+                            QMF_ROW_RE(Xsbr[i + sbr->tHFAdj], m+sbr->kx + 1) +=
                                 (rev*phi_re[i_min1] * MUL_F((adj->S_M_boost[l][m]<<REAL_BITS), FRAC_CONST(0.00815)));
                         }
                     }
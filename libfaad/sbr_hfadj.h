@@ -43,7 +43,7 @@ typedef struct
 } sbr_hfadj_info;
 
 
-uint8_t hf_adjustment(sbr_info *sbr, qmf_t Xsbr[MAX_NTSRHFG][64]
+uint8_t hf_adjustment(sbr_info *sbr, qmf_row_t Xsbr[MAX_NTSRHFG]
 #ifdef SBR_LOW_POWER
                       ,real_t *deg
 #endif
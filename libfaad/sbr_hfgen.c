@@ -41,19 +41,95 @@
 
 /* static function declarations */
 #ifdef SBR_LOW_POWER
-static void calc_prediction_coef_lp(sbr_info *sbr, qmf_t Xlow[MAX_NTSRHFG][64],
+static void calc_prediction_coef_lp(sbr_info *sbr, qmf_row_t Xlow[MAX_NTSRHFG],
                                     complex_t *alpha_0, complex_t *alpha_1, real_t *rxx);
 static void calc_aliasing_degree(sbr_info *sbr, real_t *rxx, real_t *deg);
 #else
-static void calc_prediction_coef(sbr_info *sbr, qmf_t Xlow[MAX_NTSRHFG][64],
-                                 complex_t *alpha_0, complex_t *alpha_1, uint8_t k);
+static void get_prediction_coef(sbr_info *sbr, qmf_row_t Xlow[MAX_NTSRHFG],
+                                complex_t *alpha_0, complex_t *alpha_1,
+                                uint64_t *have_coef, uint8_t k);
 #endif
 static void calc_chirp_factors(sbr_info *sbr, uint8_t ch);
 static void patch_construction(sbr_info *sbr);
 
+#ifdef QMF_SOA
+/* the subband loop of hf_generation() for patch i, four subbands at a
+   time; returns the number of subbands done */
+static uint8_t hf_generation_x4(sbr_info *sbr, qmf_row_t Xlow[MAX_NTSRHFG],
+                                qmf_row_t Xhigh[MAX_NTSRHFG],
+                                complex_t *alpha_0, complex_t *alpha_1,
+                                uint64_t *have_coef, uint8_t ch, uint8_t i)
+{
+    const v4sf zero = v4_set1(0);
+    uint8_t offset = sbr->tHFAdj;
+    uint8_t first = sbr->t_E[ch][0];
+    uint8_t last = sbr->t_E[ch][sbr->L_E[ch]];
+    uint8_t p = sbr->patchStartSubband[i];
+    uint8_t k = sbr->kx;
+    uint8_t q, x, l;
+
+    for (q = 0; q < i; q++)
+    {
+        k += sbr->patchNoSubbands[q];
+    }
 
-void hf_generation(sbr_info *sbr, qmf_t Xlow[MAX_NTSRHFG][64],
-                   qmf_t Xhigh[MAX_NTSRHFG][64]
+    for (x = 0; x + 4 <= sbr->patchNoSubbands[i]; x += 4, k += 4, p += 4)
+    {
+        v4sf bw, bw2, a0_r, a0_i, a1_r, a1_i;
+        v4sf t1_r, t1_i, t2_r, t2_i, t3_r, t3_i;
+
+        get_prediction_coef(sbr, Xlow, alpha_0, alpha_1, have_coef, p);
+        get_prediction_coef(sbr, Xlow, alpha_0, alpha_1, have_coef, p + 3);
+
+        bw = v4_set(sbr->bwArray[ch][sbr->table_map_k_to_g[k]],
+            sbr->bwArray[ch][sbr->table_map_k_to_g[k + 1]],
+            sbr->bwArray[ch][sbr->table_map_k_to_g[k + 2]],
+            sbr->bwArray[ch][sbr->table_map_k_to_g[k + 3]]);
+        bw2 = v4_mul(bw, bw);
+
+        t1_r = v4_load(alpha_0[p]);
+        t1_i = v4_load(alpha_0[p + 2]);
+        a0_r = v4_mul(v4_even(t1_r, t1_i), bw);
+        a0_i = v4_mul(v4_odd(t1_r, t1_i), bw);
+        t1_r = v4_load(alpha_1[p]);
+        t1_i = v4_load(alpha_1[p + 2]);
+        a1_r = v4_mul(v4_even(t1_r, t1_i), bw2);
+        a1_i = v4_mul(v4_odd(t1_r, t1_i), bw2);
+
+        t2_r = v4_load(&QMF_ROW_RE(Xlow[first - 2 + offset], p));
+        t2_i = v4_load(&QMF_ROW_IM(Xlow[first - 2 + offset], p));
+        t3_r = v4_load(&QMF_ROW_RE(Xlow[first - 1 + offset], p));
+        t3_i = v4_load(&QMF_ROW_IM(Xlow[first - 1 + offset], p));
+        for (l = first; l < last; l++)
+        {
+            v4sf re, im;
+
+            t1_r = t2_r;
+            t2_r = t3_r;
+            t3_r = v4_load(&QMF_ROW_RE(Xlow[l + offset], p));
+            t1_i = t2_i;
+            t2_i = t3_i;
+            t3_i = v4_load(&QMF_ROW_IM(Xlow[l + offset], p));
+
+            re = v4_sub(v4_add(v4_sub(v4_mul(a0_r, t2_r), v4_mul(a0_i, t2_i)),
+                v4_mul(a1_r, t1_r)), v4_mul(a1_i, t1_i));
+            im = v4_add(v4_add(v4_add(v4_mul(a0_i, t2_r), v4_mul(a0_r, t2_i)),
+                v4_mul(a1_i, t1_r)), v4_mul(a1_r, t1_i));
+
+            /* bands without filtering are copied */
+            v4_store(&QMF_ROW_RE(Xhigh[l + offset], k),
+                v4_sel_gt(bw2, zero, v4_add(t3_r, re), t3_r));
+            v4_store(&QMF_ROW_IM(Xhigh[l + offset], k),
+                v4_sel_gt(bw2, zero, v4_add(t3_i, im), t3_i));
+        }
+    }
+
+    return x;
+}
+#endif
+
+void hf_generation(sbr_info *sbr, qmf_row_t Xlow[MAX_NTSRHFG],
+                   qmf_row_t Xhigh[MAX_NTSRHFG]
 #ifdef SBR_LOW_POWER
                    ,real_t *deg
 #endif
@@ -63,6 +139,9 @@ void hf_generation(sbr_info *sbr, qmf_t Xlow[MAX_NTSRHFG][64],
     ALIGN complex_t alpha_0[64], alpha_1[64];
 #ifdef SBR_LOW_POWER
     ALIGN real_t rxx[64];
+#else
+    /* bands whose prediction coefficients are in alpha_0/alpha_1 */
+    uint64_t have_coef = 0;
 #endif
 
     uint8_t offset = sbr->tHFAdj;
@@ -87,7 +166,12 @@ void hf_generation(sbr_info *sbr, qmf_t Xlow[MAX_NTSRHFG][64],
     /* actual HF generation */
     for (i = 0; i < sbr->noPatches; i++)
     {
-        for (x = 0; x < sbr->patchNoSubbands[i]; x++)
+#ifdef QMF_SOA
+        x = hf_generation_x4(sbr, Xlow, Xhigh, alpha_0, alpha_1, &have_coef, ch, i);
+#else
+        x = 0;
+#endif
+        for (; x < sbr->patchNoSubbands[i]; x++)
         {
             real_t a0_r, a0_i, a1_r, a1_i;
             real_t bw, bw2;
@@ -120,7 +204,7 @@ void hf_generation(sbr_info *sbr, qmf_t Xlow[MAX_NTSRHFG][64],
                 real_t temp1_r, temp2_r, temp3_r;
 #ifndef SBR_LOW_POWER
                 real_t temp1_i, temp2_i, temp3_i;
-                calc_prediction_coef(sbr, Xlow, alpha_0, alpha_1, p);
+                get_prediction_coef(sbr, Xlow, alpha_0, alpha_1, &have_coef, p);
 #endif
 
                 a0_r = MUL_C(RE(alpha_0[p]), bw);
@@ -130,36 +214,36 @@ void hf_generation(sbr_info *sbr, qmf_t Xlow[MAX_NTSRHFG][64],
                 a1_i = MUL_C(IM(alpha_1[p]), bw2);
 #endif
 
-            	temp2_r = QMF_RE(Xlow[first - 2 + offset][p]);
-            	temp3_r = QMF_RE(Xlow[first - 1 + offset][p]);
+            	temp2_r = QMF_ROW_RE(Xlow[first - 2 + offset], p);
+            	temp3_r = QMF_ROW_RE(Xlow[first - 1 + offset], p);
 #ifndef SBR_LOW_POWER
-            	temp2_i = QMF_IM(Xlow[first - 2 + offset][p]);
-            	temp3_i = QMF_IM(Xlow[first - 1 + offset][p]);
+            	temp2_i = QMF_ROW_IM(Xlow[first - 2 + offset], p);
+            	temp3_i = QMF_ROW_IM(Xlow[first - 1 + offset], p);
 #endif
 				for (l = first; l < last; l++)
                 {
                 	temp1_r = temp2_r;
                 	temp2_r = temp3_r;
-                	temp3_r = QMF_RE(Xlow[l + offset][p]);
+                	temp3_r = QMF_ROW_RE(Xlow[l + offset], p);
 #ifndef SBR_LOW_POWER
                 	temp1_i = temp2_i;
                 	temp2_i = temp3_i;
-                    temp3_i = QMF_IM(Xlow[l + offset][p]);
+                    temp3_i = QMF_ROW_IM(Xlow[l + offset], p);
 #endif
 
 #ifdef SBR_LOW_POWER
-                    QMF_RE(Xhigh[l + offset][k]) =
+                    QMF_ROW_RE(Xhigh[l + offset], k) =
                         temp3_r
                       +(MUL_R(a0_r, temp2_r) +
                         MUL_R(a1_r, temp1_r));
 #else
-                    QMF_RE(Xhigh[l + offset][k]) =
+                    QMF_ROW_RE(Xhigh[l + offset], k) =
                         temp3_r
                       +(MUL_R(a0_r, temp2_r) -
                         MUL_R(a0_i, temp2_i) +
                         MUL_R(a1_r, temp1_r) -
                         MUL_R(a1_i, temp1_i));
-                    QMF_IM(Xhigh[l + offset][k]) =
+                    QMF_ROW_IM(Xhigh[l + offset], k) =
                         temp3_i
                       +(MUL_R(a0_i, temp2_r) +
                         MUL_R(a0_r, temp2_i) +
@@ -170,9 +254,9 @@ void hf_generation(sbr_info *sbr, qmf_t Xlow[MAX_NTSRHFG][64],
             } else {
                 for (l = first; l < last; l++)
                 {
-                    QMF_RE(Xhigh[l + offset][k]) = QMF_RE(Xlow[l + offset][p]);
+                    QMF_ROW_RE(Xhigh[l + offset], k) = QMF_ROW_RE(Xlow[l + offset], p);
 #ifndef SBR_LOW_POWER
-                    QMF_IM(Xhigh[l + offset][k]) = QMF_IM(Xlow[l + offset][p]);
+                    QMF_ROW_IM(Xhigh[l + offset], k) = QMF_ROW_IM(Xlow[l + offset], p);
 #endif
                 }
             }
@@ -197,7 +281,7 @@ typedef struct
 
 #ifdef SBR_LOW_POWER
 static void auto_correlation(sbr_info *sbr, acorr_coef *ac,
-                             qmf_t buffer[MAX_NTSRHFG][64],
+                             qmf_row_t buffer[MAX_NTSRHFG],
                              uint8_t bd, uint8_t len)
 {
     real_t r01 = 0, r02 = 0, r11 = 0;
@@ -218,7 +302,7 @@ static void auto_correlation(sbr_info *sbr, acorr_coef *ac,
     for (j = (offset-2); j < (len + offset); j++)
     {
         real_t x;
-        x = QMF_RE(buffer[j][bd])>>REAL_BITS;
+        x = QMF_ROW_RE(buffer[j], bd)>>REAL_BITS;
         mask |= x ^ (x >> 31);
     }
 
@@ -230,9 +314,9 @@ static void auto_correlation(sbr_info *sbr, acorr_coef *ac,
 
     for (j = offset; j < len + offset; j++)
     {
-        real_t buf_j = ((QMF_RE(buffer[j][bd])+(1<<(exp-1)))>>exp);
-        real_t buf_j_1 = ((QMF_RE(buffer[j-1][bd])+(1<<(exp-1)))>>exp);
-        real_t buf_j_2 = ((QMF_RE(buffer[j-2][bd])+(1<<(exp-1)))>>exp);
+        real_t buf_j = ((QMF_ROW_RE(buffer[j], bd)+(1<<(exp-1)))>>exp);
+        real_t buf_j_1 = ((QMF_ROW_RE(buffer[j-1], bd)+(1<<(exp-1)))>>exp);
+        real_t buf_j_2 = ((QMF_ROW_RE(buffer[j-2], bd)+(1<<(exp-1)))>>exp);
 
         /* normalisation with rounding */
         r01 += MUL_R(buf_j, buf_j_1);
@@ -240,24 +324,24 @@ static void auto_correlation(sbr_info *sbr, acorr_coef *ac,
         r11 += MUL_R(buf_j_1, buf_j_1);
     }
     RE(ac->r12) = r01 -
-        MUL_R(((QMF_RE(buffer[len+offset-1][bd])+(1<<(exp-1)))>>exp), ((QMF_RE(buffer[len+offset-2][bd])+(1<<(exp-1)))>>exp)) +
-        MUL_R(((QMF_RE(buffer[offset-1][bd])+(1<<(exp-1)))>>exp), ((QMF_RE(buffer[offset-2][bd])+(1<<(exp-1)))>>exp));
+        MUL_R(((QMF_ROW_RE(buffer[len+offset-1], bd)+(1<<(exp-1)))>>exp), ((QMF_ROW_RE(buffer[len+offset-2], bd)+(1<<(exp-1)))>>exp)) +
+        MUL_R(((QMF_ROW_RE(buffer[offset-1], bd)+(1<<(exp-1)))>>exp), ((QMF_ROW_RE(buffer[offset-2], bd)+(1<<(exp-1)))>>exp));
     RE(ac->r22) = r11 -
-        MUL_R(((QMF_RE(buffer[len+offset-2][bd])+(1<<(exp-1)))>>exp), ((QMF_RE(buffer[len+offset-2][bd])+(1<<(exp-1)))>>exp)) +
-        MUL_R(((QMF_RE(buffer[offset-2][bd])+(1<<(exp-1)))>>exp), ((QMF_RE(buffer[offset-2][bd])+(1<<(exp-1)))>>exp));
+        MUL_R(((QMF_ROW_RE(buffer[len+offset-2], bd)+(1<<(exp-1)))>>exp), ((QMF_ROW_RE(buffer[len+offset-2], bd)+(1<<(exp-1)))>>exp)) +
+        MUL_R(((QMF_ROW_RE(buffer[offset-2], bd)+(1<<(exp-1)))>>exp), ((QMF_ROW_RE(buffer[offset-2], bd)+(1<<(exp-1)))>>exp));
 #else
     for (j = offset; j < len + offset; j++)
     {
-        r01 += QMF_RE(buffer[j][bd]) * QMF_RE(buffer[j-1][bd]);
-        r02 += QMF_RE(buffer[j][bd]) * QMF_RE(buffer[j-2][bd]);
-        r11 += QMF_RE(buffer[j-1][bd]) * QMF_RE(buffer[j-1][bd]);
+        r01 += QMF_ROW_RE(buffer[j], bd) * QMF_ROW_RE(buffer[j-1], bd);
+        r02 += QMF_ROW_RE(buffer[j], bd) * QMF_ROW_RE(buffer[j-2], bd);
+        r11 += QMF_ROW_RE(buffer[j-1], bd) * QMF_ROW_RE(buffer[j-1], bd);
     }
     RE(ac->r12) = r01 -
-        QMF_RE(buffer[len+offset-1][bd]) * QMF_RE(buffer[len+offset-2][bd]) +
-        QMF_RE(buffer[offset-1][bd]) * QMF_RE(buffer[offset-2][bd]);
+        QMF_ROW_RE(buffer[len+offset-1], bd) * QMF_ROW_RE(buffer[len+offset-2], bd) +
+        QMF_ROW_RE(buffer[offset-1], bd) * QMF_ROW_RE(buffer[offset-2], bd);
     RE(ac->r22) = r11 -
-        QMF_RE(buffer[len+offset-2][bd]) * QMF_RE(buffer[len+offset-2][bd]) +
-        QMF_RE(buffer[offset-2][bd]) * QMF_RE(buffer[offset-2][bd]);
+        QMF_ROW_RE(buffer[len+offset-2], bd) * QMF_ROW_RE(buffer[len+offset-2], bd) +
+        QMF_ROW_RE(buffer[offset-2], bd) * QMF_ROW_RE(buffer[offset-2], bd);
 #endif
     RE(ac->r01) = r01;
     RE(ac->r02) = r02;
@@ -265,8 +349,8 @@ static void auto_correlation(sbr_info *sbr, acorr_coef *ac,
 
     ac->det = MUL_R(RE(ac->r11), RE(ac->r22)) - MUL_F(MUL_R(RE(ac->r12), RE(ac->r12)), rel);
 }
-#else
-static void auto_correlation(sbr_info *sbr, acorr_coef *ac, qmf_t buffer[MAX_NTSRHFG][64],
+#elif !defined(QMF_SOA)
+static void auto_correlation(sbr_info *sbr, acorr_coef *ac, qmf_row_t buffer[MAX_NTSRHFG],
                              uint8_t bd, uint8_t len)
 {
     real_t r01r = 0, r01i = 0, r02r = 0, r02i = 0, r11r = 0;
@@ -287,9 +371,9 @@ static void auto_correlation(sbr_info *sbr, acorr_coef *ac, qmf_t buffer[MAX_NTS
     for (j = (offset-2); j < (len + offset); j++)
     {
         real_t x;
-        x = QMF_RE(buffer[j][bd])>>REAL_BITS;
+        x = QMF_ROW_RE(buffer[j], bd)>>REAL_BITS;
         mask |= x ^ (x >> 31);
-        x = QMF_IM(buffer[j][bd])>>REAL_BITS;
+        x = QMF_ROW_IM(buffer[j], bd)>>REAL_BITS;
         mask |= x ^ (x >> 31);
     }
 
@@ -301,10 +385,10 @@ static void auto_correlation(sbr_info *sbr, acorr_coef *ac, qmf_t buffer[MAX_NTS
 
     pow2_to_exp = 1<<(exp-1);
 
-    temp2_r = (QMF_RE(buffer[offset-2][bd]) + pow2_to_exp) >> exp;
-    temp2_i = (QMF_IM(buffer[offset-2][bd]) + pow2_to_exp) >> exp;
-    temp3_r = (QMF_RE(buffer[offset-1][bd]) + pow2_to_exp) >> exp;
-    temp3_i = (QMF_IM(buffer[offset-1][bd]) + pow2_to_exp) >> exp;
+    temp2_r = (QMF_ROW_RE(buffer[offset-2], bd) + pow2_to_exp) >> exp;
+    temp2_i = (QMF_ROW_IM(buffer[offset-2], bd) + pow2_to_exp) >> exp;
+    temp3_r = (QMF_ROW_RE(buffer[offset-1], bd) + pow2_to_exp) >> exp;
+    temp3_i = (QMF_ROW_IM(buffer[offset-1], bd) + pow2_to_exp) >> exp;
     // Save these because they are needed after loop
     temp4_r = temp2_r;
     temp4_i = temp2_i;
@@ -317,8 +401,8 @@ static void auto_correlation(sbr_info *sbr, acorr_coef *ac, qmf_t buffer[MAX_NTS
     	temp1_i = temp2_i; // temp1_i = (QMF_IM(buffer[offset-2][bd] + (1<<(exp-1))) >> exp;
     	temp2_r = temp3_r; // temp2_r = (QMF_RE(buffer[offset-1][bd] + (1<<(exp-1))) >> exp;
     	temp2_i = temp3_i; // temp2_i = (QMF_IM(buffer[offset-1][bd] + (1<<(exp-1))) >> exp;
-        temp3_r = (QMF_RE(buffer[j][bd]) + pow2_to_exp) >> exp;
-        temp3_i = (QMF_IM(buffer[j][bd]) + pow2_to_exp) >> exp;
+        temp3_r = (QMF_ROW_RE(buffer[j], bd) + pow2_to_exp) >> exp;
+        temp3_i = (QMF_ROW_IM(buffer[j], bd) + pow2_to_exp) >> exp;
         r01r += MUL_R(temp3_r, temp2_r) + MUL_R(temp3_i, temp2_i);
         r01i += MUL_R(temp3_i, temp2_r) - MUL_R(temp3_r, temp2_i);
         r02r += MUL_R(temp3_r, temp1_r) + MUL_R(temp3_i, temp1_i);
@@ -350,10 +434,10 @@ static void auto_correlation(sbr_info *sbr, acorr_coef *ac, qmf_t buffer[MAX_NTS
 
 #else
 
-    temp2_r = QMF_RE(buffer[offset-2][bd]);
-    temp2_i = QMF_IM(buffer[offset-2][bd]);
-    temp3_r = QMF_RE(buffer[offset-1][bd]);
-    temp3_i = QMF_IM(buffer[offset-1][bd]);
+    temp2_r = QMF_ROW_RE(buffer[offset-2], bd);
+    temp2_i = QMF_ROW_IM(buffer[offset-2], bd);
+    temp3_r = QMF_ROW_RE(buffer[offset-1], bd);
+    temp3_i = QMF_ROW_IM(buffer[offset-1], bd);
     // Save these because they are needed after loop
     temp4_r = temp2_r;
     temp4_i = temp2_i;
@@ -366,8 +450,8 @@ static void auto_correlation(sbr_info *sbr, acorr_coef *ac, qmf_t buffer[MAX_NTS
     	temp1_i = temp2_i; // temp1_i = QMF_IM(buffer[j-2][bd];
     	temp2_r = temp3_r; // temp2_r = QMF_RE(buffer[j-1][bd];
     	temp2_i = temp3_i; // temp2_i = QMF_IM(buffer[j-1][bd];
-        temp3_r = QMF_RE(buffer[j][bd]);
-        temp3_i = QMF_IM(buffer[j][bd]);
+        temp3_r = QMF_ROW_RE(buffer[j], bd);
+        temp3_i = QMF_ROW_IM(buffer[j], bd);
         r01r += temp3_r * temp2_r + temp3_i * temp2_i;
         r01i += temp3_i * temp2_r - temp3_r * temp2_i;
         r02r += temp3_r * temp1_r + temp3_i * temp1_i;
@@ -411,7 +495,8 @@ static void auto_correlation(sbr_info *sbr, acorr_coef *ac, qmf_t buffer[MAX_NTS
 
 /* calculate linear prediction coefficients using the covariance method */
 #ifndef SBR_LOW_POWER
-static void calc_prediction_coef(sbr_info *sbr, qmf_t Xlow[MAX_NTSRHFG][64],
+#ifndef QMF_SOA
+static void calc_prediction_coef(sbr_info *sbr, qmf_row_t Xlow[MAX_NTSRHFG],
                                  complex_t *alpha_0, complex_t *alpha_1, uint8_t k)
 {
     real_t tmp;
@@ -463,7 +548,101 @@ static void calc_prediction_coef(sbr_info *sbr, qmf_t Xlow[MAX_NTSRHFG][64],
     }
 }
 #else
-static void calc_prediction_coef_lp(sbr_info *sbr, qmf_t Xlow[MAX_NTSRHFG][64],
+/* calc_prediction_coef() for bands k to k+3 */
+static void calc_prediction_coef_x4(sbr_info *sbr, qmf_row_t Xlow[MAX_NTSRHFG],
+                                    complex_t *alpha_0, complex_t *alpha_1, uint8_t k)
+{
+    const v4sf zero = v4_set1(0);
+    const v4sf rel = v4_set1(1 / (1 + 1e-6f));
+    const v4sf sixteen = v4_set1(16);
+    v4sf r01r = zero, r01i = zero, r02r = zero, r02i = zero, r11r = zero;
+    v4sf r12r, r12i, r22r, det, tmp, a0_r, a0_i, a1_r, a1_i;
+    v4sf temp1_r, temp1_i, temp2_r, temp2_i, temp3_r, temp3_i, temp4_r, temp4_i, temp5_r, temp5_i;
+    uint8_t offset = sbr->tHFAdj;
+    uint8_t len = sbr->numTimeSlotsRate + 6;
+    int8_t j;
+
+    /* auto_correlation() */
+    temp2_r = temp4_r = v4_load(&QMF_ROW_RE(Xlow[offset-2], k));
+    temp2_i = temp4_i = v4_load(&QMF_ROW_IM(Xlow[offset-2], k));
+    temp3_r = temp5_r = v4_load(&QMF_ROW_RE(Xlow[offset-1], k));
+    temp3_i = temp5_i = v4_load(&QMF_ROW_IM(Xlow[offset-1], k));
+
+    for (j = offset; j < len + offset; j++)
+    {
+        temp1_r = temp2_r;
+        temp1_i = temp2_i;
+        temp2_r = temp3_r;
+        temp2_i = temp3_i;
+        temp3_r = v4_load(&QMF_ROW_RE(Xlow[j], k));
+        temp3_i = v4_load(&QMF_ROW_IM(Xlow[j], k));
+        r01r = v4_add(r01r, v4_add(v4_mul(temp3_r, temp2_r), v4_mul(temp3_i, temp2_i)));
+        r01i = v4_add(r01i, v4_sub(v4_mul(temp3_i, temp2_r), v4_mul(temp3_r, temp2_i)));
+        r02r = v4_add(r02r, v4_add(v4_mul(temp3_r, temp1_r), v4_mul(temp3_i, temp1_i)));
+        r02i = v4_add(r02i, v4_sub(v4_mul(temp3_i, temp1_r), v4_mul(temp3_r, temp1_i)));
+        r11r = v4_add(r11r, v4_add(v4_mul(temp2_r, temp2_r), v4_mul(temp2_i, temp2_i)));
+    }
+
+    r12r = v4_add(v4_sub(r01r,
+        v4_add(v4_mul(temp3_r, temp2_r), v4_mul(temp3_i, temp2_i))),
+        v4_add(v4_mul(temp5_r, temp4_r), v4_mul(temp5_i, temp4_i)));
+    r12i = v4_add(v4_sub(r01i,
+        v4_sub(v4_mul(temp3_i, temp2_r), v4_mul(temp3_r, temp2_i))),
+        v4_sub(v4_mul(temp5_i, temp4_r), v4_mul(temp5_r, temp4_i)));
+    r22r = v4_add(v4_sub(r11r,
+        v4_add(v4_mul(temp2_r, temp2_r), v4_mul(temp2_i, temp2_i))),
+        v4_add(v4_mul(temp4_r, temp4_r), v4_mul(temp4_i, temp4_i)));
+
+    det = v4_sub(v4_mul(r11r, r22r),
+        v4_mul(rel, v4_add(v4_mul(r12r, r12r), v4_mul(r12i, r12i))));
+
+    /* lanes with a zero divisor are cleared after the division */
+    tmp = v4_div(v4_set1(1.0f), det);
+    a1_r = v4_mul(v4_sub(v4_sub(v4_mul(r01r, r12r), v4_mul(r01i, r12i)), v4_mul(r02r, r11r)), tmp);
+    a1_i = v4_mul(v4_sub(v4_add(v4_mul(r01i, r12r), v4_mul(r01r, r12i)), v4_mul(r02i, r11r)), tmp);
+    a1_r = v4_sel_eq(det, zero, zero, a1_r);
+    a1_i = v4_sel_eq(det, zero, zero, a1_i);
+
+    tmp = v4_div(v4_set1(1.0f), r11r);
+    a0_r = v4_mul(v4_neg(v4_add(v4_add(r01r, v4_mul(a1_r, r12r)), v4_mul(a1_i, r12i))), tmp);
+    a0_i = v4_mul(v4_neg(v4_sub(v4_add(r01i, v4_mul(a1_i, r12r)), v4_mul(a1_r, r12i))), tmp);
+    a0_r = v4_sel_eq(r11r, zero, zero, a0_r);
+    a0_i = v4_sel_eq(r11r, zero, zero, a0_i);
+
+    tmp = v4_sel_ge(v4_add(v4_mul(a0_r, a0_r), v4_mul(a0_i, a0_i)), sixteen, zero,
+        v4_sel_ge(v4_add(v4_mul(a1_r, a1_r), v4_mul(a1_i, a1_i)), sixteen, zero, v4_set1(1.0f)));
+    a0_r = v4_sel_eq(tmp, zero, zero, a0_r);
+    a0_i = v4_sel_eq(tmp, zero, zero, a0_i);
+    a1_r = v4_sel_eq(tmp, zero, zero, a1_r);
+    a1_i = v4_sel_eq(tmp, zero, zero, a1_i);
+
+    v4_store(alpha_0[k], v4_zip_lo(a0_r, a0_i));
+    v4_store(alpha_0[k + 2], v4_zip_hi(a0_r, a0_i));
+    v4_store(alpha_1[k], v4_zip_lo(a1_r, a1_i));
+    v4_store(alpha_1[k + 2], v4_zip_hi(a1_r, a1_i));
+}
+#endif
+
+/* the prediction coefficients only depend on the source band, so they are
+   calculated once per frame for every band that is patched with filtering */
+static void get_prediction_coef(sbr_info *sbr, qmf_row_t Xlow[MAX_NTSRHFG],
+                                complex_t *alpha_0, complex_t *alpha_1,
+                                uint64_t *have_coef, uint8_t k)
+{
+    if ((*have_coef >> k) & 1)
+        return;
+
+#ifdef QMF_SOA
+    k &= ~3;
+    calc_prediction_coef_x4(sbr, Xlow, alpha_0, alpha_1, k);
+    *have_coef |= (uint64_t)0xF << k;
+#else
+    calc_prediction_coef(sbr, Xlow, alpha_0, alpha_1, k);
+    *have_coef |= (uint64_t)1 << k;
+#endif
+}
+#else
+static void calc_prediction_coef_lp(sbr_info *sbr, qmf_row_t Xlow[MAX_NTSRHFG],
                                     complex_t *alpha_0, complex_t *alpha_1, real_t *rxx)
 {
     uint8_t k;
@@ -35,8 +35,8 @@
 extern "C" {
 #endif
 
-void hf_generation(sbr_info *sbr, qmf_t Xlow[MAX_NTSRHFG][64],
-                   qmf_t Xhigh[MAX_NTSRHFG][64]
+void hf_generation(sbr_info *sbr, qmf_row_t Xlow[MAX_NTSRHFG],
+                   qmf_row_t Xhigh[MAX_NTSRHFG]
 #ifdef SBR_LOW_POWER
                    ,real_t *deg
 #endif
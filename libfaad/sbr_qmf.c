@@ -40,6 +40,119 @@
 #include "sbr_qmf.h"
 #include "sbr_qmf_c.h"
 #include "sbr_syntax.h"
+#include "simd.h"
+
+/* window and sum of the ten polyphase taps; the qmf_c taps of the 32 band
+   banks are every other coefficient, deinterleaved with v4_even() */
+
+/* analysis: u[n] from the five taps of x, which points at x_index */
+static void qmfa_window_32(real_t *u, const real_t *x)
+{
+    int16_t n;
+
+#ifdef SIMD_V4
+    for (n = 0; n < 64; n += 4)
+    {
+        v4sf s;
+        uint16_t j;
+
+        s = v4_mul(v4_load(&x[n]), v4_even(v4_load(&qmf_c[2*n]), v4_load(&qmf_c[2*n + 4])));
+        for (j = 64; j < 320; j += 64)
+        {
+            s = v4_add(s, v4_mul(v4_load(&x[n + j]),
+                v4_even(v4_load(&qmf_c[2*(n + j)]), v4_load(&qmf_c[2*(n + j) + 4]))));
+        }
+        v4_store(&u[n], s);
+    }
+#else
+    for (n = 0; n < 64; n++)
+    {
+        u[n] = MUL_F(x[n], qmf_c[2*n]) +
+            MUL_F(x[n + 64], qmf_c[2*(n + 64)]) +
+            MUL_F(x[n + 128], qmf_c[2*(n + 128)]) +
+            MUL_F(x[n + 192], qmf_c[2*(n + 192)]) +
+            MUL_F(x[n + 256], qmf_c[2*(n + 256)]);
+    }
+#endif
+}
+
+/* synthesis: 32 output samples, v points at v_index */
+static void qmfs_window_32(real_t *output, const real_t *v)
+{
+    int32_t k;
+
+#ifdef SIMD_V4
+    for (k = 0; k < 32; k += 4)
+    {
+        v4sf s;
+        uint16_t j;
+
+        s = v4_mul(v4_load(&v[k]), v4_even(v4_load(&qmf_c[2*k]), v4_load(&qmf_c[2*k + 4])));
+        for (j = 1; j < 10; j++)
+        {
+            /* taps at 0, 96, 128, 224, ... */
+            uint16_t t = 128*(j >> 1) + 96*(j & 1);
+
+            s = v4_add(s, v4_mul(v4_load(&v[t + k]),
+                v4_even(v4_load(&qmf_c[64*j + 2*k]), v4_load(&qmf_c[64*j + 2*k + 4]))));
+        }
+        v4_store(&output[k], s);
+    }
+#else
+    for (k = 0; k < 32; k++)
+    {
+        output[k] = MUL_F(v[k], qmf_c[2*k]) +
+            MUL_F(v[96 + k], qmf_c[64 + 2*k]) +
+            MUL_F(v[128 + k], qmf_c[128 + 2*k]) +
+            MUL_F(v[224 + k], qmf_c[192 + 2*k]) +
+            MUL_F(v[256 + k], qmf_c[256 + 2*k]) +
+            MUL_F(v[352 + k], qmf_c[320 + 2*k]) +
+            MUL_F(v[384 + k], qmf_c[384 + 2*k]) +
+            MUL_F(v[480 + k], qmf_c[448 + 2*k]) +
+            MUL_F(v[512 + k], qmf_c[512 + 2*k]) +
+            MUL_F(v[608 + k], qmf_c[576 + 2*k]);
+    }
+#endif
+}
+
+/* synthesis: 64 output samples, v points at v_index */
+static void qmfs_window_64(real_t *output, const real_t *v)
+{
+    int32_t k;
+
+#ifdef SIMD_V4
+    for (k = 0; k < 64; k += 4)
+    {
+        v4sf s;
+        uint16_t j;
+
+        s = v4_mul(v4_load(&v[k]), v4_load(&qmf_c[k]));
+        for (j = 1; j < 10; j++)
+        {
+            /* taps at 0, 192, 256, 448, ... */
+            uint16_t t = 256*(j >> 1) + 192*(j & 1);
+
+            s = v4_add(s, v4_mul(v4_load(&v[t + k]), v4_load(&qmf_c[64*j + k])));
+        }
+        v4_store(&output[k], s);
+    }
+#else
+    for (k = 0; k < 64; k++)
+    {
+        output[k] =
+            MUL_F(v[k+0],          qmf_c[k+0])   +
+            MUL_F(v[k+192],        qmf_c[k+64])  +
+            MUL_F(v[k+256],        qmf_c[k+128]) +
+            MUL_F(v[k+(256+192)],  qmf_c[k+192]) +
+            MUL_F(v[k+512],        qmf_c[k+256]) +
+            MUL_F(v[k+(512+192)],  qmf_c[k+320]) +
+            MUL_F(v[k+768],        qmf_c[k+384]) +
+            MUL_F(v[k+(768+192)],  qmf_c[k+448]) +
+            MUL_F(v[k+1024],       qmf_c[k+512]) +
+            MUL_F(v[k+(1024+192)], qmf_c[k+576]);
+    }
+#endif
+}
 
 qmfa_info *qmfa_init(uint8_t channels)
 {
@@ -67,7 +180,7 @@ void qmfa_end(qmfa_info *qmfa)
 }
 
 void sbr_qmf_analysis_32(sbr_info *sbr, qmfa_info *qmfa, const real_t *input,
-                         qmf_t X[MAX_NTSRHFG][64], uint8_t offset, uint8_t kx)
+                         qmf_row_t X[MAX_NTSRHFG], uint8_t offset, uint8_t kx)
 {
     ALIGN real_t u[64];
 #ifndef SBR_LOW_POWER
@@ -88,6 +201,16 @@ void sbr_qmf_analysis_32(sbr_info *sbr, qmfa_info *qmfa, const real_t *input,
         //memmove(qmfa->x + 32, qmfa->x, (320-32)*sizeof(real_t));
 
         /* add new samples to input buffer x */
+#ifdef SIMD_V4
+        for (n = 32 - 4; n >= 0; n -= 4)
+        {
+            v4sf t = v4_reverse(v4_load(&input[in]));
+
+            v4_store(&qmfa->x[qmfa->x_index + n], t);
+            v4_store(&qmfa->x[qmfa->x_index + n + 320], t);
+            in += 4;
+        }
+#else
         for (n = 32 - 1; n >= 0; n--)
         {
 #ifdef FIXED_POINT
@@ -96,16 +219,10 @@ void sbr_qmf_analysis_32(sbr_info *sbr, qmfa_info *qmfa, const real_t *input,
             qmfa->x[qmfa->x_index + n] = qmfa->x[qmfa->x_index + n + 320] = input[in++];
 #endif
         }
+#endif
 
         /* window and summation to create array u */
-        for (n = 0; n < 64; n++)
-        {
-            u[n] = MUL_F(qmfa->x[qmfa->x_index + n], qmf_c[2*n]) +
-                MUL_F(qmfa->x[qmfa->x_index + n + 64], qmf_c[2*(n + 64)]) +
-                MUL_F(qmfa->x[qmfa->x_index + n + 128], qmf_c[2*(n + 128)]) +
-                MUL_F(qmfa->x[qmfa->x_index + n + 192], qmf_c[2*(n + 192)]) +
-                MUL_F(qmfa->x[qmfa->x_index + n + 256], qmf_c[2*(n + 256)]);
-        }
+        qmfa_window_32(u, qmfa->x + qmfa->x_index);
 
 		/* update ringbuffer index */
 		qmfa->x_index -= 32;
@@ -127,12 +244,12 @@ void sbr_qmf_analysis_32(sbr_info *sbr, qmfa_info *qmfa, const real_t *input,
             if (n < kx)
             {
 #ifdef FIXED_POINT
-                QMF_RE(X[l + offset][n]) = u[n] /*<< 1*/;
+                QMF_ROW_RE(X[l + offset], n) = u[n] /*<< 1*/;
 #else
-                QMF_RE(X[l + offset][n]) = 2. * u[n];
+                QMF_ROW_RE(X[l + offset], n) = 2. * u[n];
 #endif
             } else {
-                QMF_RE(X[l + offset][n]) = 0;
+                QMF_ROW_RE(X[l + offset], n) = 0;
             }
         }
 #else
@@ -152,37 +269,58 @@ void sbr_qmf_analysis_32(sbr_info *sbr, qmfa_info *qmfa, const real_t *input,
         dct4_kernel(in_real, in_imag, out_real, out_imag);
 
         // Reordering of data moved from DCT_IV to here
+#ifdef QMF_SOA
+        for (n = 0; n < 16; n += 4)
+        {
+            const v4sf two = v4_set1(2.f), mtwo = v4_set1(-2.f);
+            v4sf a = v4_mul(two, v4_load(&out_real[n]));
+            v4sf b = v4_mul(mtwo, v4_reverse(v4_load(&out_imag[28 - n])));
+            v4sf c = v4_mul(two, v4_load(&out_imag[n]));
+            v4sf d = v4_mul(mtwo, v4_reverse(v4_load(&out_real[28 - n])));
+
+            v4_store(&QMF_ROW_RE(X[l + offset], 2*n), v4_zip_lo(a, b));
+            v4_store(&QMF_ROW_RE(X[l + offset], 2*n+4), v4_zip_hi(a, b));
+            v4_store(&QMF_ROW_IM(X[l + offset], 2*n), v4_zip_lo(c, d));
+            v4_store(&QMF_ROW_IM(X[l + offset], 2*n+4), v4_zip_hi(c, d));
+        }
+        for (n = kx; n < 32; n++)
+        {
+            QMF_ROW_RE(X[l + offset], n) = 0;
+            QMF_ROW_IM(X[l + offset], n) = 0;
+        }
+#else
         for (n = 0; n < 16; n++) {
             if (2*n+1 < kx) {
 #ifdef FIXED_POINT
-                QMF_RE(X[l + offset][2*n])   = out_real[n];
-                QMF_IM(X[l + offset][2*n])   = out_imag[n];
-                QMF_RE(X[l + offset][2*n+1]) = -out_imag[31-n];
-                QMF_IM(X[l + offset][2*n+1]) = -out_real[31-n];
+                QMF_ROW_RE(X[l + offset], 2*n)   = out_real[n];
+                QMF_ROW_IM(X[l + offset], 2*n)   = out_imag[n];
+                QMF_ROW_RE(X[l + offset], 2*n+1) = -out_imag[31-n];
+                QMF_ROW_IM(X[l + offset], 2*n+1) = -out_real[31-n];
 #else
-                QMF_RE(X[l + offset][2*n])   = 2. * out_real[n];
-                QMF_IM(X[l + offset][2*n])   = 2. * out_imag[n];
-                QMF_RE(X[l + offset][2*n+1]) = -2. * out_imag[31-n];
-                QMF_IM(X[l + offset][2*n+1]) = -2. * out_real[31-n];
+                QMF_ROW_RE(X[l + offset], 2*n)   = 2. * out_real[n];
+                QMF_ROW_IM(X[l + offset], 2*n)   = 2. * out_imag[n];
+                QMF_ROW_RE(X[l + offset], 2*n+1) = -2. * out_imag[31-n];
+                QMF_ROW_IM(X[l + offset], 2*n+1) = -2. * out_real[31-n];
 #endif
             } else {
                 if (2*n < kx) {
 #ifdef FIXED_POINT
-                    QMF_RE(X[l + offset][2*n])   = out_real[n];
-                    QMF_IM(X[l + offset][2*n])   = out_imag[n];
+                    QMF_ROW_RE(X[l + offset], 2*n)   = out_real[n];
+                    QMF_ROW_IM(X[l + offset], 2*n)   = out_imag[n];
 #else
-                    QMF_RE(X[l + offset][2*n])   = 2. * out_real[n];
-                    QMF_IM(X[l + offset][2*n])   = 2. * out_imag[n];
+                    QMF_ROW_RE(X[l + offset], 2*n)   = 2. * out_real[n];
+                    QMF_ROW_IM(X[l + offset], 2*n)   = 2. * out_imag[n];
 #endif
                 }
                 else {
-                    QMF_RE(X[l + offset][2*n]) = 0;
-                    QMF_IM(X[l + offset][2*n]) = 0;
+                    QMF_ROW_RE(X[l + offset], 2*n) = 0;
+                    QMF_ROW_IM(X[l + offset], 2*n) = 0;
                 }
-                QMF_RE(X[l + offset][2*n+1]) = 0;
-                QMF_IM(X[l + offset][2*n+1]) = 0;
+                QMF_ROW_RE(X[l + offset], 2*n+1) = 0;
+                QMF_ROW_IM(X[l + offset], 2*n+1) = 0;
             }
         }
+#endif
 #endif
     }
 }
@@ -249,7 +387,7 @@ void qmfs_end(qmfs_info *qmfs)
 
 #ifdef SBR_LOW_POWER
 
-void sbr_qmf_synthesis_32(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][64],
+void sbr_qmf_synthesis_32(sbr_info *sbr, qmfs_info *qmfs, qmf_row_t X[MAX_NTSRHFG],
                           real_t *output)
 {
     ALIGN real_t x[16];
@@ -268,11 +406,11 @@ void sbr_qmf_synthesis_32(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][6
         for (k = 0; k < 16; k++)
         {
 #ifdef FIXED_POINT
-            y[k] = (QMF_RE(X[l][k]) - QMF_RE(X[l][31 - k]));
-            x[k] = (QMF_RE(X[l][k]) + QMF_RE(X[l][31 - k]));
+            y[k] = (QMF_ROW_RE(X[l], k) - QMF_ROW_RE(X[l], 31 - k));
+            x[k] = (QMF_ROW_RE(X[l], k) + QMF_ROW_RE(X[l], 31 - k));
 #else
-            y[k] = (QMF_RE(X[l][k]) - QMF_RE(X[l][31 - k])) / 32.0;
-            x[k] = (QMF_RE(X[l][k]) + QMF_RE(X[l][31 - k])) / 32.0;
+            y[k] = (QMF_ROW_RE(X[l], k) - QMF_ROW_RE(X[l], 31 - k)) / 32.0;
+            x[k] = (QMF_ROW_RE(X[l], k) + QMF_ROW_RE(X[l], 31 - k)) / 32.0;
 #endif
         }
 
@@ -297,19 +435,8 @@ void sbr_qmf_synthesis_32(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][6
         }
 
         /* calculate 32 output samples and window */
-        for (k = 0; k < 32; k++)
-        {
-            output[out++] = MUL_F(qmfs->v[qmfs->v_index + k], qmf_c[2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 96 + k], qmf_c[64 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 128 + k], qmf_c[128 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 224 + k], qmf_c[192 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 256 + k], qmf_c[256 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 352 + k], qmf_c[320 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 384 + k], qmf_c[384 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 480 + k], qmf_c[448 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 512 + k], qmf_c[512 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 608 + k], qmf_c[576 + 2*k]);
-        }
+        qmfs_window_32(output + out, qmfs->v + qmfs->v_index);
+        out += 32;
 
         /* update the ringbuffer index */
         qmfs->v_index -= 64;
@@ -318,7 +445,7 @@ void sbr_qmf_synthesis_32(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][6
     }
 }
 
-void sbr_qmf_synthesis_64(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][64],
+void sbr_qmf_synthesis_64(sbr_info *sbr, qmfs_info *qmfs, qmf_row_t X[MAX_NTSRHFG],
                           real_t *output)
 {
     ALIGN real_t x[64];
@@ -338,11 +465,11 @@ void sbr_qmf_synthesis_64(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][6
         for (k = 0; k < 32; k++)
         {
 #ifdef FIXED_POINT
-            y[k] = (QMF_RE(X[l][k]) - QMF_RE(X[l][63 - k]));
-            x[k] = (QMF_RE(X[l][k]) + QMF_RE(X[l][63 - k]));
+            y[k] = (QMF_ROW_RE(X[l], k) - QMF_ROW_RE(X[l], 63 - k));
+            x[k] = (QMF_ROW_RE(X[l], k) + QMF_ROW_RE(X[l], 63 - k));
 #else
-            y[k] = (QMF_RE(X[l][k]) - QMF_RE(X[l][63 - k])) / 32.0;
-            x[k] = (QMF_RE(X[l][k]) + QMF_RE(X[l][63 - k])) / 32.0;
+            y[k] = (QMF_ROW_RE(X[l], k) - QMF_ROW_RE(X[l], 63 - k)) / 32.0;
+            x[k] = (QMF_ROW_RE(X[l], k) + QMF_ROW_RE(X[l], 63 - k)) / 32.0;
 #endif
         }
 
@@ -367,19 +494,8 @@ void sbr_qmf_synthesis_64(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][6
         }
 
         /* calculate 64 output samples and window */
-        for (k = 0; k < 64; k++)
-        {
-            output[out++] = MUL_F(qmfs->v[qmfs->v_index + k], qmf_c[k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 192 + k], qmf_c[64 + k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 256 + k], qmf_c[128 + k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 256 + 192 + k], qmf_c[128 + 64 + k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 512 + k], qmf_c[256 + k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 512 + 192 + k], qmf_c[256 + 64 + k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 768 + k], qmf_c[384 + k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 768 + 192 + k], qmf_c[384 + 64 + k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 1024 + k], qmf_c[512 + k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 1024 + 192 + k], qmf_c[512 + 64 + k]);
-        }
+        qmfs_window_64(output + out, qmfs->v + qmfs->v_index);
+        out += 64;
 
         /* update the ringbuffer index */
         qmfs->v_index -= 128;
@@ -388,7 +504,7 @@ void sbr_qmf_synthesis_64(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][6
     }
 }
 #else
-void sbr_qmf_synthesis_32(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][64],
+void sbr_qmf_synthesis_32(sbr_info *sbr, qmfs_info *qmfs, qmf_row_t X[MAX_NTSRHFG],
                           real_t *output)
 {
     ALIGN real_t x1[32], x2[32];
@@ -408,10 +524,32 @@ void sbr_qmf_synthesis_32(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][6
 
         /* calculate 64 samples */
         /* complex pre-twiddle */
+#ifdef SIMD_V4
+        for (k = 0; k < 32; k += 4)
+        {
+            const real_t *px = &QMF_ROW_RE(X[l], k);
+            const real_t *pt = &RE(qmf32_pre_twiddle[k]);
+            const v4sf vscale = v4_set1(scale);
+            v4sf x_re, x_im, t_re, t_im;
+
+#ifdef QMF_SOA
+            x_re = v4_load(px);
+            x_im = v4_load(px + 64);
+#else
+            x_re = v4_even(v4_load(px), v4_load(px + 4));
+            x_im = v4_odd(v4_load(px), v4_load(px + 4));
+#endif
+            t_re = v4_even(v4_load(pt), v4_load(pt + 4));
+            t_im = v4_odd(v4_load(pt), v4_load(pt + 4));
+
+            v4_store(&x1[k], v4_mul(v4_sub(v4_mul(x_re, t_re), v4_mul(x_im, t_im)), vscale));
+            v4_store(&x2[k], v4_mul(v4_add(v4_mul(x_im, t_re), v4_mul(x_re, t_im)), vscale));
+        }
+#else
         for (k = 0; k < 32; k++)
         {
-            x1[k] = MUL_F(QMF_RE(X[l][k]), RE(qmf32_pre_twiddle[k])) - MUL_F(QMF_IM(X[l][k]), IM(qmf32_pre_twiddle[k]));
-            x2[k] = MUL_F(QMF_IM(X[l][k]), RE(qmf32_pre_twiddle[k])) + MUL_F(QMF_RE(X[l][k]), IM(qmf32_pre_twiddle[k]));
+            x1[k] = MUL_F(QMF_ROW_RE(X[l], k), RE(qmf32_pre_twiddle[k])) - MUL_F(QMF_ROW_IM(X[l], k), IM(qmf32_pre_twiddle[k]));
+            x2[k] = MUL_F(QMF_ROW_IM(X[l], k), RE(qmf32_pre_twiddle[k])) + MUL_F(QMF_ROW_RE(X[l], k), IM(qmf32_pre_twiddle[k]));
 
 #ifndef FIXED_POINT
             x1[k] *= scale;
@@ -421,31 +559,37 @@ void sbr_qmf_synthesis_32(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][6
             x2[k] >>= 1;
 #endif
         }
+#endif
 
         /* transform */
         DCT4_32(x1, x1);
         DST4_32(x2, x2);
 
+#ifdef SIMD_V4
+        for (n = 0; n < 32; n += 4)
+        {
+            real_t *v = qmfs->v + qmfs->v_index;
+            v4sf a = v4_load(&x1[n]), b = v4_load(&x2[n]);
+            v4sf t;
+
+            t = v4_add(v4_neg(a), b);
+            v4_store(&v[n], t);
+            v4_store(&v[640 + n], t);
+            t = v4_reverse(v4_add(a, b));
+            v4_store(&v[60 - n], t);
+            v4_store(&v[640 + 60 - n], t);
+        }
+#else
         for (n = 0; n < 32; n++)
         {
             qmfs->v[qmfs->v_index + n]      = qmfs->v[qmfs->v_index + 640 + n]      = -x1[n] + x2[n];
             qmfs->v[qmfs->v_index + 63 - n] = qmfs->v[qmfs->v_index + 640 + 63 - n] =  x1[n] + x2[n];
         }
+#endif
 
         /* calculate 32 output samples and window */
-        for (k = 0; k < 32; k++)
-        {
-            output[out++] = MUL_F(qmfs->v[qmfs->v_index + k], qmf_c[2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 96 + k], qmf_c[64 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 128 + k], qmf_c[128 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 224 + k], qmf_c[192 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 256 + k], qmf_c[256 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 352 + k], qmf_c[320 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 384 + k], qmf_c[384 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 480 + k], qmf_c[448 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 512 + k], qmf_c[512 + 2*k]) +
-                MUL_F(qmfs->v[qmfs->v_index + 608 + k], qmf_c[576 + 2*k]);
-        }
+        qmfs_window_32(output + out, qmfs->v + qmfs->v_index);
+        out += 32;
 
         /* update ringbuffer index */
         qmfs->v_index -= 64;
@@ -454,7 +598,7 @@ void sbr_qmf_synthesis_32(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][6
     }
 }
 
-void sbr_qmf_synthesis_64(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][64],
+void sbr_qmf_synthesis_64(sbr_info *sbr, qmfs_info *qmfs, qmf_row_t X[MAX_NTSRHFG],
                           real_t *output)
 {
 //    ALIGN real_t x1[64], x2[64];
@@ -462,7 +606,6 @@ void sbr_qmf_synthesis_64(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][6
     ALIGN real_t in_real1[32], in_imag1[32], out_real1[32], out_imag1[32];
     ALIGN real_t in_real2[32], in_imag2[32], out_real2[32], out_imag2[32];
 #endif
-    qmf_t * pX;
     real_t * pring_buffer_1, * pring_buffer_3;
 //    real_t * ptemp_1, * ptemp_2;
 #ifdef PREFER_POINTERS
@@ -492,43 +635,67 @@ void sbr_qmf_synthesis_64(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][6
         /* calculate 128 samples */
 #ifndef FIXED_POINT
 
-        pX = X[l];
+#ifdef SIMD_V4
+        /* 8 subbands at a time, deinterleaved into even and odd ones */
+        for (k = 0; k < 32; k += 4)
+        {
+            const real_t *p1 = &QMF_ROW_RE(X[l], 2*k);
+            const real_t *p2 = &QMF_ROW_IM(X[l], 56 - 2*k);
+            const v4sf vscale = v4_set1(scale);
+            v4sf r0, r1, i0, i1;
+
+#ifdef QMF_SOA
+            r0 = v4_load(p1);
+            r1 = v4_load(p1 + 4);
+            i0 = v4_load(p2);
+            i1 = v4_load(p2 + 4);
+#else
+            r0 = v4_even(v4_load(p1), v4_load(p1 + 4));
+            r1 = v4_even(v4_load(p1 + 8), v4_load(p1 + 12));
+            i0 = v4_odd(v4_load(p2 - 1), v4_load(p2 + 3));
+            i1 = v4_odd(v4_load(p2 + 7), v4_load(p2 + 11));
+#endif
 
-        in_imag1[31] = scale*QMF_RE(pX[1]);
-        in_real1[0]  = scale*QMF_RE(pX[0]);
-        in_imag2[31] = scale*QMF_IM(pX[63-1]);
-        in_real2[0]  = scale*QMF_IM(pX[63-0]);
+            v4_store(&in_real1[k], v4_mul(vscale, v4_even(r0, r1)));
+            v4_store(&in_imag1[28 - k], v4_mul(vscale, v4_reverse(v4_odd(r0, r1))));
+            v4_store(&in_real2[k], v4_mul(vscale, v4_reverse(v4_odd(i0, i1))));
+            v4_store(&in_imag2[28 - k], v4_mul(vscale, v4_even(i0, i1)));
+        }
+#else
+        in_imag1[31] = scale*QMF_ROW_RE(X[l], 1);
+        in_real1[0]  = scale*QMF_ROW_RE(X[l], 0);
+        in_imag2[31] = scale*QMF_ROW_IM(X[l], 63-1);
+        in_real2[0]  = scale*QMF_ROW_IM(X[l], 63-0);
         for (k = 1; k < 31; k++)
         {
-            in_imag1[31 - k] = scale*QMF_RE(pX[2*k + 1]);
-            in_real1[     k] = scale*QMF_RE(pX[2*k    ]);
-            in_imag2[31 - k] = scale*QMF_IM(pX[63 - (2*k + 1)]);
-            in_real2[     k] = scale*QMF_IM(pX[63 - (2*k    )]);
+            in_imag1[31 - k] = scale*QMF_ROW_RE(X[l], 2*k + 1);
+            in_real1[     k] = scale*QMF_ROW_RE(X[l], 2*k    );
+            in_imag2[31 - k] = scale*QMF_ROW_IM(X[l], 63 - (2*k + 1));
+            in_real2[     k] = scale*QMF_ROW_IM(X[l], 63 - (2*k    ));
         }
-        in_imag1[0]  = scale*QMF_RE(pX[63]);
-        in_real1[31] = scale*QMF_RE(pX[62]);
-        in_imag2[0]  = scale*QMF_IM(pX[63-63]);
-        in_real2[31] = scale*QMF_IM(pX[63-62]);
+        in_imag1[0]  = scale*QMF_ROW_RE(X[l], 63);
+        in_real1[31] = scale*QMF_ROW_RE(X[l], 62);
+        in_imag2[0]  = scale*QMF_ROW_IM(X[l], 63-63);
+        in_real2[31] = scale*QMF_ROW_IM(X[l], 63-62);
+#endif
 
 #else
 
-        pX = X[l];
-
-        in_imag1[31] = QMF_RE(pX[1]) >> 1;
-        in_real1[0]  = QMF_RE(pX[0]) >> 1;
-        in_imag2[31] = QMF_IM(pX[62]) >> 1;
-        in_real2[0]  = QMF_IM(pX[63]) >> 1;
+        in_imag1[31] = QMF_ROW_RE(X[l], 1) >> 1;
+        in_real1[0]  = QMF_ROW_RE(X[l], 0) >> 1;
+        in_imag2[31] = QMF_ROW_IM(X[l], 62) >> 1;
+        in_real2[0]  = QMF_ROW_IM(X[l], 63) >> 1;
         for (k = 1; k < 31; k++)
         {
-            in_imag1[31 - k] = QMF_RE(pX[2*k + 1]) >> 1;
-            in_real1[     k] = QMF_RE(pX[2*k    ]) >> 1;
-            in_imag2[31 - k] = QMF_IM(pX[63 - (2*k + 1)]) >> 1;
-            in_real2[     k] = QMF_IM(pX[63 - (2*k    )]) >> 1;
+            in_imag1[31 - k] = QMF_ROW_RE(X[l], 2*k + 1) >> 1;
+            in_real1[     k] = QMF_ROW_RE(X[l], 2*k    ) >> 1;
+            in_imag2[31 - k] = QMF_ROW_IM(X[l], 63 - (2*k + 1)) >> 1;
+            in_real2[     k] = QMF_ROW_IM(X[l], 63 - (2*k    )) >> 1;
         }
-        in_imag1[0]  = QMF_RE(pX[63]) >> 1;
-        in_real1[31] = QMF_RE(pX[62]) >> 1;
-        in_imag2[0]  = QMF_IM(pX[0]) >> 1;
-        in_real2[31] = QMF_IM(pX[1]) >> 1;
+        in_imag1[0]  = QMF_ROW_RE(X[l], 63) >> 1;
+        in_real1[31] = QMF_ROW_RE(X[l], 62) >> 1;
+        in_imag2[0]  = QMF_ROW_IM(X[l], 0) >> 1;
+        in_real2[31] = QMF_ROW_IM(X[l], 1) >> 1;
 
 #endif
 
@@ -559,6 +726,33 @@ void sbr_qmf_synthesis_64(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][6
             *pring_buffer_1++ = *pring_buffer_3++ = out_imag2[31-n] + out_imag1[31-n];
             *pring_buffer_2-- = *pring_buffer_4-- = out_imag2[31-n] - out_imag1[31-n];
         }
+#elif defined(SIMD_V4)
+
+        for (n = 0; n < 32; n += 4)
+        {
+            v4sf re1 = v4_load(&out_real1[n]), re2 = v4_load(&out_real2[n]);
+            v4sf im1 = v4_load(&out_imag1[28-n]), im2 = v4_load(&out_imag2[28-n]);
+            v4sf a = v4_sub(re2, re1);
+            v4sf b = v4_reverse(v4_add(im2, im1));
+            v4sf c = v4_add(re2, re1);
+            v4sf d = v4_reverse(v4_sub(im2, im1));
+            v4sf t;
+
+            /* [2*n], [2*n+1] ascending, [127-2*n], [127-(2*n+1)] descending */
+            t = v4_zip_lo(a, b);
+            v4_store(&pring_buffer_1[2*n], t);
+            v4_store(&pring_buffer_3[2*n], t);
+            t = v4_zip_hi(a, b);
+            v4_store(&pring_buffer_1[2*n+4], t);
+            v4_store(&pring_buffer_3[2*n+4], t);
+            t = v4_reverse(v4_zip_lo(c, d));
+            v4_store(&pring_buffer_1[124-2*n], t);
+            v4_store(&pring_buffer_3[124-2*n], t);
+            t = v4_reverse(v4_zip_hi(c, d));
+            v4_store(&pring_buffer_1[120-2*n], t);
+            v4_store(&pring_buffer_3[120-2*n], t);
+        }
+
 #else // #ifdef PREFER_POINTERS
 
         for (n = 0; n < 32; n++)
@@ -596,9 +790,9 @@ void sbr_qmf_synthesis_64(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][6
 #endif // #ifdef PREFER_POINTERS
 
         /* calculate 64 output samples and window */
+#ifdef PREFER_POINTERS
         for (k = 0; k < 64; k++)
         {
-#ifdef PREFER_POINTERS
             output[out++] =
                 MUL_F(*pring_buffer_1++,  *pqmf_c_1++) +
                 MUL_F(*pring_buffer_2++,  *pqmf_c_2++) +
@@ -610,20 +804,11 @@ void sbr_qmf_synthesis_64(sbr_info *sbr, qmfs_info *qmfs, qmf_t X[MAX_NTSRHFG][6
                 MUL_F(*pring_buffer_8++,  *pqmf_c_8++) +
                 MUL_F(*pring_buffer_9++,  *pqmf_c_9++) +
                 MUL_F(*pring_buffer_10++, *pqmf_c_10++);
+        }
 #else // #ifdef PREFER_POINTERS
-            output[out++] =
-                MUL_F(pring_buffer_1[k+0],          qmf_c[k+0])   +
-                MUL_F(pring_buffer_1[k+192],        qmf_c[k+64])  +
-                MUL_F(pring_buffer_1[k+256],        qmf_c[k+128]) +
-                MUL_F(pring_buffer_1[k+(256+192)],  qmf_c[k+192]) +
-                MUL_F(pring_buffer_1[k+512],        qmf_c[k+256]) +
-                MUL_F(pring_buffer_1[k+(512+192)],  qmf_c[k+320]) +
-                MUL_F(pring_buffer_1[k+768],        qmf_c[k+384]) +
-                MUL_F(pring_buffer_1[k+(768+192)],  qmf_c[k+448]) +
-                MUL_F(pring_buffer_1[k+1024],       qmf_c[k+512]) +
-                MUL_F(pring_buffer_1[k+(1024+192)], qmf_c[k+576]);
+        qmfs_window_64(output + out, pring_buffer_1);
+        out += 64;
 #endif // #ifdef PREFER_POINTERS
-        }
 
         /* update ringbuffer index */
         qmfs->v_index -= 128;
@@ -0,0 +1,299 @@
+/*
+** FAAD2 - Freeware Advanced Audio (AAC) Decoder including SBR decoding
+** Copyright (C) 2003-2005 M. Bakker, Nero AG, http://www.nero.com
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**
+** Any non-GPL usage of this software or parts of this software is strictly
+** forbidden.
+**
+** The "appropriate copyright message" mentioned in section 2c of the GPLv2
+** must read: "Code from FAAD2 is copyright (c) Nero AG, www.nero.com"
+**
+** Commercial non-GPL licensing of this software is possible.
+** For more info contact Nero AG through Mpeg4AAClicense@nero.com.
+**
+** $Id$
+**/
+
+#ifndef __SIMD_H__
+#define __SIMD_H__
+
+#if defined(SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+#ifdef SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 4 x float vectors on top of SSE2 or NEON (SIMD_V4 in common.h).
+   Complex values are stored interleaved [re, im], two per vector.
+   Only plain multiplies and adds are used, never fused ones, so code
+   written with these gives the same results as the C version. */
+
+#ifdef SIMD_SSE2
+
+typedef __m128 v4sf;
+
+#define v4_load(p)      _mm_loadu_ps(p)
+#define v4_store(p, a)  _mm_storeu_ps(p, a)
+#define v4_set1(x)      _mm_set1_ps(x)
+#define v4_set(a,b,c,d) _mm_setr_ps(a, b, c, d)
+#define v4_add(a, b)    _mm_add_ps(a, b)
+#define v4_sub(a, b)    _mm_sub_ps(a, b)
+#define v4_mul(a, b)    _mm_mul_ps(a, b)
+#define v4_div(a, b)    _mm_div_ps(a, b)
+#define v4_sqrt(a)      _mm_sqrt_ps(a)
+#define v4_neg(a)       _mm_xor_ps(a, _mm_set1_ps(-0.0f))
+
+/* per lane (a > b) ? x : y, (a >= b) ? x : y and (a == b) ? x : y */
+#define v4_sel_gt(a, b, x, y) v4_select(_mm_cmpgt_ps(a, b), x, y)
+#define v4_sel_ge(a, b, x, y) v4_select(_mm_cmpge_ps(a, b), x, y)
+#define v4_sel_eq(a, b, x, y) v4_select(_mm_cmpeq_ps(a, b), x, y)
+static INLINE v4sf v4_select(__m128 mask, v4sf x, v4sf y)
+{
+    return _mm_or_ps(_mm_and_ps(mask, x), _mm_andnot_ps(mask, y));
+}
+
+/* [re, im] -> [im, re], [re, re], [im, im] */
+#define v4_swap_ri(a)   _mm_shuffle_ps(a, a, _MM_SHUFFLE(2,3,0,1))
+#define v4_dup_re(a)    _mm_shuffle_ps(a, a, _MM_SHUFFLE(2,2,0,0))
+#define v4_dup_im(a)    _mm_shuffle_ps(a, a, _MM_SHUFFLE(3,3,1,1))
+
+/* [first complex of a, first complex of b] etc. */
+#define v4_lo_lo(a, b)  _mm_movelh_ps(a, b)
+#define v4_hi_hi(a, b)  _mm_movehl_ps(b, a)
+#define v4_lo_hi(a, b)  _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,2,1,0))
+#define v4_hi_lo(a, b)  _mm_shuffle_ps(a, b, _MM_SHUFFLE(1,0,3,2))
+
+/* real parts of a, imaginary parts of b */
+static INLINE v4sf v4_re_im(v4sf a, v4sf b)
+{
+    const __m128 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, 0, -1, 0));
+
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/* [a0, a1, a2, a3] -> [a3, a2, a1, a0] */
+#define v4_reverse(a)   _mm_shuffle_ps(a, a, _MM_SHUFFLE(0,1,2,3))
+/* [a0, a1, a2, a3] -> [a0, a2, a1, a3] */
+#define v4_swap_mid(a)  _mm_shuffle_ps(a, a, _MM_SHUFFLE(3,1,2,0))
+/* even / odd elements of [a, b]; [a0, b0, a1, b1] / [a2, b2, a3, b3] */
+#define v4_even(a, b)   _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0))
+#define v4_odd(a, b)    _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1))
+#define v4_zip_lo(a, b) _mm_unpacklo_ps(a, b)
+#define v4_zip_hi(a, b) _mm_unpackhi_ps(a, b)
+#define v4_first(a)     _mm_cvtss_f32(a)
+
+/* 4x4 matrix transpose, rows in a, b, c, d */
+#define v4_transpose(a, b, c, d) _MM_TRANSPOSE4_PS(a, b, c, d)
+
+/* 4 x int32 vectors for the PCM output and the inverse quantisation;
+   float -> int conversion
+   rounds to nearest like lrintf() or truncates like a C cast */
+typedef __m128i v4si;
+
+#define v4_min(a, b)    _mm_min_ps(a, b)
+#define v4_max(a, b)    _mm_max_ps(a, b)
+#define v4_round(a)     _mm_cvtps_epi32(a)
+#define v4_from_int(a)  _mm_cvtepi32_ps(a)
+/* cvttps gives INT_MIN for a >= 2^31, saturate that to INT_MAX like
+   NEON does */
+static INLINE v4si v4_trunc(v4sf a)
+{
+    __m128i big = _mm_castps_si128(_mm_cmpge_ps(a, _mm_set1_ps(2147483648.0f)));
+
+    return _mm_xor_si128(_mm_cvttps_epi32(a), big);
+}
+
+#define v4i_load(p)     _mm_loadu_si128((const __m128i *)(p))
+#define v4i_store(p, a) _mm_storeu_si128((__m128i *)(p), a)
+#define v4i_xor(a, b)   _mm_xor_si128(a, b)
+#define v4i_shl(a, n)   _mm_slli_epi32(a, n)
+/* logical shift */
+#define v4i_shr(a, n)   _mm_srli_epi32(a, n)
+/* a and b saturated to 16 bit, stored as 8 x int16 */
+#define v4i_store_s16(p, a, b) _mm_storeu_si128((__m128i *)(p), _mm_packs_epi32(a, b))
+/* 4 x int16 from p, sign extended */
+#define v4i_load_s16(p) _mm_srai_epi32(_mm_unpacklo_epi16(_mm_setzero_si128(), \
+                            _mm_loadl_epi64((const __m128i *)(p))), 16)
+#define v4i_set1(x)     _mm_set1_epi32(x)
+#define v4i_sub(a, b)   _mm_sub_epi32(a, b)
+#define v4i_sar(a, n)   _mm_srai_epi32(a, n)
+/* all ones where a > b */
+#define v4i_cmpgt(a, b) _mm_cmpgt_epi32(a, b)
+/* non zero if all lanes of a are 0 */
+#define v4i_all_zero(a) (_mm_movemask_epi8(_mm_cmpeq_epi32(a, _mm_setzero_si128())) == 0xFFFF)
+/* bit casts */
+#define v4_as_int(a)    _mm_castps_si128(a)
+#define v4_as_float(a)  _mm_castsi128_ps(a)
+
+#endif
+
+#ifdef SIMD_NEON
+
+typedef float32x4_t v4sf;
+
+#define v4_load(p)      vld1q_f32(p)
+#define v4_store(p, a)  vst1q_f32(p, a)
+#define v4_set1(x)      vdupq_n_f32(x)
+static INLINE v4sf v4_set(float a, float b, float c, float d)
+{
+    const float v[4] = { a, b, c, d };
+    return vld1q_f32(v);
+}
+#define v4_add(a, b)    vaddq_f32(a, b)
+#define v4_sub(a, b)    vsubq_f32(a, b)
+#define v4_mul(a, b)    vmulq_f32(a, b)
+#define v4_div(a, b)    vdivq_f32(a, b)
+#define v4_sqrt(a)      vsqrtq_f32(a)
+#define v4_neg(a)       vnegq_f32(a)
+
+#define v4_sel_gt(a, b, x, y) vbslq_f32(vcgtq_f32(a, b), x, y)
+#define v4_sel_ge(a, b, x, y) vbslq_f32(vcgeq_f32(a, b), x, y)
+#define v4_sel_eq(a, b, x, y) vbslq_f32(vceqq_f32(a, b), x, y)
+
+#define v4_swap_ri(a)   vrev64q_f32(a)
+#define v4_dup_re(a)    vtrn1q_f32(a, a)
+#define v4_dup_im(a)    vtrn2q_f32(a, a)
+
+#define v4_lo_lo(a, b)  vcombine_f32(vget_low_f32(a), vget_low_f32(b))
+#define v4_hi_hi(a, b)  vcombine_f32(vget_high_f32(a), vget_high_f32(b))
+#define v4_lo_hi(a, b)  vcombine_f32(vget_low_f32(a), vget_high_f32(b))
+#define v4_hi_lo(a, b)  vcombine_f32(vget_high_f32(a), vget_low_f32(b))
+
+static INLINE v4sf v4_re_im(v4sf a, v4sf b)
+{
+    const uint32x4_t mask = vreinterpretq_u32_u64(vdupq_n_u64(0xffffffffu));
+
+    return vbslq_f32(mask, a, b);
+}
+
+static INLINE v4sf v4_reverse(v4sf a)
+{
+    a = vrev64q_f32(a);
+    return vcombine_f32(vget_high_f32(a), vget_low_f32(a));
+}
+
+static INLINE v4sf v4_swap_mid(v4sf a)
+{
+    return vcombine_f32(vget_low_f32(vuzp1q_f32(a, a)), vget_low_f32(vuzp2q_f32(a, a)));
+}
+#define v4_even(a, b)   vuzp1q_f32(a, b)
+#define v4_odd(a, b)    vuzp2q_f32(a, b)
+#define v4_zip_lo(a, b) vzip1q_f32(a, b)
+#define v4_zip_hi(a, b) vzip2q_f32(a, b)
+#define v4_first(a)     vgetq_lane_f32(a, 0)
+
+#define v4_transpose(a, b, c, d) do { \
+    float32x4_t t0 = vtrn1q_f32(a, b), t1 = vtrn2q_f32(a, b); \
+    float32x4_t t2 = vtrn1q_f32(c, d), t3 = vtrn2q_f32(c, d); \
+    a = vreinterpretq_f32_f64(vtrn1q_f64(vreinterpretq_f64_f32(t0), vreinterpretq_f64_f32(t2))); \
+    b = vreinterpretq_f32_f64(vtrn1q_f64(vreinterpretq_f64_f32(t1), vreinterpretq_f64_f32(t3))); \
+    c = vreinterpretq_f32_f64(vtrn2q_f64(vreinterpretq_f64_f32(t0), vreinterpretq_f64_f32(t2))); \
+    d = vreinterpretq_f32_f64(vtrn2q_f64(vreinterpretq_f64_f32(t1), vreinterpretq_f64_f32(t3))); \
+} while (0)
+
+typedef int32x4_t v4si;
+
+#define v4_min(a, b)    vminq_f32(a, b)
+#define v4_max(a, b)    vmaxq_f32(a, b)
+#define v4_round(a)     vcvtnq_s32_f32(a)
+#define v4_trunc(a)     vcvtq_s32_f32(a)
+#define v4_from_int(a)  vcvtq_f32_s32(a)
+
+#define v4i_load(p)     vld1q_s32((const int32_t *)(p))
+#define v4i_store(p, a) vst1q_s32((int32_t *)(p), a)
+#define v4i_xor(a, b)   veorq_s32(a, b)
+#define v4i_shl(a, n)   vshlq_n_s32(a, n)
+#define v4i_shr(a, n)   vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a), n))
+#define v4i_store_s16(p, a, b) vst1q_s16((int16_t *)(p), vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)))
+#define v4i_load_s16(p) vmovl_s16(vld1_s16((const int16_t *)(p)))
+#define v4i_set1(x)     vdupq_n_s32(x)
+#define v4i_sub(a, b)   vsubq_s32(a, b)
+#define v4i_sar(a, n)   vshrq_n_s32(a, n)
+#define v4i_cmpgt(a, b) vreinterpretq_s32_u32(vcgtq_s32(a, b))
+#define v4i_all_zero(a) (vmaxvq_u32(vreinterpretq_u32_s32(a)) == 0)
+#define v4_as_int(a)    vreinterpretq_s32_f32(a)
+#define v4_as_float(a)  vreinterpretq_f32_s32(a)
+
+#endif
+
+#ifdef SIMD_V4
+/* four complex values in split form, one per lane: A[2*k] holds the
+   real parts and A[2*k+1] the imaginary parts of value k */
+#define RE4(A, k) A[2*(k)]
+#define IM4(A, k) A[2*(k)+1]
+
+/* t*w with sign = [-1, 1, -1, 1], t*conj(w) with sign = [1, -1, 1, -1];
+   same operations as ComplexMult() */
+static INLINE v4sf v4_cmul(v4sf t, v4sf w, v4sf sign)
+{
+    return v4_add(v4_mul(t, v4_dup_re(w)),
+        v4_mul(v4_mul(v4_swap_ri(t), v4_dup_im(w)), sign));
+}
+#endif
+
+/* 8 x float AVX2 vectors, only to be used from functions marked
+   SIMD_AVX2_FUNC and only after cpu_has_avx2() */
+#ifdef SIMD_AVX2
+
+#ifdef _MSC_VER
+#define SIMD_AVX2_FUNC
+#else
+#define SIMD_AVX2_FUNC __attribute__((target("avx2")))
+#endif
+
+#define v8_load(p)      _mm256_loadu_ps(p)
+#define v8_store(p, a)  _mm256_storeu_ps(p, a)
+#define v8_set1(x)      _mm256_set1_ps(x)
+#define v8_set(a,b)     _mm256_setr_ps(a, b, a, b, a, b, a, b)
+#define v8_add(a, b)    _mm256_add_ps(a, b)
+#define v8_sub(a, b)    _mm256_sub_ps(a, b)
+#define v8_mul(a, b)    _mm256_mul_ps(a, b)
+
+#define v8_swap_ri(a)   _mm256_permute_ps(a, _MM_SHUFFLE(2,3,0,1))
+#define v8_dup_re(a)    _mm256_moveldup_ps(a)
+#define v8_dup_im(a)    _mm256_movehdup_ps(a)
+#define v8_re_im(a, b)  _mm256_blend_ps(a, b, 0xAA)
+
+#define v8_cmul(t, w, sign) \
+    v8_add(v8_mul(t, v8_dup_re(w)), \
+        v8_mul(v8_mul(v8_swap_ri(t), v8_dup_im(w)), sign))
+
+/* 8 x int32 */
+#define v8i_load_s16(p) _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(p)))
+#define v8i_set1(x)     _mm256_set1_epi32(x)
+#define v8i_abs(a)      _mm256_abs_epi32(a)
+#define v8i_and(a, b)   _mm256_and_si256(a, b)
+/* non zero if a & b is 0 in all lanes */
+#define v8i_none(a, b)  _mm256_testz_si256(a, b)
+/* t[idx] for the 8 lanes of idx */
+#define v8_gather(t, idx) _mm256_i32gather_ps(t, idx, 4)
+#define v8_xor(a, b)    _mm256_xor_ps(a, b)
+#define v8_as_float(a)  _mm256_castsi256_ps(a)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -51,6 +51,8 @@
 #include "drc.h"
 #include "lt_predict.h"
 #include "ic_predict.h"
+#include "output.h"
+#include "simd.h"
 #ifdef SSR_DEC
 #include "ssr.h"
 #include "ssr_fb.h"
@@ -425,6 +427,15 @@ uint8_t window_grouping_info(NeAACDecStruct *hDecoder, ic_stream *ics)
     }
 }
 
+#if !defined(FIXED_POINT) && defined(SMALL_IQ_TABLE)
+/* x^(4/3) for the magnitudes above the table. Computed in double
+   precision this rounds to the same values as the full table. */
+static real_t iquant_calc(int32_t x)
+{
+    return (real_t)((double)x * cbrt((double)x));
+}
+#endif
+
 /* iquant() *
 /* output = sign(input)*abs(input)^(4/3) */
 /**/
@@ -477,6 +488,25 @@ static INLINE real_t iquant(int16_t q, const real_t *tab, uint8_t *error)
     return 0;
 #endif
 
+#elif defined(SMALL_IQ_TABLE)
+    if (q < 0)
+    {
+        if (-q < IQ_TABLE_SIZE)
+            return -tab[-q];
+        if (-q < 8192)
+            return -iquant_calc(-q);
+
+        *error = 17;
+        return 0;
+    } else {
+        if (q < IQ_TABLE_SIZE)
+            return tab[q];
+        if (q < 8192)
+            return iquant_calc(q);
+
+        *error = 17;
+        return 0;
+    }
 #else
     if (q < 0)
     {
@@ -523,6 +553,86 @@ ALIGN static const real_t pow2sf_tab[] = {
 };
 #endif
 
+#ifdef SIMD_V4
+/* iquant() times the scalefactor gain for one window of a band, four
+   values at a time. The table values are looked up one by one, the sign
+   and the gain are applied to the vector. All zero groups are stored
+   directly, groups with a value outside the table go through iquant()
+   to flag the error. */
+static INLINE void iquant_band(const int16_t *q, real_t *spec, uint16_t width,
+                               real_t scf, const real_t *tab, uint8_t *error)
+{
+    const v4sf vscf = v4_set1(scf);
+    const v4si vmax = v4i_set1(IQ_TABLE_SIZE-1);
+    ALIGN int32_t idx[4];
+    uint16_t bin;
+
+    for (bin = 0; bin < width; bin += 4)
+    {
+        v4si x = v4i_load_s16(q + bin);
+        v4si sgn = v4i_sar(x, 31);
+        v4si a = v4i_sub(v4i_xor(x, sgn), sgn);
+        v4sf y;
+
+        if (v4i_all_zero(a))
+        {
+            v4_store(spec + bin, v4_set1(0.0f));
+            continue;
+        }
+        if (!v4i_all_zero(v4i_cmpgt(a, vmax)))
+        {
+            spec[bin+0] = iquant(q[bin+0], tab, error) * scf;
+            spec[bin+1] = iquant(q[bin+1], tab, error) * scf;
+            spec[bin+2] = iquant(q[bin+2], tab, error) * scf;
+            spec[bin+3] = iquant(q[bin+3], tab, error) * scf;
+            continue;
+        }
+
+        v4i_store(idx, a);
+        y = v4_set(tab[idx[0]], tab[idx[1]], tab[idx[2]], tab[idx[3]]);
+        y = v4_as_float(v4i_xor(v4_as_int(y), v4i_shl(sgn, 31)));
+        v4_store(spec + bin, v4_mul(y, vscf));
+    }
+}
+#endif
+
+#ifdef SIMD_AVX2
+/* same as iquant_band() with the table lookups done by a gather */
+static SIMD_AVX2_FUNC void iquant_band_avx2(const int16_t *q, real_t *spec,
+                                            uint16_t width, real_t scf,
+                                            const real_t *tab, uint8_t *error)
+{
+    const __m256 vscf = v8_set1(scf);
+    const __m256i outside = v8i_set1(~(IQ_TABLE_SIZE-1));
+    const __m256i sign = v8i_set1((int32_t)0x80000000);
+    uint16_t bin;
+
+    for (bin = 0; bin + 8 <= width; bin += 8)
+    {
+        __m256i x = v8i_load_s16(q + bin);
+        __m256i a = v8i_abs(x);
+        __m256 y;
+
+        if (v8i_none(a, a))
+        {
+            v8_store(spec + bin, v8_set1(0.0f));
+            continue;
+        }
+        if (!v8i_none(a, outside))
+        {
+            iquant_band(q + bin, spec + bin, 8, scf, tab, error);
+            continue;
+        }
+
+        y = v8_gather(tab, a);
+        y = v8_xor(y, v8_as_float(v8i_and(x, sign)));
+        v8_store(spec + bin, v8_mul(y, vscf));
+    }
+    if (bin < width)
+        iquant_band(q + bin, spec + bin, width - bin, scf, tab, error);
+}
+#endif
+
 /* quant_to_spec: perform dequantisation and scaling
  * and in case of short block it also does the deinterleaving
  */
@@ -559,8 +669,11 @@ static uint8_t quant_to_spec(NeAACDecStruct *hDecoder,
     };
     const real_t *tab = iq_table;
 
-    uint8_t g, sfb, win;
-    uint16_t width, bin, k, gindex, wa, wb;
+    uint8_t g, sfb, win, zero;
+    uint16_t width, k, gindex, wa;
+#if !defined(SIMD_AVX2) && !defined(SIMD_V4)
+    uint16_t bin, wb;
+#endif
     uint8_t error = 0; /* Init error flag */
 #ifndef FIXED_POINT
     real_t scf;
@@ -614,8 +727,32 @@ static uint8_t quant_to_spec(NeAACDecStruct *hDecoder,
             scf = pow2sf_tab[exp/*+25*/] * pow2_table[frac];
 #endif
 
+            zero = is_zero_band(ics, g, sfb);
+
             for (win = 0; win < ics->window_group_length[g]; win++)
             {
+                if (zero)
+                {
+                    /* nothing to dequantise */
+                    memset(&spec_data[wa], 0, width*sizeof(real_t));
+                    gincrease += width;
+                    k += width;
+                    wa += win_inc;
+                    continue;
+                }
+
+#if defined(SIMD_AVX2)
+                if (hDecoder->use_avx2)
+                    iquant_band_avx2(&quant_data[k], &spec_data[wa], width, scf, tab, &error);
+                else
+                    iquant_band(&quant_data[k], &spec_data[wa], width, scf, tab, &error);
+                gincrease += width;
+                k += width;
+#elif defined(SIMD_V4)
+                iquant_band(&quant_data[k], &spec_data[wa], width, scf, tab, &error);
+                gincrease += width;
+                k += width;
+#else
                 for (bin = 0; bin < width; bin += 4)
                 {
 #ifndef FIXED_POINT
@@ -670,6 +807,7 @@ static uint8_t quant_to_spec(NeAACDecStruct *hDecoder,
                     gincrease += 4;
                     k += 4;
                 }
+#endif
                 wa += win_inc;
             }
             j += width;
@@ -759,6 +897,7 @@ static uint8_t allocate_single_channel(NeAACDecStruct *hDecoder, uint8_t channel
 
     hDecoder->fb_intermed[channel] = (real_t*)faad_malloc(hDecoder->frameLength*sizeof(real_t));
     memset(hDecoder->fb_intermed[channel], 0, hDecoder->frameLength*sizeof(real_t));
+    hDecoder->fb_intermed_zero[channel] = 1;
 
 #ifdef SSR_DEC
     if (hDecoder->object_type == SSR)
@@ -846,11 +985,13 @@ static uint8_t allocate_channel_pair(NeAACDecStruct *hDecoder,
     {
         hDecoder->fb_intermed[channel] = (real_t*)faad_malloc(hDecoder->frameLength*sizeof(real_t));
         memset(hDecoder->fb_intermed[channel], 0, hDecoder->frameLength*sizeof(real_t));
+        hDecoder->fb_intermed_zero[channel] = 1;
     }
     if (hDecoder->fb_intermed[paired_channel] == NULL)
     {
         hDecoder->fb_intermed[paired_channel] = (real_t*)faad_malloc(hDecoder->frameLength*sizeof(real_t));
         memset(hDecoder->fb_intermed[paired_channel], 0, hDecoder->frameLength*sizeof(real_t));
+        hDecoder->fb_intermed_zero[paired_channel] = 1;
     }
 
 #ifdef SSR_DEC
@@ -886,80 +1027,187 @@ static uint8_t allocate_channel_pair(NeAACDecStruct *hDecoder,
     return 0;
 }
 
-uint8_t reconstruct_single_channel(NeAACDecStruct *hDecoder, ic_stream *ics,
-                                   element *sce, int16_t *spec_data)
+/* returns the storage for the element currently being parsed when the
+   reconstruction is deferred, see reconstruct_elements() */
+static element_job *get_element_job(NeAACDecStruct *hDecoder)
 {
-    uint8_t retval;
-    int output_channels;
-    ALIGN real_t spec_coef[1024];
+    frame_job *fj = hDecoder->fr_job;
+    element_job *job;
 
-#ifdef PROFILE
-    int64_t count = faad_get_ts();
-#endif
+    if (fj->ele_job[fj->num_ele_jobs] == NULL)
+    {
+        fj->ele_job[fj->num_ele_jobs] =
+            (element_job*)faad_malloc(sizeof(element_job));
+    }
+    job = fj->ele_job[fj->num_ele_jobs];
+    if (job != NULL)
+    {
+        job->ele_index = hDecoder->fr_ch_ele;
+        job->error = 0;
+    }
+
+    return job;
+}
 
+/* whether none of the output channels of an element, mapped the way
+   decode_sce_lfe() and decode_cpe() do, is selected by config.channelMask */
+static uint8_t element_outside_mask(NeAACDecStruct *hDecoder, element *ele,
+                                   uint8_t paired, uint8_t output_channels)
+{
+    uint32_t mask = (uint32_t)hDecoder->config.channelMask;
+    uint8_t pos = ele->channel;
+    uint8_t count = (paired || (output_channels == 2)) ? 2 : 1;
 
-    /* always allocate 2 channels, PS can always "suddenly" turn up */
-#if ( (defined(DRM) && defined(DRM_PS)) )
-    output_channels = 2;
-#elif defined(PS_DEC)
-    if (hDecoder->ps_used[hDecoder->fr_ch_ele])
-        output_channels = 2;
-    else
-        output_channels = 1;
-#else
-    output_channels = 1;
-#endif
+    if (mask == 0)
+        return 0;
 
-    if (hDecoder->element_output_channels[hDecoder->fr_ch_ele] == 0)
+    if (hDecoder->pce_set && (paired || (output_channels == 1)))
     {
-        /* element_output_channels not set yet */
-        hDecoder->element_output_channels[hDecoder->fr_ch_ele] = output_channels;
-    } else if (hDecoder->element_output_channels[hDecoder->fr_ch_ele] != output_channels) {
-        /* element inconsistency */
+        if (paired)
+            pos = hDecoder->pce.cpe_channel[ele->element_instance_tag];
+        else
+            pos = hDecoder->pce.sce_channel[ele->element_instance_tag];
+    }
 
-        /* this only happens if PS is actually found but not in the first frame
-         * this means that there is only 1 bitstream element!
-         */
+    /* channels beyond the mask are always decoded */
+    if (pos+count > 32)
+        return 0;
 
-        /* reset the allocation */
-        hDecoder->element_alloced[hDecoder->fr_ch_ele] = 0;
+    return ((mask >> pos) & ((1u << count) - 1)) == 0;
+}
 
-        hDecoder->element_output_channels[hDecoder->fr_ch_ele] = output_channels;
+/* output of an element outside of the channel mask: its channels are set to
+   silence once, with the filterbank overlap and prediction state cleared,
+   so the element restarts cleanly when it is selected again */
+static void mask_element(NeAACDecStruct *hDecoder, uint8_t ele, element *sce,
+                         uint8_t paired)
+{
+    uint8_t i, ch[2], count = 1;
+    uint16_t len = hDecoder->frameLength;
+    uint8_t mul = 1;
 
-        //return 21;
+    if (hDecoder->element_masked[ele])
+        return;
+
+    ch[0] = sce->channel;
+    if (paired)
+    {
+        ch[1] = (uint8_t)sce->paired_channel;
+        count = 2;
+    } else if (hDecoder->element_output_channels[ele] == 2) {
+        ch[1] = sce->channel+1;
+        count = 2;
     }
+#ifdef SBR_DEC
+    if (hDecoder->sbr_alloced[ele])
+        mul = 2;
+#endif
 
-    if (hDecoder->element_alloced[hDecoder->fr_ch_ele] == 0)
+    for (i = 0; i < count; i++)
     {
-        retval = allocate_single_channel(hDecoder, sce->channel, output_channels);
-        if (retval > 0)
-            return retval;
+        memset(hDecoder->time_out[ch[i]], 0, mul*len*sizeof(real_t));
+        memset(hDecoder->fb_intermed[ch[i]], 0, len*sizeof(real_t));
+        hDecoder->fb_intermed_zero[ch[i]] = 1;
+#ifdef MAIN_DEC
+        if (hDecoder->pred_stat[ch[i]])
+            reset_all_predictors(hDecoder->pred_stat[ch[i]], len);
+#endif
+#ifdef LTP_DEC
+        if (hDecoder->lt_pred_stat[ch[i]])
+            memset(hDecoder->lt_pred_stat[ch[i]], 0, len*4 * sizeof(int16_t));
+#endif
+    }
 
-        hDecoder->element_alloced[hDecoder->fr_ch_ele] = 1;
+    hDecoder->element_masked[ele] = 1;
+}
+
+#ifdef SBR_DEC
+/* everything SBR needs before the element can be reconstructed,
+   done while parsing because it may allocate */
+static uint8_t sbr_element_setup(NeAACDecStruct *hDecoder, uint8_t ele, element *sce)
+{
+    if (((hDecoder->sbr_present_flag == 1) || (hDecoder->forceUpSampling == 1))
+        && hDecoder->sbr_alloced[ele])
+    {
+        /* following case can happen when forceUpSampling == 1 */
+        if (hDecoder->sbr[ele] == NULL)
+        {
+            hDecoder->sbr[ele] = sbrDecodeInit(hDecoder->frameLength,
+                hDecoder->element_id[ele], 2*get_sample_rate(hDecoder->sf_index),
+                hDecoder->downSampledSBR
+#ifdef DRM
+                , 0
+#endif
+                );
+        }
+        if (!hDecoder->sbr[ele])
+            return 19;
+
+        if (sce->ics1.window_sequence == EIGHT_SHORT_SEQUENCE)
+            hDecoder->sbr[ele]->maxAACLine = 8*min(sce->ics1.swb_offset[max(sce->ics1.max_sfb-1, 0)], sce->ics1.swb_offset_max);
+        else
+            hDecoder->sbr[ele]->maxAACLine = min(sce->ics1.swb_offset[max(sce->ics1.max_sfb-1, 0)], sce->ics1.swb_offset_max);
+    } else if (((hDecoder->sbr_present_flag == 1) || (hDecoder->forceUpSampling == 1))
+        && !hDecoder->sbr_alloced[ele])
+    {
+        return 23;
     }
 
-    /* sanity check, CVE-2018-20199, CVE-2018-20360 */
-    if(!hDecoder->time_out[sce->channel])
-        return 15;
-    if(output_channels > 1 && !hDecoder->time_out[sce->channel+1])
-        return 15;
-    if(!hDecoder->fb_intermed[sce->channel])
-        return 15;
+    return 0;
+}
+#endif
 
-    /* dequantisation and scaling */
-    retval = quant_to_spec(hDecoder, ics, spec_data, spec_coef, hDecoder->frameLength);
-    if (retval > 0)
-        return retval;
+/* inverse filterbank of one channel; a silent spectrum with a silent
+   overlap gives silence, so the IMDCT is skipped for those channels.
+   The output is then identical except for the sign of zero: the bypass
+   writes +0.0 where the IMDCT can give -0.0 */
+static void channel_filter_bank(NeAACDecStruct *hDecoder, ic_stream *ics,
+                                real_t *spec_coef, uint8_t channel)
+{
+    uint8_t silent = 0;
+#ifndef FIXED_POINT
+    /* not for fixed point: its IMDCT rounds an all zero spectrum to a small
+       non zero output */
+    uint16_t i;
 
-#ifdef PROFILE
-    count = faad_get_ts() - count;
-    hDecoder->requant_cycles += count;
+    silent = 1;
+    for (i = 0; i < hDecoder->frameLength; i++)
+    {
+        if (spec_coef[i] != 0)
+        {
+            silent = 0;
+            break;
+        }
+    }
 #endif
 
+    if (silent && hDecoder->fb_intermed_zero[channel])
+    {
+        memset(hDecoder->time_out[channel], 0, hDecoder->frameLength*sizeof(real_t));
+    } else {
+        ifilter_bank(hDecoder->fb, ics->window_sequence, ics->window_shape,
+            hDecoder->window_shape_prev[channel], spec_coef,
+            hDecoder->time_out[channel], hDecoder->fb_intermed[channel],
+            hDecoder->object_type, hDecoder->frameLength);
+    }
+
+    /* the overlap for the next frame only depends on this spectrum */
+    hDecoder->fb_intermed_zero[channel] = silent;
+}
 
-    /* pns decoding */
-    pns_decode(ics, NULL, spec_coef, NULL, hDecoder->frameLength, 0, hDecoder->object_type,
-        &(hDecoder->__r1), &(hDecoder->__r2));
+/* second half of the reconstruction of a single channel element, only
+   touches the state of the element's own channels */
+static uint8_t single_channel_synthesis(NeAACDecStruct *hDecoder, drc_info *drc,
+                                        uint8_t ele, ic_stream *ics, element *sce,
+                                        real_t *spec_coef, uint8_t spectral_dm)
+{
+#ifdef SBR_DEC
+    uint8_t retval;
+    /* selected again after being masked, SBR starts as after a seek */
+    uint8_t restart = hDecoder->element_masked[ele];
+#endif
+
+    hDecoder->element_masked[ele] = 0;
 
 #ifdef MAIN_DEC
     /* MAIN object type prediction */
@@ -1007,21 +1255,22 @@ uint8_t reconstruct_single_channel(NeAACDecStruct *hDecoder, ic_stream *ics,
         spec_coef, hDecoder->frameLength);
 
     /* drc decoding */
-    if (hDecoder->drc->present)
+    if (drc->present)
     {
-        if (!hDecoder->drc->exclude_mask[sce->channel] || !hDecoder->drc->excluded_chns_present)
-            drc_decode(hDecoder->drc, spec_coef);
+        if (!drc->exclude_mask[sce->channel] || !drc->excluded_chns_present)
+            drc_decode(drc, spec_coef);
     }
 
+    /* a frame mixed before the filter bank is finished by spectral_downmix() */
+    if (spectral_dm)
+        return 0;
+
     /* filter bank */
 #ifdef SSR_DEC
     if (hDecoder->object_type != SSR)
     {
 #endif
-        ifilter_bank(hDecoder->fb, ics->window_sequence, ics->window_shape,
-            hDecoder->window_shape_prev[sce->channel], spec_coef,
-            hDecoder->time_out[sce->channel], hDecoder->fb_intermed[sce->channel],
-            hDecoder->object_type, hDecoder->frameLength);
+        channel_filter_bank(hDecoder, ics, spec_coef, sce->channel);
 #ifdef SSR_DEC
     } else {
         ssr_decode(&(ics->ssr), hDecoder->fb, ics->window_sequence, ics->window_shape,
@@ -1044,59 +1293,34 @@ uint8_t reconstruct_single_channel(NeAACDecStruct *hDecoder, ic_stream *ics,
 
 #ifdef SBR_DEC
     if (((hDecoder->sbr_present_flag == 1) || (hDecoder->forceUpSampling == 1))
-        && hDecoder->sbr_alloced[hDecoder->fr_ch_ele])
+        && hDecoder->sbr_alloced[ele])
     {
-        int ele = hDecoder->fr_ch_ele;
         int ch = sce->channel;
 
-        /* following case can happen when forceUpSampling == 1 */
-        if (hDecoder->sbr[ele] == NULL)
-        {
-            hDecoder->sbr[ele] = sbrDecodeInit(hDecoder->frameLength,
-                hDecoder->element_id[ele], 2*get_sample_rate(hDecoder->sf_index),
-                hDecoder->downSampledSBR
-#ifdef DRM
-                , 0
-#endif
-                );
-        }
-        if (!hDecoder->sbr[ele])
-            return 19;
-
-        if (sce->ics1.window_sequence == EIGHT_SHORT_SEQUENCE)
-            hDecoder->sbr[ele]->maxAACLine = 8*min(sce->ics1.swb_offset[max(sce->ics1.max_sfb-1, 0)], sce->ics1.swb_offset_max);
-        else
-            hDecoder->sbr[ele]->maxAACLine = min(sce->ics1.swb_offset[max(sce->ics1.max_sfb-1, 0)], sce->ics1.swb_offset_max);
-
         /* check if any of the PS tools is used */
 #if (defined(PS_DEC) || defined(DRM_PS))
         if (hDecoder->ps_used[ele] == 0)
         {
 #endif
             retval = sbrDecodeSingleFrame(hDecoder->sbr[ele], hDecoder->time_out[ch],
-                hDecoder->postSeekResetFlag, hDecoder->downSampledSBR);
+                hDecoder->postSeekResetFlag || restart, hDecoder->downSampledSBR);
 #if (defined(PS_DEC) || defined(DRM_PS))
         } else {
             retval = sbrDecodeSingleFramePS(hDecoder->sbr[ele], hDecoder->time_out[ch],
-                hDecoder->time_out[ch+1], hDecoder->postSeekResetFlag,
+                hDecoder->time_out[ch+1], hDecoder->postSeekResetFlag || restart,
                 hDecoder->downSampledSBR);
         }
 #endif
         if (retval > 0)
             return retval;
-    } else if (((hDecoder->sbr_present_flag == 1) || (hDecoder->forceUpSampling == 1))
-        && !hDecoder->sbr_alloced[hDecoder->fr_ch_ele])
-    {
-        return 23;
     }
 #endif
 
     /* copy L to R when no PS is used */
 #if (defined(PS_DEC) || defined(DRM_PS))
-    if ((hDecoder->ps_used[hDecoder->fr_ch_ele] == 0) &&
-        (hDecoder->element_output_channels[hDecoder->fr_ch_ele] == 2))
+    if ((hDecoder->ps_used[ele] == 0) &&
+        (hDecoder->element_output_channels[ele] == 2))
     {
-        int ele = hDecoder->fr_ch_ele;
         int ch = sce->channel;
         int frame_size = (hDecoder->sbr_alloced[ele]) ? 2 : 1;
         frame_size *= hDecoder->frameLength*sizeof(real_t);
@@ -1108,36 +1332,108 @@ uint8_t reconstruct_single_channel(NeAACDecStruct *hDecoder, ic_stream *ics,
     return 0;
 }
 
-uint8_t reconstruct_channel_pair(NeAACDecStruct *hDecoder, ic_stream *ics1, ic_stream *ics2,
-                                 element *cpe, int16_t *spec_data1, int16_t *spec_data2)
+uint8_t reconstruct_single_channel(NeAACDecStruct *hDecoder, ic_stream *ics,
+                                   element *sce, int16_t *spec_data)
 {
-    uint8_t retval;
-    ALIGN real_t spec_coef1[1024];
-    ALIGN real_t spec_coef2[1024];
+    uint8_t retval, masked;
+    int output_channels;
+    ALIGN real_t spec_coef_buf[1024];
+    real_t *spec_coef = spec_coef_buf;
+    element_job *job = NULL;
 
 #ifdef PROFILE
     int64_t count = faad_get_ts();
 #endif
-    if (hDecoder->element_alloced[hDecoder->fr_ch_ele] != 2)
+
+
+    /* always allocate 2 channels, PS can always "suddenly" turn up */
+#if ( (defined(DRM) && defined(DRM_PS)) )
+    output_channels = 2;
+#elif defined(PS_DEC)
+    if (hDecoder->ps_used[hDecoder->fr_ch_ele])
+        output_channels = 2;
+    else
+        output_channels = 1;
+#else
+    output_channels = 1;
+#endif
+
+    /* the element's channels are about to change */
+    if ((hDecoder->element_output_channels[hDecoder->fr_ch_ele] != output_channels) ||
+        (hDecoder->element_alloced[hDecoder->fr_ch_ele] == 0))
     {
-        retval = allocate_channel_pair(hDecoder, cpe->channel, (uint8_t)cpe->paired_channel);
+        finish_synthesis(hDecoder);
+    }
+
+    if (hDecoder->element_output_channels[hDecoder->fr_ch_ele] == 0)
+    {
+        /* element_output_channels not set yet */
+        hDecoder->element_output_channels[hDecoder->fr_ch_ele] = output_channels;
+    } else if (hDecoder->element_output_channels[hDecoder->fr_ch_ele] != output_channels) {
+        /* element inconsistency */
+
+        /* this only happens if PS is actually found but not in the first frame
+         * this means that there is only 1 bitstream element!
+         */
+
+        /* reset the allocation */
+        hDecoder->element_alloced[hDecoder->fr_ch_ele] = 0;
+
+        hDecoder->element_output_channels[hDecoder->fr_ch_ele] = output_channels;
+
+        //return 21;
+    }
+
+    if (hDecoder->element_alloced[hDecoder->fr_ch_ele] == 0)
+    {
+        retval = allocate_single_channel(hDecoder, sce->channel, output_channels);
         if (retval > 0)
             return retval;
 
-        hDecoder->element_alloced[hDecoder->fr_ch_ele] = 2;
+        hDecoder->element_alloced[hDecoder->fr_ch_ele] = 1;
     }
 
     /* sanity check, CVE-2018-20199, CVE-2018-20360 */
-    if(!hDecoder->time_out[cpe->channel] || !hDecoder->time_out[cpe->paired_channel])
+    if(!hDecoder->time_out[sce->channel])
         return 15;
-    if(!hDecoder->fb_intermed[cpe->channel] || !hDecoder->fb_intermed[cpe->paired_channel])
+    if(output_channels > 1 && !hDecoder->time_out[sce->channel+1])
+        return 15;
+    if(!hDecoder->fb_intermed[sce->channel])
         return 15;
 
-    /* dequantisation and scaling */
-    retval = quant_to_spec(hDecoder, ics1, spec_data1, spec_coef1, hDecoder->frameLength);
-    if (retval > 0)
-        return retval;
-    retval = quant_to_spec(hDecoder, ics2, spec_data2, spec_coef2, hDecoder->frameLength);
+    masked = element_outside_mask(hDecoder, sce, 0, (uint8_t)output_channels);
+
+    /* FAAD_DOWNMIX_SPECTRAL needs the spectra of all elements at once,
+       also in the frame after the last mixed one */
+    if (hDecoder->defer_elements || hDecoder->dm_parsed ||
+        (hDecoder->config.downMatrix == FAAD_DOWNMIX_SPECTRAL))
+    {
+        job = get_element_job(hDecoder);
+        if (job == NULL)
+            return 15;
+        spec_coef = job->spec_coef1;
+        job->masked = masked;
+    }
+
+    /* the element was parsed to stay in sync, only its noise is drawn so
+       the generator shared by all channels stays in step */
+    if (masked)
+    {
+        hDecoder->rng_draws += pns_decode(ics, NULL, spec_coef, NULL, hDecoder->frameLength, 0, hDecoder->object_type,
+            &(hDecoder->__r1), &(hDecoder->__r2));
+        if (job != NULL)
+        {
+            job->ele = *sce;
+            job->paired = 0;
+            hDecoder->fr_job->num_ele_jobs++;
+        } else {
+            mask_element(hDecoder, hDecoder->fr_ch_ele, sce, 0);
+        }
+        return 0;
+    }
+
+    /* dequantisation and scaling */
+    retval = quant_to_spec(hDecoder, ics, spec_data, spec_coef, hDecoder->frameLength);
     if (retval > 0)
         return retval;
 
@@ -1146,54 +1442,46 @@ uint8_t reconstruct_channel_pair(NeAACDecStruct *hDecoder, ic_stream *ics1, ic_s
     hDecoder->requant_cycles += count;
 #endif
 
+
     /* pns decoding */
-    if (ics1->ms_mask_present)
-    {
-        pns_decode(ics1, ics2, spec_coef1, spec_coef2, hDecoder->frameLength, 1, hDecoder->object_type,
-            &(hDecoder->__r1), &(hDecoder->__r2));
-    } else {
-        pns_decode(ics1, ics2, spec_coef1, spec_coef2, hDecoder->frameLength, 0, hDecoder->object_type,
-            &(hDecoder->__r1), &(hDecoder->__r2));
-    }
+    hDecoder->rng_draws += pns_decode(ics, NULL, spec_coef, NULL, hDecoder->frameLength, 0, hDecoder->object_type,
+        &(hDecoder->__r1), &(hDecoder->__r2));
 
-    /* mid/side decoding */
-    ms_decode(ics1, ics2, spec_coef1, spec_coef2, hDecoder->frameLength);
+#ifdef SBR_DEC
+    retval = sbr_element_setup(hDecoder, hDecoder->fr_ch_ele, sce);
+    if (retval > 0)
+        return retval;
+#endif
 
-#if 0
+    if (job != NULL)
     {
-        int i;
-        for (i = 0; i < 1024; i++)
-        {
-            //printf("%d\n", spec_coef1[i]);
-            printf("0x%.8X\n", spec_coef1[i]);
-        }
-        for (i = 0; i < 1024; i++)
-        {
-            //printf("%d\n", spec_coef2[i]);
-            printf("0x%.8X\n", spec_coef2[i]);
-        }
+        /* the rest is done by reconstruct_elements() */
+        job->ele = *sce;
+        job->ele.ics1 = *ics;
+        job->paired = 0;
+        hDecoder->fr_job->num_ele_jobs++;
+        return 0;
     }
-#endif
 
-    /* intensity stereo decoding */
-    is_decode(ics1, ics2, spec_coef1, spec_coef2, hDecoder->frameLength);
+    return single_channel_synthesis(hDecoder, hDecoder->drc, hDecoder->fr_ch_ele,
+        ics, sce, spec_coef, 0);
+}
 
-#if 0
-    {
-        int i;
-        for (i = 0; i < 1024; i++)
-        {
-            printf("%d\n", spec_coef1[i]);
-            //printf("0x%.8X\n", spec_coef1[i]);
-        }
-        for (i = 0; i < 1024; i++)
-        {
-            printf("%d\n", spec_coef2[i]);
-            //printf("0x%.8X\n", spec_coef2[i]);
-        }
-    }
+/* second half of the reconstruction of a channel pair element, only
+   touches the state of the element's own channels */
+static uint8_t channel_pair_synthesis(NeAACDecStruct *hDecoder, drc_info *drc,
+                                      uint8_t ele, ic_stream *ics1, ic_stream *ics2,
+                                      element *cpe, real_t *spec_coef1, real_t *spec_coef2,
+                                      uint8_t spectral_dm)
+{
+#ifdef SBR_DEC
+    uint8_t retval;
+    /* selected again after being masked, SBR starts as after a seek */
+    uint8_t restart = hDecoder->element_masked[ele];
 #endif
 
+    hDecoder->element_masked[ele] = 0;
+
 #ifdef MAIN_DEC
     /* MAIN object type prediction */
     if (hDecoder->object_type == MAIN)
@@ -1253,27 +1541,25 @@ uint8_t reconstruct_channel_pair(NeAACDecStruct *hDecoder, ic_stream *ics1, ic_s
         spec_coef2, hDecoder->frameLength);
 
     /* drc decoding */
-    if (hDecoder->drc->present)
+    if (drc->present)
     {
-        if (!hDecoder->drc->exclude_mask[cpe->channel] || !hDecoder->drc->excluded_chns_present)
-            drc_decode(hDecoder->drc, spec_coef1);
-        if (!hDecoder->drc->exclude_mask[cpe->paired_channel] || !hDecoder->drc->excluded_chns_present)
-            drc_decode(hDecoder->drc, spec_coef2);
+        if (!drc->exclude_mask[cpe->channel] || !drc->excluded_chns_present)
+            drc_decode(drc, spec_coef1);
+        if (!drc->exclude_mask[cpe->paired_channel] || !drc->excluded_chns_present)
+            drc_decode(drc, spec_coef2);
     }
 
+    /* a frame mixed before the filter bank is finished by spectral_downmix() */
+    if (spectral_dm)
+        return 0;
+
     /* filter bank */
 #ifdef SSR_DEC
     if (hDecoder->object_type != SSR)
     {
 #endif
-        ifilter_bank(hDecoder->fb, ics1->window_sequence, ics1->window_shape,
-            hDecoder->window_shape_prev[cpe->channel], spec_coef1,
-            hDecoder->time_out[cpe->channel], hDecoder->fb_intermed[cpe->channel],
-            hDecoder->object_type, hDecoder->frameLength);
-        ifilter_bank(hDecoder->fb, ics2->window_sequence, ics2->window_shape,
-            hDecoder->window_shape_prev[cpe->paired_channel], spec_coef2,
-            hDecoder->time_out[cpe->paired_channel], hDecoder->fb_intermed[cpe->paired_channel],
-            hDecoder->object_type, hDecoder->frameLength);
+        channel_filter_bank(hDecoder, ics1, spec_coef1, cpe->channel);
+        channel_filter_bank(hDecoder, ics2, spec_coef2, cpe->paired_channel);
 #ifdef SSR_DEC
     } else {
         ssr_decode(&(ics1->ssr), hDecoder->fb, ics1->window_sequence, ics1->window_shape,
@@ -1303,42 +1589,496 @@ uint8_t reconstruct_channel_pair(NeAACDecStruct *hDecoder, ic_stream *ics1, ic_s
 
 #ifdef SBR_DEC
     if (((hDecoder->sbr_present_flag == 1) || (hDecoder->forceUpSampling == 1))
-        && hDecoder->sbr_alloced[hDecoder->fr_ch_ele])
+        && hDecoder->sbr_alloced[ele])
     {
-        int ele = hDecoder->fr_ch_ele;
         int ch0 = cpe->channel;
         int ch1 = cpe->paired_channel;
 
-        /* following case can happen when forceUpSampling == 1 */
-        if (hDecoder->sbr[ele] == NULL)
-        {
-            hDecoder->sbr[ele] = sbrDecodeInit(hDecoder->frameLength,
-                hDecoder->element_id[ele], 2*get_sample_rate(hDecoder->sf_index),
-                hDecoder->downSampledSBR
-#ifdef DRM
-                , 0
+        retval = sbrDecodeCoupleFrame(hDecoder->sbr[ele],
+            hDecoder->time_out[ch0], hDecoder->time_out[ch1],
+            hDecoder->postSeekResetFlag || restart, hDecoder->downSampledSBR);
+        if (retval > 0)
+            return retval;
+    }
 #endif
-                );
-        }
-        if (!hDecoder->sbr[ele])
-            return 19;
 
-        if (cpe->ics1.window_sequence == EIGHT_SHORT_SEQUENCE)
-            hDecoder->sbr[ele]->maxAACLine = 8*min(cpe->ics1.swb_offset[max(cpe->ics1.max_sfb-1, 0)], cpe->ics1.swb_offset_max);
-        else
-            hDecoder->sbr[ele]->maxAACLine = min(cpe->ics1.swb_offset[max(cpe->ics1.max_sfb-1, 0)], cpe->ics1.swb_offset_max);
+    return 0;
+}
 
-        retval = sbrDecodeCoupleFrame(hDecoder->sbr[ele],
-            hDecoder->time_out[ch0], hDecoder->time_out[ch1],
-            hDecoder->postSeekResetFlag, hDecoder->downSampledSBR);
+uint8_t reconstruct_channel_pair(NeAACDecStruct *hDecoder, ic_stream *ics1, ic_stream *ics2,
+                                 element *cpe, int16_t *spec_data1, int16_t *spec_data2)
+{
+    uint8_t retval, masked;
+    ALIGN real_t spec_coef_buf1[1024];
+    ALIGN real_t spec_coef_buf2[1024];
+    real_t *spec_coef1 = spec_coef_buf1;
+    real_t *spec_coef2 = spec_coef_buf2;
+    element_job *job = NULL;
+
+#ifdef PROFILE
+    int64_t count = faad_get_ts();
+#endif
+    if (hDecoder->element_alloced[hDecoder->fr_ch_ele] != 2)
+    {
+        /* the element's channels are about to change */
+        finish_synthesis(hDecoder);
+
+        retval = allocate_channel_pair(hDecoder, cpe->channel, (uint8_t)cpe->paired_channel);
         if (retval > 0)
             return retval;
-    } else if (((hDecoder->sbr_present_flag == 1) || (hDecoder->forceUpSampling == 1))
-        && !hDecoder->sbr_alloced[hDecoder->fr_ch_ele])
+
+        hDecoder->element_alloced[hDecoder->fr_ch_ele] = 2;
+    }
+
+    /* sanity check, CVE-2018-20199, CVE-2018-20360 */
+    if(!hDecoder->time_out[cpe->channel] || !hDecoder->time_out[cpe->paired_channel])
+        return 15;
+    if(!hDecoder->fb_intermed[cpe->channel] || !hDecoder->fb_intermed[cpe->paired_channel])
+        return 15;
+
+    masked = element_outside_mask(hDecoder, cpe, 1, 2);
+
+    /* FAAD_DOWNMIX_SPECTRAL needs the spectra of all elements at once,
+       also in the frame after the last mixed one */
+    if (hDecoder->defer_elements || hDecoder->dm_parsed ||
+        (hDecoder->config.downMatrix == FAAD_DOWNMIX_SPECTRAL))
     {
-        return 23;
+        job = get_element_job(hDecoder);
+        if (job == NULL)
+            return 15;
+        spec_coef1 = job->spec_coef1;
+        spec_coef2 = job->spec_coef2;
+        job->masked = masked;
+    }
+
+    /* the element was parsed to stay in sync, only its noise is drawn so
+       the generator shared by all channels stays in step */
+    if (masked)
+    {
+        hDecoder->rng_draws += pns_decode(ics1, ics2, spec_coef1, spec_coef2, hDecoder->frameLength,
+            (ics1->ms_mask_present) ? 1 : 0, hDecoder->object_type,
+            &(hDecoder->__r1), &(hDecoder->__r2));
+        if (job != NULL)
+        {
+            job->ele = *cpe;
+            job->paired = 1;
+            hDecoder->fr_job->num_ele_jobs++;
+        } else {
+            mask_element(hDecoder, hDecoder->fr_ch_ele, cpe, 1);
+        }
+        return 0;
     }
+
+    /* dequantisation and scaling */
+    retval = quant_to_spec(hDecoder, ics1, spec_data1, spec_coef1, hDecoder->frameLength);
+    if (retval > 0)
+        return retval;
+    retval = quant_to_spec(hDecoder, ics2, spec_data2, spec_coef2, hDecoder->frameLength);
+    if (retval > 0)
+        return retval;
+
+#ifdef PROFILE
+    count = faad_get_ts() - count;
+    hDecoder->requant_cycles += count;
 #endif
 
-    return 0;
+    /* pns decoding */
+    if (ics1->ms_mask_present)
+    {
+        hDecoder->rng_draws += pns_decode(ics1, ics2, spec_coef1, spec_coef2, hDecoder->frameLength, 1, hDecoder->object_type,
+            &(hDecoder->__r1), &(hDecoder->__r2));
+    } else {
+        hDecoder->rng_draws += pns_decode(ics1, ics2, spec_coef1, spec_coef2, hDecoder->frameLength, 0, hDecoder->object_type,
+            &(hDecoder->__r1), &(hDecoder->__r2));
+    }
+
+    /* mid/side decoding */
+    ms_decode(ics1, ics2, spec_coef1, spec_coef2, hDecoder->frameLength);
+
+#if 0
+    {
+        int i;
+        for (i = 0; i < 1024; i++)
+        {
+            //printf("%d\n", spec_coef1[i]);
+            printf("0x%.8X\n", spec_coef1[i]);
+        }
+        for (i = 0; i < 1024; i++)
+        {
+            //printf("%d\n", spec_coef2[i]);
+            printf("0x%.8X\n", spec_coef2[i]);
+        }
+    }
+#endif
+
+    /* intensity stereo decoding */
+    is_decode(ics1, ics2, spec_coef1, spec_coef2, hDecoder->frameLength);
+
+#if 0
+    {
+        int i;
+        for (i = 0; i < 1024; i++)
+        {
+            printf("%d\n", spec_coef1[i]);
+            //printf("0x%.8X\n", spec_coef1[i]);
+        }
+        for (i = 0; i < 1024; i++)
+        {
+            printf("%d\n", spec_coef2[i]);
+            //printf("0x%.8X\n", spec_coef2[i]);
+        }
+    }
+#endif
+
+#ifdef SBR_DEC
+    retval = sbr_element_setup(hDecoder, hDecoder->fr_ch_ele, cpe);
+    if (retval > 0)
+        return retval;
+#endif
+
+    if (job != NULL)
+    {
+        /* the rest is done by reconstruct_elements() */
+        job->ele = *cpe;
+        job->ele.ics1 = *ics1;
+        job->ele.ics2 = *ics2;
+        job->paired = 1;
+        hDecoder->fr_job->num_ele_jobs++;
+        return 0;
+    }
+
+    return channel_pair_synthesis(hDecoder, hDecoder->drc, hDecoder->fr_ch_ele,
+        ics1, ics2, cpe, spec_coef1, spec_coef2, 0);
+}
+
+#ifdef FIXED_POINT
+#define DM_MUL FRAC_CONST(0.3203772410170407) // 1/(1+sqrt(2) + 1/sqrt(2))
+#define RSQRT2 FRAC_CONST(0.7071067811865475244) // 1/sqrt(2)
+#else
+#define DM_MUL REAL_CONST(0.3203772410170407) // 1/(1+sqrt(2) + 1/sqrt(2))
+#define RSQRT2 REAL_CONST(0.7071067811865475244) // 1/sqrt(2)
+#endif
+
+/* one side of the 5.1 to stereo downmix, the same as get_sample() */
+static INLINE real_t downmix_side(real_t front, real_t center, real_t surround)
+{
+#ifdef FIXED_POINT
+    return MUL_F(front + MUL_F(center, RSQRT2) + MUL_F(surround, RSQRT2), DM_MUL);
+#else
+    return DM_MUL * (front + center * RSQRT2 + surround * RSQRT2);
+#endif
+}
+
+/* mixes C, L, R, Ls and Rs in in[0..4] to left and right, which may be
+   any of the inputs */
+static void downmix_buffers(real_t *left, real_t *right, real_t **in, uint16_t len)
+{
+    uint16_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        real_t l = downmix_side(in[1][i], in[0][i], in[3][i]);
+        real_t r = downmix_side(in[2][i], in[0][i], in[4][i]);
+
+        left[i] = l;
+        right[i] = r;
+    }
+}
+
+/* decides whether the frame just parsed is mixed to stereo before the
+   filter bank (FAAD_DOWNMIX_SPECTRAL); needs the spectra of the five main
+   channels and no tool working on the time signal of a channel. When the
+   downmix goes back to the time domain, the first frame is still mixed
+   here, as only the mixed overlap is known. */
+uint8_t spectral_downmix_setup(NeAACDecStruct *hDecoder, frame_job *fj)
+{
+    uint8_t i, k;
+    uint8_t mixed = hDecoder->dm_parsed;
+
+    hDecoder->dm_parsed = 0;
+    fj->dm_last = (hDecoder->config.downMatrix != FAAD_DOWNMIX_SPECTRAL);
+    if ((fj->dm_last && (!mixed || !hDecoder->config.downMatrix)) ||
+        ((hDecoder->fr_channels != 5) && (hDecoder->fr_channels != 6)))
+    {
+        return 0;
+    }
+#ifdef LTP_DEC
+    if (is_ltp_ot(hDecoder->object_type))
+        return 0;
+#endif
+#ifdef SSR_DEC
+    if (hDecoder->object_type == SSR)
+        return 0;
+#endif
+#ifdef SBR_DEC
+    if ((hDecoder->sbr_present_flag == 1) || (hDecoder->forceUpSampling == 1))
+        return 0;
+#endif
+
+    for (k = 0; k < 5; k++)
+    {
+        uint8_t ch = hDecoder->internal_channel[k];
+
+        fj->dm_channel[k] = ch;
+        fj->dm_spec[k] = NULL;
+        for (i = 0; i < fj->num_ele_jobs; i++)
+        {
+            element_job *job = fj->ele_job[i];
+
+            if (job->masked)
+                continue;
+            if (job->ele.channel == ch)
+            {
+                fj->dm_spec[k] = job->spec_coef1;
+                fj->dm_ics[k] = &(job->ele.ics1);
+            } else if (job->paired && (job->ele.paired_channel == ch)) {
+                fj->dm_spec[k] = job->spec_coef2;
+                fj->dm_ics[k] = &(job->ele.ics2);
+            }
+        }
+        if (fj->dm_spec[k] == NULL)
+            return 0;
+    }
+
+    for (k = 0; k < 2; k++)
+    {
+        if (hDecoder->dm_overlap[k] == NULL)
+        {
+            hDecoder->dm_overlap[k] = (real_t*)faad_malloc(hDecoder->frameLength*sizeof(real_t));
+            if (hDecoder->dm_overlap[k] == NULL)
+                return 0;
+            hDecoder->dm_overlap_valid = 0;
+        }
+    }
+
+    hDecoder->dm_parsed = !fj->dm_last;
+    return 1;
+}
+
+/* filter bank of a frame mixed by FAAD_DOWNMIX_SPECTRAL; the stereo pair is
+   written to the output of the first two channels, which are then converted
+   like a stereo frame. The overlap is kept mixed, so when the windows of the
+   channels differ they are transformed one by one and mixed afterwards. */
+static void spectral_downmix(NeAACDecStruct *hDecoder, frame_job *fj)
+{
+    uint8_t *ch = fj->dm_channel;
+    ic_stream **ics = fj->dm_ics;
+    real_t *buf[5];
+    uint16_t i, len = hDecoder->frameLength;
+    uint8_t k, match = !fj->dm_last;
+
+    /* the first mixed frame starts from the overlap of the channels */
+    if (!hDecoder->dm_overlap_valid)
+    {
+        for (k = 0; k < 5; k++)
+            buf[k] = hDecoder->fb_intermed[ch[k]];
+        downmix_buffers(hDecoder->dm_overlap[0], hDecoder->dm_overlap[1], buf, len);
+        hDecoder->dm_overlap_valid = 1;
+    }
+
+    for (k = 1; k < 5; k++)
+    {
+        if ((ics[k]->window_sequence != ics[0]->window_sequence) ||
+            (ics[k]->window_shape != ics[0]->window_shape) ||
+            (hDecoder->window_shape_prev[ch[k]] != hDecoder->window_shape_prev[ch[0]]))
+        {
+            match = 0;
+        }
+    }
+
+    if (match)
+    {
+        /* the IMDCT is linear, only the mixed pair is transformed */
+        downmix_buffers(fj->dm_spec[1], fj->dm_spec[2], fj->dm_spec, len);
+
+        for (k = 0; k < 2; k++)
+        {
+            ifilter_bank(hDecoder->fb, ics[0]->window_sequence, ics[0]->window_shape,
+                hDecoder->window_shape_prev[ch[0]], fj->dm_spec[k+1],
+                hDecoder->time_out[ch[k]], hDecoder->dm_overlap[k],
+                hDecoder->object_type, len);
+        }
+    } else {
+        /* each channel without overlap, the mixed overlap is added after */
+        for (k = 0; k < 5; k++)
+        {
+            memset(hDecoder->fb_intermed[ch[k]], 0, len*sizeof(real_t));
+            hDecoder->fb_intermed_zero[ch[k]] = 1;
+            channel_filter_bank(hDecoder, ics[k], fj->dm_spec[k], ch[k]);
+            buf[k] = hDecoder->time_out[ch[k]];
+        }
+        downmix_buffers(buf[0], buf[1], buf, len);
+        for (i = 0; i < len; i++)
+        {
+            buf[0][i] += hDecoder->dm_overlap[0][i];
+            buf[1][i] += hDecoder->dm_overlap[1][i];
+        }
+
+        /* the channels continue from their own overlap after the last frame */
+        if (fj->dm_last)
+        {
+            hDecoder->dm_overlap_valid = 0;
+        } else {
+            for (k = 0; k < 5; k++)
+                buf[k] = hDecoder->fb_intermed[ch[k]];
+            downmix_buffers(hDecoder->dm_overlap[0], hDecoder->dm_overlap[1], buf, len);
+        }
+    }
+
+    /* save window shape for next frame */
+    for (i = 0; i < fj->num_ele_jobs; i++)
+    {
+        element_job *job = fj->ele_job[i];
+
+        hDecoder->window_shape_prev[job->ele.channel] = job->ele.ics1.window_shape;
+        if (job->paired)
+            hDecoder->window_shape_prev[job->ele.paired_channel] = job->ele.ics2.window_shape;
+    }
+}
+
+static void element_synthesis(void *data, unsigned long index)
+{
+    NeAACDecStruct *hDecoder = (NeAACDecStruct*)data;
+    frame_job *fj = hDecoder->syn_frame;
+    element_job *job = fj->ele_job[index];
+
+    if (job->masked)
+    {
+        mask_element(hDecoder, job->ele_index, &(job->ele), job->paired);
+        job->error = 0;
+    } else if (job->paired) {
+        job->error = channel_pair_synthesis(hDecoder, fj->drc, job->ele_index,
+            &(job->ele.ics1), &(job->ele.ics2), &(job->ele),
+            job->spec_coef1, job->spec_coef2, fj->spectral_dm);
+    } else {
+        job->error = single_channel_synthesis(hDecoder, fj->drc, job->ele_index,
+            &(job->ele.ics1), &(job->ele), job->spec_coef1, fj->spectral_dm);
+    }
+}
+
+/* finishes the elements of a frame that was parsed with deferred
+   reconstruction; the elements only share read only data so they are
+   spread over the element threads. Returns the error of the first
+   failing element. */
+uint8_t reconstruct_elements(NeAACDecStruct *hDecoder, frame_job *fj)
+{
+    uint8_t i, error = 0;
+
+    /* after a mixed frame the overlap of each channel is stale, and the
+       mixed overlap cannot be split up again */
+    if (!fj->spectral_dm && hDecoder->dm_overlap_valid)
+    {
+        for (i = 0; i < MAX_CHANNELS; i++)
+        {
+            if (hDecoder->fb_intermed[i] != NULL)
+            {
+                memset(hDecoder->fb_intermed[i], 0, hDecoder->frameLength*sizeof(real_t));
+                hDecoder->fb_intermed_zero[i] = 1;
+            }
+        }
+        hDecoder->dm_overlap_valid = 0;
+    }
+
+    if (fj->num_ele_jobs == 0)
+        return 0;
+
+    hDecoder->syn_frame = fj;
+    if (hDecoder->run_jobs != NULL)
+    {
+        hDecoder->run_jobs(hDecoder->run_jobs_data, element_synthesis, hDecoder,
+            fj->num_ele_jobs);
+    } else {
+        faad_pool_run(hDecoder->ele_pool, element_synthesis, hDecoder,
+            fj->num_ele_jobs);
+    }
+
+    for (i = 0; i < fj->num_ele_jobs; i++)
+    {
+        if (error == 0)
+            error = fj->ele_job[i]->error;
+    }
+
+    if (fj->spectral_dm)
+    {
+        if (error == 0)
+            spectral_downmix(hDecoder, fj);
+        else
+            hDecoder->dm_overlap_valid = 0;
+    }
+
+    fj->num_ele_jobs = 0;
+
+    return error;
+}
+
+static void frame_synthesis(void *data, unsigned long index)
+{
+    NeAACDecStruct *hDecoder = (NeAACDecStruct*)data;
+    frame_job *fj = hDecoder->pending_frame;
+
+    (void)index;
+    fj->error = reconstruct_elements(hDecoder, fj);
+}
+
+/* batch pipeline: hands the frame that was just parsed to the synthesis
+   thread, its output is written by finish_synthesis() */
+void start_synthesis(NeAACDecStruct *hDecoder, NeAACDecFrameInfo *hInfo)
+{
+    frame_job *fj = hDecoder->fr_job;
+
+    /* SBR data is parsed into the state the synthesis works on */
+#ifdef SBR_DEC
+    uint8_t overlap = !((hDecoder->sbr_present_flag == 1) || (hDecoder->forceUpSampling == 1));
+#else
+    uint8_t overlap = 1;
+#endif
+
+    hDecoder->pending_frame = fj;
+    hDecoder->pending_info = hInfo;
+    faad_pool_start(hDecoder->syn_pool, frame_synthesis, hDecoder, 1);
+
+    /* the next frame goes into the other descriptor */
+    hDecoder->fr_job = (fj == &hDecoder->frame_jobs[0]) ?
+        &hDecoder->frame_jobs[1] : &hDecoder->frame_jobs[0];
+
+    if (!overlap)
+        finish_synthesis(hDecoder);
+}
+
+/* waits for the frame handed to the synthesis thread, if any, and converts
+   its output; called before the parser touches anything the synthesis
+   reads */
+void finish_synthesis(NeAACDecStruct *hDecoder)
+{
+    frame_job *fj = hDecoder->pending_frame;
+    uint8_t internal_channel[MAX_CHANNELS];
+    uint8_t downMatrix, upMatrix;
+
+    if (fj == NULL)
+        return;
+
+    faad_pool_wait(hDecoder->syn_pool);
+    hDecoder->pending_frame = NULL;
+
+    if (fj->error > 0)
+    {
+        hDecoder->pending_info->error = fj->error;
+        return;
+    }
+
+    /* output_to_PCM() works on the channel mapping of the decoder, which
+       may already belong to the frame being parsed */
+    downMatrix = hDecoder->downMatrix;
+    upMatrix = hDecoder->upMatrix;
+    memcpy(internal_channel, hDecoder->internal_channel, MAX_CHANNELS*sizeof(uint8_t));
+    hDecoder->downMatrix = fj->downMatrix;
+    hDecoder->upMatrix = fj->upMatrix;
+    memcpy(hDecoder->internal_channel, fj->internal_channel, MAX_CHANNELS*sizeof(uint8_t));
+
+    output_to_PCM(hDecoder, hDecoder->time_out, fj->sample_buffer,
+        fj->output_channels, fj->frame_len, hDecoder->config.outputFormat);
+
+    hDecoder->downMatrix = downMatrix;
+    hDecoder->upMatrix = upMatrix;
+    memcpy(hDecoder->internal_channel, internal_channel, MAX_CHANNELS*sizeof(uint8_t));
 }
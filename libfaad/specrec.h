@@ -42,6 +42,10 @@ uint8_t reconstruct_channel_pair(NeAACDecStruct *hDecoder, ic_stream *ics1, ic_s
                                  element *cpe, int16_t *spec_data1, int16_t *spec_data2);
 uint8_t reconstruct_single_channel(NeAACDecStruct *hDecoder, ic_stream *ics, element *sce,
                                 int16_t *spec_data);
+uint8_t spectral_downmix_setup(NeAACDecStruct *hDecoder, frame_job *fj);
+uint8_t reconstruct_elements(NeAACDecStruct *hDecoder, frame_job *fj);
+void start_synthesis(NeAACDecStruct *hDecoder, NeAACDecFrameInfo *hInfo);
+void finish_synthesis(NeAACDecStruct *hDecoder);
 
 #ifdef __cplusplus
 }
@@ -36,6 +36,7 @@ extern "C" {
 #endif
 
 #include "cfft.h"
+#include "threads.h"
 #ifdef SBR_DEC
 #include "sbr_dec.h"
 #endif
@@ -312,6 +313,70 @@ typedef struct
     ic_stream ics2;
 } element; /* syntax element (SCE, CPE, LFE) */
 
+/* a parsed element waiting for the rest of its reconstruction */
+typedef struct
+{
+    element ele;
+    uint8_t ele_index;
+    uint8_t paired;
+    uint8_t error;
+    /* outside of the channel mask, only silenced */
+    uint8_t masked;
+
+    ALIGN real_t spec_coef1[1024];
+    ALIGN real_t spec_coef2[1024];
+} element_job;
+
+/* the parsed elements of a frame, also the frame descriptor handed from
+   the parsing to the synthesis stage of the batch pipeline */
+typedef struct
+{
+    uint8_t num_ele_jobs;
+    element_job *ele_job[MAX_SYNTAX_ELEMENTS];
+    drc_info *drc;
+    uint8_t error;
+
+    /* pipelined frames: the decoder state the frame was parsed with */
+    drc_info drc_state;
+    void *sample_buffer;
+    uint16_t frame_len;
+    uint8_t output_channels;
+    uint8_t downMatrix;
+    uint8_t upMatrix;
+    uint8_t internal_channel[MAX_CHANNELS];
+
+    /* FAAD_DOWNMIX_SPECTRAL: the frame is mixed by spectral_downmix(), the
+       channels, spectra and streams of C, L, R, Ls and Rs */
+    uint8_t spectral_dm;
+    /* the stereo downmix of the frame after the last mixed one, it goes back
+       to the overlap of each channel */
+    uint8_t dm_last;
+    uint8_t dm_channel[5];
+    real_t *dm_spec[5];
+    ic_stream *dm_ics[5];
+} frame_job;
+
+/* the output layout of a frame, only rebuilt when the stream configuration
+   it is made from changes, see frame_layout_update() */
+typedef struct
+{
+    /* the configuration the layout was made for */
+    uint8_t fr_channels;
+    uint8_t channelConfiguration;
+    uint8_t has_lfe;
+    uint8_t first_syn_ele;
+    uint8_t downMatrix_cfg;
+    uint8_t outputFormat;
+    uint8_t ps_used;
+    int8_t sbr_present_flag;
+
+    uint8_t output_channels;
+    uint16_t frame_len;
+    uint32_t frame_bytes; /* size of the output of a frame */
+    /* the channel, format and stream fields of the frame info */
+    NeAACDecFrameInfo info;
+} frame_layout;
+
 #define MAX_ASC_BYTES 64
 typedef struct {
     int inited;
@@ -360,6 +425,9 @@ typedef struct
        determines the number of channels the element will output
     */
     uint8_t element_output_channels[MAX_SYNTAX_ELEMENTS];
+    /* the element is outside of config.channelMask and its channels hold
+       silence and cleared state */
+    uint8_t element_masked[MAX_SYNTAX_ELEMENTS];
     /* element_alloced:
        determines whether the data needed for the element is allocated or not
     */
@@ -368,6 +436,15 @@ typedef struct
        determines the number of channels where output data is allocated for
     */
     uint8_t alloced_channels;
+    /* output_channels:
+       number of channels output by the last successfully decoded frame
+    */
+    uint8_t output_channels;
+    /* layout_valid:
+       cleared when the stream is (re)initialised or a PCE is read
+    */
+    uint8_t layout_valid;
+    frame_layout layout;
 
     /* output data buffer */
     void *sample_buffer;
@@ -381,6 +458,14 @@ typedef struct
 
     real_t *time_out[MAX_CHANNELS];
     real_t *fb_intermed[MAX_CHANNELS];
+    /* fb_intermed holds only zeros, a silent frame needs no IMDCT then */
+    uint8_t fb_intermed_zero[MAX_CHANNELS];
+    /* FAAD_DOWNMIX_SPECTRAL: overlap of the two mixed channels, valid while
+       consecutive frames are mixed */
+    real_t *dm_overlap[2];
+    uint8_t dm_overlap_valid;
+    /* the last parsed frame is mixed, see spectral_downmix_setup() */
+    uint8_t dm_parsed;
 
 #ifdef SBR_DEC
     int8_t sbr_present_flag;
@@ -388,6 +473,8 @@ typedef struct
     int8_t downSampledSBR;
     /* determines whether SBR data is allocated for the gives element */
     uint8_t sbr_alloced[MAX_SYNTAX_ELEMENTS];
+    /* config.dontDecodeSBR at init: SBR and PS payloads are skipped */
+    uint8_t core_only;
 
     sbr_info *sbr[MAX_SYNTAX_ELEMENTS];
 #endif
@@ -416,6 +503,14 @@ typedef struct
     /* RNG states */
     uint32_t __r1;
     uint32_t __r2;
+    /* values drawn from them, see NeAACDecDecodeSegments() */
+    uint32_t rng_draws;
+    /* xorshift32 states of the output dither, see FAAD_FMT_16BIT_DITHER */
+    uint32_t dither_state[4];
+#ifdef SIMD_AVX2
+    /* cpu_has_avx2(), selects the inverse quantisation version */
+    uint8_t use_avx2;
+#endif
 
     /* Program Config Element */
     uint8_t pce_set;
@@ -426,6 +521,26 @@ typedef struct
     /* Configuration data */
     NeAACDecConfiguration config;
 
+    /* memory allocation */
+    faad_allocator allocator;
+
+    /* deferred element reconstruction, see NeAACDecSetElementThreads() */
+    uint8_t defer_elements;
+    frame_job *fr_job; /* frame being parsed */
+    frame_job *syn_frame; /* frame being synthesized */
+    frame_job frame_jobs[2];
+    faad_pool *ele_pool;
+    NeAACDecRunJobsFunc run_jobs;
+    void *run_jobs_data;
+
+    /* two stage batch pipeline, see NeAACDecSetBatchPipeline() */
+    uint8_t pipelined;
+    /* NeAACDecDecodeBatch() clears the frame infos and handles ID3 tags */
+    uint8_t batched;
+    faad_pool *syn_pool;
+    frame_job *pending_frame;
+    NeAACDecFrameInfo *pending_info;
+
 #ifdef PROFILE
     int64_t cycles;
     int64_t spectral_cycles;
@@ -504,6 +504,7 @@ void raw_data_block(NeAACDecStruct *hDecoder, NeAACDecFrameInfo *hInfo,
                 /* 14496-4: 5.6.4.1.2.1.3: */
                 /* program_configuration_element()'s in access units shall be ignored */
                 program_config_element(pce, ld);
+                hDecoder->layout_valid = 0;
                 //if ((hInfo->error = program_config_element(pce, ld)) > 0)
                 //    return;
                 //hDecoder->pce_set = 1;
@@ -1106,12 +1107,17 @@ static uint8_t fill_element(NeAACDecStruct *hDecoder, bitfile *ld, drc_info *drc
 #ifdef SBR_DEC
         bs_extension_type = (uint8_t)faad_showbits(ld, 4);
 
-        if ((bs_extension_type == EXT_SBR_DATA) ||
-            (bs_extension_type == EXT_SBR_DATA_CRC))
+        /* in the core only mode SBR data is skipped like any other
+           extension payload */
+        if (((bs_extension_type == EXT_SBR_DATA) ||
+            (bs_extension_type == EXT_SBR_DATA_CRC)) && !hDecoder->core_only)
         {
             if (sbr_ele == INVALID_SBR_ELEMENT)
                 return 24;
 
+            /* the SBR state is shared with the synthesis of the previous frame */
+            finish_synthesis(hDecoder);
+
             if (!hDecoder->sbr[sbr_ele])
             {
                 hDecoder->sbr[sbr_ele] = sbrDecodeInit(hDecoder->frameLength,
@@ -2122,7 +2128,7 @@ static uint8_t spectral_data(NeAACDecStruct *hDecoder, ic_stream *ics, bitfile *
 {
     int8_t i;
     uint8_t g;
-    uint16_t inc, k, p = 0;
+    uint16_t len, p = 0;
     uint8_t groups = 0;
     uint8_t sect_cb;
     uint8_t result;
@@ -2140,8 +2146,6 @@ static uint8_t spectral_data(NeAACDecStruct *hDecoder, ic_stream *ics, bitfile *
         {
             sect_cb = ics->sect_cb[g][i];
 
-            inc = (sect_cb >= FIRST_PAIR_HCB) ? 2 : 4;
-
             switch (sect_cb)
             {
             case ZERO_HCB:
@@ -2169,22 +2173,20 @@ static uint8_t spectral_data(NeAACDecStruct *hDecoder, ic_stream *ics, bitfile *
 #ifdef SFBO_PRINT
                 printf("%d\n", ics->sect_sfb_offset[g][ics->sect_start[g][i]]);
 #endif
-                for (k = ics->sect_sfb_offset[g][ics->sect_start[g][i]];
-                     k < ics->sect_sfb_offset[g][ics->sect_end[g][i]]; k += inc)
-                {
-                    if ((result = huffman_spectral_data(sect_cb, ld, &spectral_data[p])) > 0)
-                        return result;
+                len = ics->sect_sfb_offset[g][ics->sect_end[g][i]] -
+                    ics->sect_sfb_offset[g][ics->sect_start[g][i]];
+                if ((result = huffman_spectral_section(sect_cb, ld, &spectral_data[p], len)) > 0)
+                    return result;
 #ifdef SD_PRINT
+                {
+                    int j;
+                    for (j = p; j < p+len; j++)
                     {
-                        int j;
-                        for (j = p; j < p+inc; j++)
-                        {
-                            printf("%d\n", spectral_data[j]);
-                        }
+                        printf("%d\n", spectral_data[j]);
                     }
-#endif
-                    p += inc;
                 }
+#endif
+                p += len;
                 break;
             }
         }
@@ -2663,7 +2665,7 @@ uint32_t faad_latm_frame(latm_header *latm, bitfile *ld)
     uint32_t initpos, endpos, firstpos, ret;
 
     firstpos = faad_get_processed_bits(ld);
-    while (ld->bytes_left)
+    while (faad_get_processed_bits(ld) < 8*ld->buffer_size)
     {
         faad_byte_align(ld);
         if(faad_showbits(ld, 11) != 0x2B7)
@@ -0,0 +1,296 @@
+/*
+** FAAD2 - Freeware Advanced Audio (AAC) Decoder including SBR decoding
+** Copyright (C) 2003-2005 M. Bakker, Nero AG, http://www.nero.com
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**
+** Any non-GPL usage of this software or parts of this software is strictly
+** forbidden.
+**
+** The "appropriate copyright message" mentioned in section 2c of the GPLv2
+** must read: "Code from FAAD2 is copyright (c) Nero AG, www.nero.com"
+**
+** Commercial non-GPL licensing of this software is possible.
+** For more info contact Nero AG through Mpeg4AAClicense@nero.com.
+**
+** $Id$
+**/
+
+#include "common.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <process.h>
+#endif
+
+#include "threads.h"
+
+
+void faad_mutex_lock(faad_mutex *mutex)
+{
+#if defined(_WIN32)
+    AcquireSRWLockExclusive((PSRWLOCK)mutex);
+#elif defined(HAVE_PTHREAD_H)
+    pthread_mutex_lock(mutex);
+#else
+    (void)mutex;
+#endif
+}
+
+void faad_mutex_unlock(faad_mutex *mutex)
+{
+#if defined(_WIN32)
+    ReleaseSRWLockExclusive((PSRWLOCK)mutex);
+#elif defined(HAVE_PTHREAD_H)
+    pthread_mutex_unlock(mutex);
+#else
+    (void)mutex;
+#endif
+}
+
+#if defined(_WIN32) || defined(HAVE_PTHREAD_H)
+
+struct faad_pool
+{
+#if defined(_WIN32)
+    SRWLOCK lock;
+    CONDITION_VARIABLE wake;
+    CONDITION_VARIABLE done;
+    HANDLE *threads;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    pthread_t *threads;
+#endif
+    unsigned int num_threads;
+
+    /* current batch, protected by lock */
+    faad_job_func job;
+    void *data;
+    unsigned long num_jobs;
+    unsigned long next_job;
+    unsigned long jobs_left;
+    uint8_t quit;
+};
+
+#if defined(_WIN32)
+#define pool_lock(p)   AcquireSRWLockExclusive(&(p)->lock)
+#define pool_unlock(p) ReleaseSRWLockExclusive(&(p)->lock)
+#define pool_wait(p,c) SleepConditionVariableSRW(&(p)->c, &(p)->lock, INFINITE, 0)
+#define pool_signal(p,c) WakeConditionVariable(&(p)->c)
+#define pool_broadcast(p,c) WakeAllConditionVariable(&(p)->c)
+#else
+#define pool_lock(p)   pthread_mutex_lock(&(p)->lock)
+#define pool_unlock(p) pthread_mutex_unlock(&(p)->lock)
+#define pool_wait(p,c) pthread_cond_wait(&(p)->c, &(p)->lock)
+#define pool_signal(p,c) pthread_cond_signal(&(p)->c)
+#define pool_broadcast(p,c) pthread_cond_broadcast(&(p)->c)
+#endif
+
+/* takes jobs from the current batch until it is empty, called with the
+   lock held */
+static void pool_work(faad_pool *pool)
+{
+    while (pool->next_job < pool->num_jobs)
+    {
+        faad_job_func job = pool->job;
+        void *data = pool->data;
+        unsigned long index = pool->next_job++;
+
+        pool_unlock(pool);
+        job(data, index);
+        pool_lock(pool);
+
+        if (--pool->jobs_left == 0)
+            pool_signal(pool, done);
+    }
+}
+
+#if defined(_WIN32)
+static unsigned __stdcall pool_thread(void *arg)
+#else
+static void *pool_thread(void *arg)
+#endif
+{
+    faad_pool *pool = (faad_pool*)arg;
+
+    pool_lock(pool);
+    while (!pool->quit)
+    {
+        if (pool->next_job < pool->num_jobs)
+            pool_work(pool);
+        else
+            pool_wait(pool, wake);
+    }
+    pool_unlock(pool);
+
+    return 0;
+}
+
+faad_pool *faad_pool_create(unsigned int num_threads)
+{
+    unsigned int i;
+    faad_pool *pool = (faad_pool*)faad_malloc(sizeof(faad_pool));
+    if (pool == NULL)
+        return NULL;
+
+    memset(pool, 0, sizeof(faad_pool));
+#if defined(_WIN32)
+    InitializeSRWLock(&pool->lock);
+    InitializeConditionVariable(&pool->wake);
+    InitializeConditionVariable(&pool->done);
+    pool->threads = (HANDLE*)faad_malloc(num_threads*sizeof(HANDLE));
+#else
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->threads = (pthread_t*)faad_malloc(num_threads*sizeof(pthread_t));
+#endif
+    if (pool->threads == NULL)
+    {
+        faad_pool_destroy(pool);
+        return NULL;
+    }
+
+    for (i = 0; i < num_threads; i++)
+    {
+#if defined(_WIN32)
+        pool->threads[i] = (HANDLE)_beginthreadex(NULL, 0, pool_thread, pool, 0, NULL);
+        if (pool->threads[i] == 0)
+            break;
+#else
+        if (pthread_create(&pool->threads[i], NULL, pool_thread, pool) != 0)
+            break;
+#endif
+        pool->num_threads++;
+    }
+    if (pool->num_threads == 0)
+    {
+        faad_pool_destroy(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void faad_pool_start(faad_pool *pool, faad_job_func job, void *data,
+                     unsigned long num_jobs)
+{
+    unsigned long i;
+
+    if (pool == NULL)
+    {
+        for (i = 0; i < num_jobs; i++)
+            job(data, i);
+        return;
+    }
+
+    pool_lock(pool);
+    pool->job = job;
+    pool->data = data;
+    pool->num_jobs = num_jobs;
+    pool->next_job = 0;
+    pool->jobs_left = num_jobs;
+    pool_broadcast(pool, wake);
+    pool_unlock(pool);
+}
+
+void faad_pool_wait(faad_pool *pool)
+{
+    if (pool == NULL)
+        return;
+
+    /* help with jobs nobody has picked up yet */
+    pool_lock(pool);
+    pool_work(pool);
+    while (pool->jobs_left > 0)
+        pool_wait(pool, done);
+    pool_unlock(pool);
+}
+
+void faad_pool_run(faad_pool *pool, faad_job_func job, void *data,
+                   unsigned long num_jobs)
+{
+    faad_pool_start(pool, job, data, num_jobs);
+    faad_pool_wait(pool);
+}
+
+void faad_pool_destroy(faad_pool *pool)
+{
+    unsigned int i;
+
+    if (pool == NULL)
+        return;
+
+    pool_lock(pool);
+    pool->quit = 1;
+    pool_broadcast(pool, wake);
+    pool_unlock(pool);
+
+    for (i = 0; i < pool->num_threads; i++)
+    {
+#if defined(_WIN32)
+        WaitForSingleObject(pool->threads[i], INFINITE);
+        CloseHandle(pool->threads[i]);
+#else
+        pthread_join(pool->threads[i], NULL);
+#endif
+    }
+
+#if !defined(_WIN32)
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+#endif
+    faad_free(pool->threads);
+    faad_free(pool);
+}
+
+#else
+
+faad_pool *faad_pool_create(unsigned int num_threads)
+{
+    (void)num_threads;
+    return NULL;
+}
+
+void faad_pool_start(faad_pool *pool, faad_job_func job, void *data,
+                     unsigned long num_jobs)
+{
+    unsigned long i;
+
+    (void)pool;
+    for (i = 0; i < num_jobs; i++)
+        job(data, i);
+}
+
+void faad_pool_wait(faad_pool *pool)
+{
+    (void)pool;
+}
+
+void faad_pool_run(faad_pool *pool, faad_job_func job, void *data,
+                   unsigned long num_jobs)
+{
+    faad_pool_start(pool, job, data, num_jobs);
+}
+
+void faad_pool_destroy(faad_pool *pool)
+{
+    (void)pool;
+}
+
+#endif
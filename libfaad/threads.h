@@ -0,0 +1,76 @@
+/*
+** FAAD2 - Freeware Advanced Audio (AAC) Decoder including SBR decoding
+** Copyright (C) 2003-2005 M. Bakker, Nero AG, http://www.nero.com
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**
+** Any non-GPL usage of this software or parts of this software is strictly
+** forbidden.
+**
+** The "appropriate copyright message" mentioned in section 2c of the GPLv2
+** must read: "Code from FAAD2 is copyright (c) Nero AG, www.nero.com"
+**
+** Commercial non-GPL licensing of this software is possible.
+** For more info contact Nero AG through Mpeg4AAClicense@nero.com.
+**
+** $Id$
+**/
+
+#ifndef __THREADS_H__
+#define __THREADS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* minimal threading primitives, without thread support locking is a no-op */
+#if defined(_WIN32)
+/* SRWLOCK, kept opaque so windows.h stays out of the decoder sources */
+typedef struct { void *ptr; } faad_mutex;
+#define FAAD_MUTEX_INITIALIZER { 0 }
+#elif defined(HAVE_PTHREAD_H)
+#include <pthread.h>
+typedef pthread_mutex_t faad_mutex;
+#define FAAD_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+#else
+typedef int faad_mutex;
+#define FAAD_MUTEX_INITIALIZER 0
+#endif
+
+void faad_mutex_lock(faad_mutex *mutex);
+void faad_mutex_unlock(faad_mutex *mutex);
+
+/* pool of worker threads running batches of independent jobs */
+typedef void (*faad_job_func)(void *data, unsigned long index);
+typedef struct faad_pool faad_pool;
+
+/* returns NULL when threads are not supported */
+faad_pool *faad_pool_create(unsigned int num_threads);
+/* runs job(data, 0..num_jobs-1), the calling thread takes part and
+   returns when all jobs are done; without a pool the jobs run in order */
+void faad_pool_run(faad_pool *pool, faad_job_func job, void *data,
+                   unsigned long num_jobs);
+/* the two halves of faad_pool_run(), for work that overlaps with the
+   calling thread; a batch has to be waited for before the next start */
+void faad_pool_start(faad_pool *pool, faad_job_func job, void *data,
+                     unsigned long num_jobs);
+void faad_pool_wait(faad_pool *pool);
+void faad_pool_destroy(faad_pool *pool);
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif